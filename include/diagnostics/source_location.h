@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace cimple {
+namespace diagnostics {
+
+// ---------------------------------------------------------------------------
+// Source positions.
+//
+// Tokens and AST nodes record a position as a 32-bit byte offset into the
+// source buffer. A LineTable turns an offset into the line and column shown
+// in diagnostics, so nothing pays for line/column bookkeeping until a
+// diagnostic is actually reported.
+// ---------------------------------------------------------------------------
+
+using SourceOffset = std::uint32_t;
+
+// Offsets are 32-bit, so a source may be at most this large.
+inline constexpr std::uint64_t kMaxSourceBytes = UINT32_MAX;
+
+// Columns a tab advances (tabs are not aligned to tab stops). The lexer
+// measures indentation with the same width.
+inline constexpr int kTabWidth = 4;
+
+// Location in source (1-based). {0, 0} means "unknown".
+struct SourceLocation {
+  int line = 1;
+  int column = 1;
+
+  SourceLocation() = default;
+  SourceLocation(int l, int c) : line(l), column(c) {}
+};
+
+// Offset -> line:column lookups for one source buffer, which must outlive
+// the table. The line-start index is built by the first lookup (one scan of
+// the source); later lookups are a binary search plus a scan of the line's
+// prefix for tabs. Not thread-safe.
+class LineTable {
+public:
+  explicit LineTable(std::string_view source) : source_(source) {}
+
+  // Line and column of the byte at `offset`. Offsets past the end of the
+  // source are clamped to the end.
+  SourceLocation locate(SourceOffset offset) const;
+
+private:
+  void build() const;
+
+  std::string_view source_;
+  mutable std::vector<SourceOffset> line_starts_; // empty until build()
+};
+
+} // namespace diagnostics
+} // namespace cimple
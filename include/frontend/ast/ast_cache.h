@@ -0,0 +1,65 @@
+#pragma once
+#include "../parser/parser.h"
+#include "../semantic/type_infer.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace cimple {
+namespace ast {
+
+// ---------------------------------------------------------------------------
+// Binary AST cache (.cimpc files).
+//
+// A parsed module can be saved beside its source as <file>.cimpc and loaded
+// on a later run instead of lexing and parsing again. The file holds the
+// module's flat form (flat_ast.h), the names of the symbols it mentions, and
+// optionally the TypeEnv inferred for it.
+//
+// Layout: a fixed Header followed by a payload of count-prefixed arrays of
+// fixed-width values in host byte order, each starting on an 8-byte
+// boundary, so a mapped file can be read in place. The header records what
+// the cache was built from: a CacheKey, the cache format and the compiler
+// version. A file whose header does not match, or whose payload fails its
+// hash or structural checks, is ignored (and overwritten by the next save).
+// ---------------------------------------------------------------------------
+
+// What a cached module was built from, besides the compiler itself.
+struct CacheKey {
+  std::uint64_t source_hash = 0;
+  std::uint64_t source_size = 0;
+  std::uint64_t options_hash = 0;
+
+  bool operator==(const CacheKey &o) const {
+    return source_hash == o.source_hash && source_size == o.source_size &&
+           options_hash == o.options_hash;
+  }
+};
+
+// Key for `source` compiled with front-end `options`: any string naming the
+// settings that change the AST or its inferred types.
+CacheKey make_cache_key(std::string_view source, std::string_view options);
+
+// Where the cache for `source_path` lives: the path with "c" appended
+// (hello.cimp -> hello.cimpc).
+std::string cache_path(const std::string &source_path);
+
+struct CachedModule {
+  parser::Module module;
+  std::optional<semantic::TypeEnv> types; // if saved with types
+};
+
+// The module cached at `path`, or std::nullopt if there is no usable cache
+// for `key`.
+std::optional<CachedModule> load_cached_module(const std::string &path,
+                                               const CacheKey &key);
+
+// Write `module`, and `types` if given, to `path`. Returns false if the file
+// cannot be written.
+bool save_cached_module(const std::string &path, const CacheKey &key,
+                        const parser::Module &module,
+                        const semantic::TypeEnv *types = nullptr);
+
+} // namespace ast
+} // namespace cimple
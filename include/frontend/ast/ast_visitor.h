@@ -0,0 +1,162 @@
+#pragma once
+#include "../parser/parser.h"
+#include <utility>
+
+namespace cimple {
+namespace ast {
+
+using parser::NodeKind;
+
+// Spelling of a node kind ("BinaryOp"), for diagnostics.
+const char *node_kind_name(NodeKind kind);
+
+// Report a node a dispatch switch does not handle, then abort. Only reachable
+// if a new NodeKind is added without updating the visitors.
+[[noreturn]] void unhandled_node(const parser::Node *node);
+
+// ---------------------------------------------------------------------------
+// Kind-switch visitors (CRTP).
+//
+// visit() dispatches on Node::kind with one switch and calls the derived
+// class's visit_<node>() with the node already downcast, forwarding any extra
+// `Args`. Calls resolve statically, so a visit costs one indirect jump rather
+// than a chain of RTTI checks. Passes that keep their logic in a single
+// function switch on `kind` directly and use parser::cast<T>.
+// ---------------------------------------------------------------------------
+
+template <typename Derived, typename R = void, typename... Args>
+class ExprVisitor {
+public:
+  R visit(const parser::Expr *e, Args... args) {
+    using namespace parser;
+    Derived &self = static_cast<Derived &>(*this);
+    switch (e->kind) {
+    case NodeKind::NumberLiteral:
+      return self.visit_number(cast<NumberLiteral>(e),
+                               std::forward<Args>(args)...);
+    case NodeKind::StringLiteral:
+      return self.visit_string(cast<StringLiteral>(e),
+                               std::forward<Args>(args)...);
+    case NodeKind::BoolLiteral:
+      return self.visit_bool(cast<BoolLiteral>(e), std::forward<Args>(args)...);
+    case NodeKind::VarRef:
+      return self.visit_var(cast<VarRef>(e), std::forward<Args>(args)...);
+    case NodeKind::CallExpr:
+      return self.visit_call(cast<CallExpr>(e), std::forward<Args>(args)...);
+    case NodeKind::BinaryOp:
+      return self.visit_binary(cast<BinaryOp>(e), std::forward<Args>(args)...);
+    case NodeKind::UnaryOp:
+      return self.visit_unary(cast<UnaryOp>(e), std::forward<Args>(args)...);
+    case NodeKind::LogicalExpr:
+      return self.visit_logical(cast<LogicalExpr>(e),
+                                std::forward<Args>(args)...);
+    case NodeKind::CompareChain:
+      return self.visit_compare(cast<CompareChain>(e),
+                                std::forward<Args>(args)...);
+    default:
+      unhandled_node(e);
+    }
+  }
+};
+
+template <typename Derived, typename R = void, typename... Args>
+class StmtVisitor {
+public:
+  R visit(const parser::Stmt *s, Args... args) {
+    using namespace parser;
+    Derived &self = static_cast<Derived &>(*this);
+    switch (s->kind) {
+    case NodeKind::ExprStmt:
+      return self.visit_expr_stmt(cast<ExprStmt>(s),
+                                  std::forward<Args>(args)...);
+    case NodeKind::AssignStmt:
+      return self.visit_assign(cast<AssignStmt>(s),
+                               std::forward<Args>(args)...);
+    case NodeKind::ReturnStmt:
+      return self.visit_return(cast<ReturnStmt>(s),
+                               std::forward<Args>(args)...);
+    case NodeKind::FuncDef:
+      return self.visit_func_def(cast<FuncDef>(s),
+                                 std::forward<Args>(args)...);
+    case NodeKind::IfStmt:
+      return self.visit_if(cast<IfStmt>(s), std::forward<Args>(args)...);
+    case NodeKind::WhileStmt:
+      return self.visit_while(cast<WhileStmt>(s), std::forward<Args>(args)...);
+    case NodeKind::BreakStmt:
+      return self.visit_break(cast<BreakStmt>(s), std::forward<Args>(args)...);
+    case NodeKind::ContinueStmt:
+      return self.visit_continue(cast<ContinueStmt>(s),
+                                 std::forward<Args>(args)...);
+    default:
+      unhandled_node(s);
+    }
+  }
+};
+
+// ---------------------------------------------------------------------------
+// Whole-tree walk. Every visit_<node>() defaults to walking the node's
+// children in source order; a pass overrides (hides) the hooks it cares about
+// and calls walk() for the children it still wants visited. Null children
+// (an else branch's condition, a bare `return`) are skipped.
+// ---------------------------------------------------------------------------
+
+template <typename Derived>
+class RecursiveVisitor : public ExprVisitor<Derived>,
+                         public StmtVisitor<Derived> {
+public:
+  void walk(const parser::Expr *e) {
+    if (e)
+      ExprVisitor<Derived>::visit(e);
+  }
+  void walk(const parser::Stmt *s) {
+    if (s)
+      StmtVisitor<Derived>::visit(s);
+  }
+  void walk(const parser::StmtList &body) {
+    for (const parser::Stmt *s : body)
+      walk(s);
+  }
+
+  void visit_number(const parser::NumberLiteral *) {}
+  void visit_string(const parser::StringLiteral *) {}
+  void visit_bool(const parser::BoolLiteral *) {}
+  void visit_var(const parser::VarRef *) {}
+  void visit_call(const parser::CallExpr *c) {
+    walk(c->callee);
+    for (const parser::Expr *arg : c->args)
+      walk(arg);
+  }
+  void visit_binary(const parser::BinaryOp *b) {
+    walk(b->left);
+    walk(b->right);
+  }
+  void visit_unary(const parser::UnaryOp *u) { walk(u->operand); }
+  void visit_logical(const parser::LogicalExpr *l) {
+    walk(l->left);
+    walk(l->right);
+  }
+  void visit_compare(const parser::CompareChain *c) {
+    for (const parser::Expr *operand : c->operands)
+      walk(operand);
+  }
+
+  void visit_expr_stmt(const parser::ExprStmt *s) { walk(s->expr); }
+  void visit_assign(const parser::AssignStmt *s) { walk(s->value); }
+  void visit_return(const parser::ReturnStmt *s) { walk(s->value); }
+  void visit_func_def(const parser::FuncDef *s) { walk(s->body); }
+  void visit_if(const parser::IfStmt *s) {
+    for (const parser::IfBranch &branch : s->branches) {
+      walk(branch.condition);
+      walk(branch.body);
+    }
+  }
+  void visit_while(const parser::WhileStmt *s) {
+    walk(s->condition);
+    walk(s->body);
+  }
+  void visit_break(const parser::BreakStmt *) {}
+  void visit_continue(const parser::ContinueStmt *) {}
+};
+
+} // namespace ast
+} // namespace cimple
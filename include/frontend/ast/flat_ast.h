@@ -0,0 +1,212 @@
+#pragma once
+#include "../parser/parser.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace cimple {
+namespace ast {
+
+using parser::NodeKind;
+
+// ---------------------------------------------------------------------------
+// Flat, index-based AST (structure of arrays).
+//
+// The pointer tree in parser.h spreads a module's nodes over the arena, and
+// a pass follows one pointer per child. A FlatAst holds the same module as
+// parallel columns indexed by a 32-bit NodeId, one row per node, so passes
+// that need only kinds, operators and child links read a few dense arrays.
+//
+// Rows are appended in post-order: every node follows its children, and an
+// expression's subtree is the contiguous row range [first[n], n]. A
+// bottom-up property of an expression (its type, say) is then one forward
+// loop over that range, without recursion.
+//
+// What `a` and `b` hold depends on the kind. Child lists of any length
+// (arguments, blocks, parameters, if branches, chained comparison operators)
+// live in `lists` as a count followed by the items; the row holds the
+// list's offset.
+//
+//   NumberLiteral  op: Kind (+ kOutOfRange)  a: ints/floats index  b: text
+//   StringLiteral  b: text index (quotes included)
+//   BoolLiteral    op: value
+//   VarRef         a: SymbolId
+//   CallExpr       a: callee                 b: argument list
+//   BinaryOp       op: BinOpKind             a: left   b: right
+//   LogicalExpr    op: BinOpKind (And/Or)    a: left   b: right
+//   UnaryOp        op: UnOpKind              a: operand
+//   CompareChain   a: operand list           b: BinOpKind list
+//   ExprStmt       a: expression
+//   AssignStmt     a: target SymbolId        b: value
+//   ReturnStmt     a: value or kNoNode
+//   FuncDef        a: name SymbolId          b: parameter list, followed
+//                                               directly by the body list
+//   IfStmt         a: condition list (kNoNode for else)  b: list of bodies
+//   WhileStmt      a: condition              b: body list
+//
+// A FlatAst borrows literal text from the Module it was built from, which
+// must outlive it.
+// ---------------------------------------------------------------------------
+
+using NodeId = std::uint32_t;
+inline constexpr NodeId kNoNode = ~NodeId(0);
+
+// NumberLiteral flag in `op`, above the NumberLiteral::Kind bit.
+inline constexpr std::uint8_t kOutOfRange = 0x2;
+
+// A count-prefixed run of `lists`: node ids, SymbolIds, operator tags or
+// (for if bodies) list offsets.
+class ListRef {
+public:
+  ListRef() = default;
+  explicit ListRef(const std::uint32_t *head)
+      : items_(head + 1), size_(*head) {}
+
+  const std::uint32_t *begin() const { return items_; }
+  const std::uint32_t *end() const { return items_ + size_; }
+  std::uint32_t operator[](std::size_t i) const { return items_[i]; }
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+private:
+  const std::uint32_t *items_ = nullptr;
+  std::uint32_t size_ = 0;
+};
+
+class FlatAst;
+
+// Handle to one row: a FlatAst and a NodeId, passed by value. Accessors are
+// valid only for the kinds named in the table above.
+class NodeRef {
+public:
+  NodeRef(const FlatAst &ast, NodeId id) : ast_(&ast), id_(id) {}
+
+  NodeId id() const { return id_; }
+  explicit operator bool() const { return id_ != kNoNode; }
+
+  inline NodeKind kind() const;
+  inline NodeId first() const;
+  inline lexer::SourceOffset offset() const;
+
+  // Operators and literal payloads.
+  inline parser::BinOpKind bin_op() const;
+  inline parser::UnOpKind un_op() const;
+  inline bool bool_value() const;
+  inline bool is_float() const;
+  inline bool in_range() const;
+  inline std::int64_t int_value() const;
+  inline double float_value() const;
+  inline std::string_view text() const;
+  inline lexer::SymbolId symbol() const; // VarRef, AssignStmt, FuncDef
+
+  // Children.
+  inline NodeRef left() const;    // BinaryOp, LogicalExpr
+  inline NodeRef right() const;   // BinaryOp, LogicalExpr
+  inline NodeRef operand() const; // UnaryOp
+  inline NodeRef callee() const;
+  inline ListRef args() const;
+  inline ListRef operands() const;  // CompareChain
+  inline ListRef chain_ops() const; // CompareChain, BinOpKind values
+  inline NodeRef expr() const;      // ExprStmt
+  inline NodeRef value() const;     // AssignStmt, ReturnStmt
+  inline NodeRef condition() const; // WhileStmt
+  inline ListRef params() const;    // FuncDef, SymbolIds
+  inline ListRef body() const;      // FuncDef, WhileStmt
+  inline ListRef conditions() const; // IfStmt
+  inline ListRef bodies() const;     // IfStmt, list offsets
+  inline ListRef list(std::uint32_t offset) const;
+
+  NodeRef node(NodeId id) const { return NodeRef(*ast_, id); }
+
+private:
+  const FlatAst *ast_;
+  NodeId id_;
+};
+
+class FlatAst {
+public:
+  // Columns, one entry per row.
+  std::vector<NodeKind> kind;
+  std::vector<std::uint8_t> op;
+  std::vector<std::uint32_t> a;
+  std::vector<std::uint32_t> b;
+  std::vector<NodeId> first; // first row of the node's subtree
+  std::vector<lexer::SourceOffset> offset; // Node::offset
+
+  std::vector<std::uint32_t> lists;
+  std::vector<std::int64_t> ints;
+  std::vector<double> floats;
+  std::vector<std::string_view> text;
+
+  std::uint32_t module_body = 0; // offset of the top-level statement list
+
+  std::size_t size() const { return kind.size(); }
+  NodeRef node(NodeId id) const { return NodeRef(*this, id); }
+  ListRef list(std::uint32_t offset) const {
+    return ListRef(lists.data() + offset);
+  }
+  ListRef body() const { return list(module_body); }
+
+  // Bytes held by the columns and side tables (not counting borrowed text).
+  std::size_t bytes() const;
+};
+
+// Build the flat form of `module`.
+FlatAst flatten(const parser::Module &module);
+
+// Rebuild a pointer-tree Module from its flat form (the inverse of flatten,
+// up to null statements, which flatten drops). Literal text is copied into
+// the module's arena, so the result does not borrow from `ast`.
+parser::Module unflatten(const FlatAst &ast);
+
+// ---------------------------------------------------------------------------
+// NodeRef accessors
+// ---------------------------------------------------------------------------
+
+NodeKind NodeRef::kind() const { return ast_->kind[id_]; }
+NodeId NodeRef::first() const { return ast_->first[id_]; }
+lexer::SourceOffset NodeRef::offset() const { return ast_->offset[id_]; }
+
+parser::BinOpKind NodeRef::bin_op() const {
+  return static_cast<parser::BinOpKind>(ast_->op[id_]);
+}
+parser::UnOpKind NodeRef::un_op() const {
+  return static_cast<parser::UnOpKind>(ast_->op[id_]);
+}
+bool NodeRef::bool_value() const { return ast_->op[id_] != 0; }
+bool NodeRef::is_float() const {
+  return (ast_->op[id_] & 1) == parser::NumberLiteral::Float;
+}
+bool NodeRef::in_range() const { return !(ast_->op[id_] & kOutOfRange); }
+std::int64_t NodeRef::int_value() const { return ast_->ints[ast_->a[id_]]; }
+double NodeRef::float_value() const { return ast_->floats[ast_->a[id_]]; }
+std::string_view NodeRef::text() const { return ast_->text[ast_->b[id_]]; }
+lexer::SymbolId NodeRef::symbol() const { return ast_->a[id_]; }
+
+NodeRef NodeRef::left() const { return node(ast_->a[id_]); }
+NodeRef NodeRef::right() const { return node(ast_->b[id_]); }
+NodeRef NodeRef::operand() const { return node(ast_->a[id_]); }
+NodeRef NodeRef::callee() const { return node(ast_->a[id_]); }
+ListRef NodeRef::args() const { return list(ast_->b[id_]); }
+ListRef NodeRef::operands() const { return list(ast_->a[id_]); }
+ListRef NodeRef::chain_ops() const { return list(ast_->b[id_]); }
+NodeRef NodeRef::expr() const { return node(ast_->a[id_]); }
+NodeRef NodeRef::value() const {
+  return node(kind() == NodeKind::AssignStmt ? ast_->b[id_] : ast_->a[id_]);
+}
+NodeRef NodeRef::condition() const { return node(ast_->a[id_]); }
+ListRef NodeRef::params() const { return list(ast_->b[id_]); }
+ListRef NodeRef::body() const {
+  if (kind() == NodeKind::FuncDef)
+    return list(ast_->b[id_] + 1 + ast_->lists[ast_->b[id_]]);
+  return list(ast_->b[id_]);
+}
+ListRef NodeRef::conditions() const { return list(ast_->a[id_]); }
+ListRef NodeRef::bodies() const { return list(ast_->b[id_]); }
+ListRef NodeRef::list(std::uint32_t offset) const {
+  return ast_->list(offset);
+}
+
+} // namespace ast
+} // namespace cimple
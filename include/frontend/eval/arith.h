@@ -0,0 +1,83 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+namespace cimple {
+namespace eval {
+
+// ---------------------------------------------------------------------------
+// Numeric kernels for the operators whose Python semantics differ from C++'s
+// (floor division, modulo, powers, shifts). The evaluator and the VM both
+// call these, so the two engines cannot drift apart. Integer results wrap on
+// overflow rather than being undefined.
+//
+// Callers report a zero divisor, `0 ** negative` and a negative shift count
+// themselves; the kernels assume those were ruled out.
+// ---------------------------------------------------------------------------
+
+inline long long wrap_int(std::uint64_t v) { return static_cast<long long>(v); }
+
+// a // b: the quotient rounded toward negative infinity.
+inline long long int_floor_div(long long a, long long b) {
+  if (b == -1)
+    return wrap_int(0 - static_cast<std::uint64_t>(a));
+  long long q = a / b;
+  if (a % b != 0 && (a < 0) != (b < 0))
+    --q;
+  return q;
+}
+
+// a % b: the remainder takes the sign of the divisor.
+inline long long int_mod(long long a, long long b) {
+  if (b == -1)
+    return 0;
+  long long r = a % b;
+  if (r != 0 && (r < 0) != (b < 0))
+    r += b;
+  return r;
+}
+
+// a // b, as CPython computes it: from the exact remainder rather than the
+// rounded quotient a / b, so that a == (a // b) * b + a % b holds.
+inline double float_floor_div(double a, double b) {
+  const double mod = std::fmod(a, b);
+  double div = (a - mod) / b;
+  if (mod != 0.0 && (mod < 0.0) != (b < 0.0))
+    div -= 1.0;
+  if (div == 0.0)
+    return std::copysign(0.0, a / b);
+  const double floored = std::floor(div);
+  return div - floored > 0.5 ? floored + 1.0 : floored;
+}
+
+inline double float_mod(double a, double b) {
+  double r = std::fmod(a, b);
+  if (r != 0.0 && (r < 0.0) != (b < 0.0))
+    r += b;
+  return r;
+}
+
+// base ** exp for exp >= 0, by repeated squaring.
+inline long long int_pow(long long base, long long exp) {
+  std::uint64_t result = 1;
+  auto b = static_cast<std::uint64_t>(base);
+  for (auto e = static_cast<std::uint64_t>(exp); e != 0; e >>= 1) {
+    if (e & 1)
+      result *= b;
+    b *= b;
+  }
+  return wrap_int(result);
+}
+
+// Shifts for n >= 0; shifting out every bit gives 0 (or -1 for a negative
+// value shifted right), as with Python's unbounded integers.
+inline long long int_shl(long long a, long long n) {
+  return n >= 64 ? 0 : wrap_int(static_cast<std::uint64_t>(a) << n);
+}
+
+inline long long int_shr(long long a, long long n) {
+  return n >= 64 ? (a < 0 ? -1 : 0) : a >> n;
+}
+
+} // namespace eval
+} // namespace cimple
@@ -0,0 +1,158 @@
+#pragma once
+#include "evaluator.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cimple {
+namespace eval {
+
+// ---------------------------------------------------------------------------
+// Register bytecode for `cimple run`.
+//
+// Every function (and the module body, compiled as an implicit `<main>`
+// function) owns a window of registers. The low registers are the variable
+// slots assigned by semantic::resolve_names, temporaries sit above them.
+// `<main>`'s window starts at register 0, so its function-scope slots double
+// as the globals (`G`). Operands named `a`, `b`, `c` are register numbers
+// unless noted otherwise; `bx` is the 32-bit immediate formed from `b` and
+// `c` (constant index, global index or jump target).
+//
+// A register holding Value::Unknown models the evaluator's `nullopt`: it is
+// produced by failed operations and poisons whatever consumes it.
+// ---------------------------------------------------------------------------
+enum class OpCode : std::uint8_t {
+  LoadK,     // R[a] = K[bx]
+  LoadNil,   // R[a] = <unset>
+  LoadBool,  // R[a] = (n != 0)
+  Move,          // R[a] = R[b]
+  SetLocal,      // R[a] = R[b], skipped when R[b] is unset (assignment)
+  GetGlobal,     // R[a] = G[bx]
+  InheritGlobal, // if R[a] is unset: R[a] = G[bx]
+
+  Add, // R[a] = R[b] + R[c]
+  Sub,
+  Mul,
+  Div,
+  FloorDiv, // R[a] = R[b] // R[c]
+  Mod,
+  Pow,
+  BitAnd, // R[a] = R[b] & R[c] (integers only)
+  BitOr,
+  BitXor,
+  Shl,
+  Shr,
+  Eq,
+  Ne,
+  Lt,
+  Gt,
+  Le,
+  Ge,
+  Neg,    // R[a] = -R[b]
+  Not,    // R[a] = not R[b]
+  BitNot, // R[a] = ~R[b]
+  ToBool, // R[a] = truthy(R[b]) (unset stays unset)
+
+  Jmp,        // pc = bx
+  JmpIfFalse, // if R[a] is unset or falsy: pc = bx
+  JmpIfTrue,  // if R[a] is set and truthy: pc = bx
+  JmpIfUnset, // if R[a] is unset: pc = bx
+
+  Call,   // R[a] = functions[b](R[c] .. R[c + n - 1]); the callee's window
+          // starts at R[c], so arguments land in its parameter slots
+  Print,   // write R[a] to stdout (nothing when unset)
+  PrintLn, // end the print() line; R[a] = <unset>
+  Ret,    // return R[a]
+  RetNil, // return <unset>
+  Escape, // break/continue escaped a function body: report, return <unset>
+
+  // Superinstructions. The compiler emits these directly:
+  AddLocalK, // R[a] = R[a] + K[bx], skipped when the sum is unset
+  SubLocalK, // R[a] = R[a] - K[bx], likewise
+  // and fuse_superinstructions() makes these from pairs. A fused opcode
+  // replaces the first instruction's and runs both, reading the operands of
+  // the second, which stays in place (a jump may still land on it).
+  LoadKAdd, // LoadK, then the Add after it
+  LoadKSub, // LoadK, then the Sub after it
+  EqJmp,    // Eq, then the JmpIfFalse or JmpIfTrue on its result after it
+  NeJmp,
+  LtJmp,
+  GtJmp,
+  LeJmp,
+  GeJmp,
+
+  // Quickened arithmetic: Add, Sub, Mul or Div for two Ints or two Floats.
+  // The compiler emits these where inferred types predict such operands,
+  // and the VM rewrites a generic instruction into one when it sees them.
+  // Either way it is a guess: the instruction checks its operands, and on
+  // a miss rewrites itself back to the generic opcode and counts the miss
+  // in `n`. After kMaxDeopts misses it stays generic.
+  AddInt,
+  SubInt,
+  MulInt,
+  AddFloat,
+  SubFloat,
+  MulFloat,
+  DivFloat,
+
+  Halt, // last, see kOpCodeCount
+};
+
+constexpr std::size_t kOpCodeCount = static_cast<std::size_t>(OpCode::Halt) + 1;
+
+struct Instr {
+  OpCode op = OpCode::Halt;
+  std::uint8_t n = 0; // small immediate: argument count, boolean
+  std::uint16_t a = 0;
+  std::uint16_t b = 0;
+  std::uint16_t c = 0;
+
+  std::uint32_t bx() const {
+    return (static_cast<std::uint32_t>(b) << 16) | static_cast<std::uint32_t>(c);
+  }
+  void set_bx(std::uint32_t v) {
+    b = static_cast<std::uint16_t>(v >> 16);
+    c = static_cast<std::uint16_t>(v & 0xFFFFu);
+  }
+};
+
+static_assert(sizeof(Instr) == 8, "Instr is expected to pack into 8 bytes");
+
+// One compiled function body.
+struct Function {
+  std::string name;
+  std::uint32_t num_params = 0;
+  std::uint32_t scope_slots = 0; // slots cleared on entry (beyond the args)
+  std::uint32_t num_regs = 0;
+  std::vector<Instr> code;
+  std::vector<Value> constants;
+  std::vector<std::string> slot_names; // for disassembly
+};
+
+// A compiled module: user functions plus the top-level `<main>` body.
+struct Program {
+  std::vector<Function> functions;
+  Function main;
+};
+
+const char *opcode_name(OpCode op);
+
+constexpr std::uint8_t kMaxDeopts = 4;
+
+// The quickened form of generic arithmetic `op` for two operands of kind
+// `kind`, or `op` itself if there is none.
+OpCode quickened_opcode(OpCode op, Value::Kind kind);
+
+// The generic opcode that quickened `op` specializes, or `op` itself.
+OpCode generic_opcode(OpCode op);
+
+// Fuse adjacent instruction pairs of `code` into superinstructions (see
+// OpCode). Addresses do not change, so jump targets stay valid.
+void fuse_superinstructions(std::vector<Instr> &code);
+
+// Human-readable listing of a compiled program (used by `cimple disasm`).
+std::string disassemble(const Program &program);
+
+} // namespace eval
+} // namespace cimple
@@ -0,0 +1,27 @@
+#pragma once
+#include "../parser/parser.h"
+#include "../semantic/type_infer.h"
+#include "bytecode.h"
+#include <optional>
+#include <string>
+
+namespace cimple {
+namespace eval {
+
+// Lower a parsed module to register bytecode.
+//
+// The generated program reproduces the tree-walking evaluator's observable
+// behavior exactly (the evaluator remains the reference oracle). Returns
+// nullopt when the module exceeds the bytecode's encoding limits (register
+// or argument counts) or contains a literal the evaluator would reject at
+// run time; `error` then describes why, and callers should fall back to the
+// tree-walking evaluator.
+//
+// With `types` (from semantic::infer_types), arithmetic on operands inferred
+// to be two Ints or two Floats starts out quickened; see OpCode::AddInt.
+std::optional<Program> compile_program(const parser::Module &module,
+                                       const semantic::TypeEnv *types = nullptr,
+                                       std::string *error = nullptr);
+
+} // namespace eval
+} // namespace cimple
@@ -1,32 +1,37 @@
 #pragma once
 #include "../parser/parser.h"
-#include "../semantic/cimple_var.h"
 #include "../semantic/scope_stack.h"
 #include "../semantic/type_infer.h"
+#include "value.h"
 #include <optional>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 namespace cimple {
 namespace eval {
 
-// Runtime value produced by expression evaluation.
-struct Value {
-  enum Kind { Unknown, Int, Float, String, Bool } kind = Unknown;
-  long long i = 0;
-  double f = 0.0;
-  std::string s;
-  bool b = false;
+// Scoped runtime environment.
+using ValueEnv = semantic::ScopeStack<Value, lexer::SymbolId>;
 
-  std::string to_string() const;
+// Top-level function definitions by name. Indexed directly by the interned
+// SymbolId, so resolving a call is one bounds check and one load.
+class FunctionTable {
+public:
+  // Register `fn`; a later definition of the same name replaces it.
+  void define(parser::FuncDef *fn) {
+    if (fn->name_id >= defs_.size())
+      defs_.resize(fn->name_id + 1, nullptr);
+    defs_[fn->name_id] = fn;
+  }
 
-  // Conversion helpers to/from CimpleVar
-  static Value from_cimple_var(const semantic::CimpleVar &var);
-  semantic::CimpleVar to_cimple_var() const;
-};
+  // The function named `name`, or nullptr.
+  parser::FuncDef *find(lexer::SymbolId name) const {
+    return name < defs_.size() ? defs_[name] : nullptr;
+  }
 
-// Scoped runtime environment.
-using ValueEnv = semantic::ScopeStack<semantic::CimpleVar>;
+private:
+  std::vector<parser::FuncDef *> defs_;
+};
 
 // ---------------------------------------------------------------------------
 // StmtResult: structured control-flow signal from statement evaluation.
@@ -65,14 +70,14 @@ struct StmtResult {
 // Evaluate an expression. Returns nullopt on evaluation error.
 std::optional<Value> evaluate_expr(
     const parser::Expr *expr, const semantic::TypeEnv &tenv, ValueEnv &venv,
-    const std::unordered_map<std::string, parser::FuncDef *> &functions);
+    const FunctionTable &functions);
 
 // Evaluate a statement. Returns a StmtResult signal.
 // Callers must propagate non-Normal results upward unless they handle them
 // (only while-loops handle Break and Continue).
 StmtResult evaluate_stmt(
     const parser::Stmt *stmt, const semantic::TypeEnv &tenv, ValueEnv &venv,
-    const std::unordered_map<std::string, parser::FuncDef *> &functions);
+    const FunctionTable &functions);
 
 } // namespace eval
 } // namespace cimple
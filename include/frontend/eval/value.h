@@ -0,0 +1,159 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+namespace cimple {
+namespace eval {
+
+// ---------------------------------------------------------------------------
+// Value: 16-byte tagged runtime value shared by the evaluator and the VM.
+//
+// Numbers and bools live inline. Strings are immutable: up to
+// `kSmallCapacity` bytes are stored inline, longer ones in a reference-counted
+// heap block, so copying a Value never allocates. Value::Unknown models the
+// evaluator's "no value" (failed operations, missing variables).
+//
+// The interpreter is single-threaded, so the reference count is not atomic.
+// ---------------------------------------------------------------------------
+class Value {
+public:
+  enum Kind : std::uint8_t { Unknown, Int, Float, String, Bool };
+
+  static constexpr std::size_t kSmallCapacity = 14;
+
+  Value() noexcept { std::memset(payload_, 0, sizeof payload_); }
+  Value(const Value &other) noexcept { copy_from(other); }
+  Value(Value &&other) noexcept {
+    std::memcpy(static_cast<void *>(this), &other, sizeof(Value));
+    other.kind_ = Unknown;
+  }
+  Value &operator=(const Value &other) noexcept {
+    if (this != &other) {
+      release();
+      copy_from(other);
+    }
+    return *this;
+  }
+  Value &operator=(Value &&other) noexcept {
+    if (this != &other) {
+      release();
+      std::memcpy(static_cast<void *>(this), &other, sizeof(Value));
+      other.kind_ = Unknown;
+    }
+    return *this;
+  }
+  ~Value() { release(); }
+
+  // Factories
+  static Value integer(long long v) noexcept {
+    Value x;
+    x.kind_ = Int;
+    x.store(v);
+    return x;
+  }
+  static Value floating(double v) noexcept {
+    Value x;
+    x.kind_ = Float;
+    x.store(v);
+    return x;
+  }
+  static Value boolean(bool v) noexcept {
+    Value x;
+    x.kind_ = Bool;
+    x.payload_[0] = v ? 1 : 0;
+    return x;
+  }
+  static Value string(std::string_view s);
+  // Concatenate without materializing an intermediate std::string.
+  static Value concat(std::string_view a, std::string_view b);
+
+  // In-place updates; cheaper than assigning a temporary on hot paths.
+  void reset() noexcept {
+    release();
+    kind_ = Unknown;
+  }
+  void set_int(long long v) noexcept {
+    release();
+    kind_ = Int;
+    store(v);
+  }
+  void set_float(double v) noexcept {
+    release();
+    kind_ = Float;
+    store(v);
+  }
+  void set_bool(bool v) noexcept {
+    release();
+    kind_ = Bool;
+    payload_[0] = v ? 1 : 0;
+  }
+
+  Kind kind() const { return kind_; }
+  bool is_set() const { return kind_ != Unknown; }
+  bool is_number() const { return kind_ == Int || kind_ == Float; }
+
+  long long as_int() const { return load<long long>(); }
+  double as_float() const { return load<double>(); }
+  bool as_bool() const { return payload_[0] != 0; }
+  // Int or Float widened to double.
+  double as_double() const {
+    return kind_ == Int ? static_cast<double>(as_int()) : as_float();
+  }
+  std::string_view str() const {
+    if (aux_ != kHeap)
+      return {payload_, aux_};
+    const HeapString *h = heap();
+    return {h->data, h->size};
+  }
+
+  std::string to_string() const;
+
+private:
+  struct HeapString {
+    std::uint32_t refs;
+    std::uint32_t size;
+    char data[1];
+  };
+
+  // `aux_` holds the inline length of a small string, or kHeap.
+  static constexpr std::uint8_t kHeap = 0xFF;
+
+  alignas(8) char payload_[kSmallCapacity];
+  std::uint8_t aux_ = 0;
+  Kind kind_ = Unknown;
+
+  template <typename T> T load() const {
+    T v;
+    std::memcpy(&v, payload_, sizeof v);
+    return v;
+  }
+  template <typename T> void store(T v) { std::memcpy(payload_, &v, sizeof v); }
+
+  HeapString *heap() const { return load<HeapString *>(); }
+  bool owns_heap() const { return kind_ == String && aux_ == kHeap; }
+
+  // Allocate a string payload of `size` bytes and return where to write it.
+  char *init_string(std::size_t size);
+
+  void copy_from(const Value &other) noexcept {
+    std::memcpy(static_cast<void *>(this), &other, sizeof(Value));
+    if (owns_heap())
+      ++heap()->refs;
+  }
+  void release() noexcept {
+    if (owns_heap() && --heap()->refs == 0)
+      ::operator delete(heap());
+  }
+};
+
+static_assert(sizeof(Value) == 16, "Value should stay two words");
+
+// Writes exactly what `to_string()` returns.
+std::ostream &operator<<(std::ostream &os, const Value &v);
+
+} // namespace eval
+} // namespace cimple
@@ -0,0 +1,38 @@
+#pragma once
+#include "bytecode.h"
+#include <cstddef>
+#include <vector>
+
+namespace cimple {
+namespace eval {
+
+// Register virtual machine executing a compiled Program.
+//
+// Calls do not recurse on the C++ stack: each call pushes a CallFrame and
+// slides the register window, so deeply recursive scripts are bounded by
+// heap rather than native stack size.
+//
+// Running quickens instructions in place (see OpCode::AddInt), so the VM
+// takes the program by non-const reference.
+class VM {
+public:
+  explicit VM(Program &program);
+
+  // Execute `<main>` to completion.
+  void run();
+
+private:
+  struct CallFrame {
+    Function *fn = nullptr;
+    std::size_t pc = 0;         // resume point in `fn->code`
+    std::size_t base = 0;       // first register of this frame
+    std::uint16_t ret_reg = 0;  // caller register receiving the result
+  };
+
+  Program &program_;
+  std::vector<Value> regs_; // `<main>`'s window comes first: regs_[g] = G[g]
+  std::vector<CallFrame> frames_;
+};
+
+} // namespace eval
+} // namespace cimple
@@ -0,0 +1,53 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+namespace cimple {
+namespace lexer {
+
+// ---------------------------------------------------------------------------
+// ASCII character classes for the lexer.
+//
+// A constexpr 256-entry table replaces <cctype>: no locale lookup and no
+// function call per byte. Bytes >= 0x80 belong to no class, matching
+// std::isalpha and friends in the "C" locale.
+// ---------------------------------------------------------------------------
+enum CharClass : std::uint8_t {
+  kClassAlpha = 1 << 0,      // A-Z a-z
+  kClassDigit = 1 << 1,      // 0-9
+  kClassUnderscore = 1 << 2, // _
+  kClassSpace = 1 << 3,      // ' ' '\t' '\r' '\n'
+
+  kClassIdentStart = kClassAlpha | kClassUnderscore,
+  kClassIdent = kClassAlpha | kClassDigit | kClassUnderscore,
+};
+
+constexpr std::array<std::uint8_t, 256> make_char_class_table() {
+  std::array<std::uint8_t, 256> table{};
+  for (int c = 'a'; c <= 'z'; ++c)
+    table[c] |= kClassAlpha;
+  for (int c = 'A'; c <= 'Z'; ++c)
+    table[c] |= kClassAlpha;
+  for (int c = '0'; c <= '9'; ++c)
+    table[c] |= kClassDigit;
+  table['_'] |= kClassUnderscore;
+  table[' '] |= kClassSpace;
+  table['\t'] |= kClassSpace;
+  table['\r'] |= kClassSpace;
+  table['\n'] |= kClassSpace;
+  return table;
+}
+
+inline constexpr std::array<std::uint8_t, 256> kCharClass =
+    make_char_class_table();
+
+constexpr bool char_is(char c, std::uint8_t classes) {
+  return (kCharClass[static_cast<unsigned char>(c)] & classes) != 0;
+}
+
+constexpr bool is_ident_start(char c) { return char_is(c, kClassIdentStart); }
+constexpr bool is_ident_char(char c) { return char_is(c, kClassIdent); }
+constexpr bool is_digit(char c) { return char_is(c, kClassDigit); }
+
+} // namespace lexer
+} // namespace cimple
@@ -0,0 +1,89 @@
+#pragma once
+#include "token.h"
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+
+namespace cimple {
+namespace lexer {
+
+// ---------------------------------------------------------------------------
+// Keyword lookup through a compile-time perfect hash.
+//
+// The hash mixes the first byte, last byte and length; the constants were
+// chosen so the keywords below land in distinct slots of a 64-entry table,
+// which the static_assert re-checks whenever the list changes. A lookup is
+// one hash, one load and one string compare, and never touches the symbol
+// table.
+// ---------------------------------------------------------------------------
+struct KeywordEntry {
+  std::string_view name;
+  TokenKind kind = TokenKind::None;
+};
+
+inline constexpr KeywordEntry kKeywords[] = {
+    {"def", TokenKind::KW_DEF},           {"return", TokenKind::KW_RETURN},
+    {"if", TokenKind::KW_IF},             {"elif", TokenKind::KW_ELIF},
+    {"else", TokenKind::KW_ELSE},         {"for", TokenKind::KW_FOR},
+    {"while", TokenKind::KW_WHILE},       {"in", TokenKind::KW_IN},
+    {"import", TokenKind::KW_IMPORT},     {"from", TokenKind::KW_FROM},
+    {"as", TokenKind::KW_AS},             {"pass", TokenKind::KW_PASS},
+    {"break", TokenKind::KW_BREAK},       {"continue", TokenKind::KW_CONTINUE},
+    {"class", TokenKind::KW_CLASS},       {"and", TokenKind::KW_AND},
+    {"or", TokenKind::KW_OR},             {"not", TokenKind::KW_NOT},
+    {"True", TokenKind::KW_TRUE},         {"False", TokenKind::KW_FALSE},
+    {"None", TokenKind::KW_NONE},
+};
+
+constexpr std::size_t kKeywordTableSize = 64;
+
+// `s` must be non-empty.
+constexpr std::size_t keyword_hash(std::string_view s) {
+  return (static_cast<unsigned char>(s.front()) +
+          static_cast<unsigned char>(s.back()) * 23u + s.size()) &
+         (kKeywordTableSize - 1);
+}
+
+constexpr std::array<KeywordEntry, kKeywordTableSize> make_keyword_table() {
+  std::array<KeywordEntry, kKeywordTableSize> table{};
+  for (const KeywordEntry &kw : kKeywords)
+    table[keyword_hash(kw.name)] = kw;
+  return table;
+}
+
+inline constexpr std::array<KeywordEntry, kKeywordTableSize> kKeywordTable =
+    make_keyword_table();
+
+constexpr bool keyword_hash_is_perfect() {
+  for (const KeywordEntry &kw : kKeywords)
+    if (kKeywordTable[keyword_hash(kw.name)].kind != kw.kind)
+      return false;
+  return true;
+}
+
+static_assert(keyword_hash_is_perfect(),
+              "keyword hash collides; pick new constants for keyword_hash");
+
+// The table entry for `s`, or nullptr when `s` is not a keyword. `s` must be
+// non-empty.
+constexpr const KeywordEntry *find_keyword(std::string_view s) {
+  const KeywordEntry &e = kKeywordTable[keyword_hash(s)];
+  return e.name == s ? &e : nullptr;
+}
+
+// Keyword kinds and keyword symbols are laid out in the same order.
+static_assert(static_cast<SymbolId>(TokenKind::KW_NONE) -
+                      static_cast<SymbolId>(TokenKind::KW_DEF) ==
+                  sym::kw_None - sym::kw_def,
+              "keyword TokenKinds out of sync with the sym enum");
+static_assert(std::size(kKeywords) == sym::kw_None - sym::kw_def + 1,
+              "kKeywords out of sync with the sym enum");
+
+constexpr SymbolId keyword_symbol(TokenKind kind) {
+  return sym::kw_def + (static_cast<SymbolId>(kind) -
+                        static_cast<SymbolId>(TokenKind::KW_DEF));
+}
+
+} // namespace lexer
+} // namespace cimple
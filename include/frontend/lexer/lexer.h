@@ -1,5 +1,6 @@
 #pragma once
 #include "frontend/lexer/token.h"
+#include <cstddef>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -7,12 +8,79 @@
 namespace cimple {
 namespace lexer {
 
-// Tokenize the input source string. Returns a vector of Tokens.
-// Uses std::string_view internally for zero-copy performance.
+struct ScanKernels;
+
+// Pull-based lexer: each next() call scans just far enough to produce one
+// token, so memory use does not grow with the source. Token text and
+// INDENT/DEDENT placement are identical to lex(). The source must outlive
+// the lexer and every token it returns, and may be at most
+// diagnostics::kMaxSourceBytes long (token offsets are 32-bit).
+class Lexer {
+public:
+  explicit Lexer(std::string_view source);
+
+  // The next token. After ENDMARKER, keeps returning ENDMARKER.
+  Token next();
+
+  // Tokens returned so far, up to and including the first ENDMARKER.
+  std::size_t token_count() const { return count_; }
+
+private:
+  // Parallel lexing (see lex_parallel): one chunk of the source and the
+  // tokens lexed from it.
+  struct Chunk;
+  friend std::vector<Token> lex_parallel(std::string_view source,
+                                         unsigned chunks);
+  static void lex_chunk(Chunk *chunk);
+  Lexer(std::string_view source, Chunk &chunk);
+
+  bool start_line();
+  Token scan_token();
+  SourceOffset offset_of(const char *p) const {
+    return static_cast<SourceOffset>(p - source_.data());
+  }
+
+  std::string_view source_;
+  const ScanKernels &scan_;
+  std::size_t line_start_ = 0;
+  std::vector<int> indent_stack_ = {0};
+
+  // Current line, and the scan position within it.
+  std::string_view line_;
+  std::size_t pos_ = 0;
+  bool in_line_ = false;
+
+  // INDENT/DEDENTs owed before the current line's first token.
+  bool pending_indent_ = false;
+  int pending_dedents_ = 0;
+
+  // Chunk mode: identifiers get chunk-local ids, and instead of
+  // INDENT/DEDENT every line starts with an INDENT whose column is the
+  // line's indent width; lex_parallel rebuilds the real ones at the seams.
+  Chunk *chunk_ = nullptr;
+  int line_indent_ = 0;
+
+  std::size_t count_ = 0;
+  bool done_ = false;
+};
+
+// Tokenize the input source string. Returns a vector of Tokens whose
+// lexemes point into `source`, which must outlive them.
 std::vector<Token> lex(const std::string& source);
+std::vector<Token> lex(std::string&&) = delete;
 
-// Internal helper: tokenize from string_view (avoids copies)
+// Tokenize a view without copying it (e.g. a utils::SourceBuffer). The
+// lexemes point into `source`, which must outlive them.
+// Sources of at least kParallelLexMinBytes are lexed by lex_parallel on
+// all hardware threads.
 std::vector<Token> lex_from_view(std::string_view source);
 
+// Split `source` at line boundaries into up to `chunks` pieces, lex them on
+// separate threads and merge the results. The output is token-for-token
+// identical to the sequential lexer, symbol ids included.
+std::vector<Token> lex_parallel(std::string_view source, unsigned chunks);
+
+constexpr std::size_t kParallelLexMinBytes = 8u << 20;
+
 } // namespace lexer
 } // namespace cimple
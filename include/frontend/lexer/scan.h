@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+
+namespace cimple {
+namespace lexer {
+
+// ---------------------------------------------------------------------------
+// Byte-scanning kernels used by the lexer.
+//
+// Each kernel scans `s[pos, len)` and returns the index of the first byte
+// that ends the run, or `len` when the run reaches the end. Vectorized
+// variants (SSE2, AVX2) process 16 or 32 bytes per step and fall back to the
+// scalar loop for the tail; the widest variant the CPU supports is chosen
+// once, at first use.
+// ---------------------------------------------------------------------------
+struct ScanKernels {
+  // First '\n'.
+  std::size_t (*find_newline)(const char *s, std::size_t pos, std::size_t len);
+  // First byte that is not ' '.
+  std::size_t (*skip_spaces)(const char *s, std::size_t pos, std::size_t len);
+  // First byte outside [A-Za-z0-9_].
+  std::size_t (*skip_ident)(const char *s, std::size_t pos, std::size_t len);
+  // First byte outside [0-9].
+  std::size_t (*skip_digits)(const char *s, std::size_t pos, std::size_t len);
+  // First `quote` or '\\' (the end of a string literal's plain run).
+  std::size_t (*find_quote_or_escape)(const char *s, std::size_t pos,
+                                      std::size_t len, char quote);
+  const char *name; // "scalar", "sse2" or "avx2"
+};
+
+// Kernels for the running CPU.
+const ScanKernels &scan_kernels();
+
+namespace detail {
+const ScanKernels &scalar_scan_kernels();
+// nullptr when the build has no such variant (non-x86 targets).
+const ScanKernels *sse2_scan_kernels();
+const ScanKernels *avx2_scan_kernels();
+} // namespace detail
+
+} // namespace lexer
+} // namespace cimple
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace cimple {
+namespace lexer {
+
+// Interned identifier. Equal names share an id, so later phases compare and
+// hash integers instead of strings.
+using SymbolId = std::uint32_t;
+
+constexpr SymbolId kNoSymbol = 0;
+
+// Symbols interned when the table is created, in this order, so their ids
+// are compile-time constants. Keywords form the contiguous range
+// [kw_def, kw_None].
+namespace sym {
+enum : SymbolId {
+  kw_def = 1,
+  kw_return,
+  kw_if,
+  kw_elif,
+  kw_else,
+  kw_for,
+  kw_while,
+  kw_in,
+  kw_import,
+  kw_from,
+  kw_as,
+  kw_pass,
+  kw_break,
+  kw_continue,
+  kw_class,
+  kw_and,
+  kw_or,
+  kw_not,
+  kw_True,
+  kw_False,
+  kw_None,
+  print, // builtin
+  kFirstDynamic
+};
+
+inline bool is_keyword(SymbolId id) { return id >= kw_def && id <= kw_None; }
+} // namespace sym
+
+// Process-wide identifier interner. Names are copied into stable storage on
+// first use; the views handed out stay valid for the life of the process.
+// Not thread-safe.
+class SymbolTable {
+public:
+  static SymbolTable &global();
+
+  SymbolId intern(std::string_view name);
+  // kNoSymbol when `name` was never interned.
+  SymbolId find(std::string_view name) const;
+  std::string_view name(SymbolId id) const { return names_[id]; }
+
+private:
+  SymbolTable();
+
+  std::deque<std::string> storage_; // deque: elements never move
+  std::vector<std::string_view> names_;
+  std::unordered_map<std::string_view, SymbolId> ids_;
+};
+
+inline SymbolId intern(std::string_view name) {
+  return SymbolTable::global().intern(name);
+}
+
+inline std::string_view symbol_name(SymbolId id) {
+  return SymbolTable::global().name(id);
+}
+
+} // namespace lexer
+} // namespace cimple
@@ -1,21 +1,20 @@
 #pragma once
 
+#include "../../diagnostics/source_location.h"
+#include "symbol_table.h"
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace cimple {
 namespace lexer {
 
-// Location in source (1-based)
-struct SourceLocation {
-    int line = 1;
-    int column = 1;
-
-    SourceLocation() = default;
-    SourceLocation(int l, int c) : line(l), column(c) {}
-};
+// Positions are byte offsets; see diagnostics/source_location.h.
+using diagnostics::SourceLocation;
+using diagnostics::SourceOffset;
 
 // Core token kinds. Includes Python-style INDENT/DEDENT support.
-enum class TokenType {
+enum class TokenType : std::uint8_t {
     INDENT,
     DEDENT,
     NEWLINE,
@@ -28,20 +27,117 @@ enum class TokenType {
     COMMENT,
 };
 
-// Token value
+// Subkind of KEYWORD and OP tokens, so the parser branches on an integer
+// instead of comparing lexemes. Keyword kinds follow the order of the `sym`
+// keyword ids (see keywords.h). Every other token has kind None.
+enum class TokenKind : std::uint8_t {
+    None,
+
+    // Keywords
+    KW_DEF,
+    KW_RETURN,
+    KW_IF,
+    KW_ELIF,
+    KW_ELSE,
+    KW_FOR,
+    KW_WHILE,
+    KW_IN,
+    KW_IMPORT,
+    KW_FROM,
+    KW_AS,
+    KW_PASS,
+    KW_BREAK,
+    KW_CONTINUE,
+    KW_CLASS,
+    KW_AND,
+    KW_OR,
+    KW_NOT,
+    KW_TRUE,
+    KW_FALSE,
+    KW_NONE,
+
+    // Punctuation
+    OP_LPAREN,       // (
+    OP_RPAREN,       // )
+    OP_LBRACKET,     // [
+    OP_RBRACKET,     // ]
+    OP_LBRACE,       // {
+    OP_RBRACE,       // }
+    OP_COMMA,        // ,
+    OP_COLON,        // :
+    OP_SEMI,         // ;
+    OP_DOT,          // .
+    OP_AT,           // @
+    OP_ARROW,        // ->
+    OP_COLON_COLON,  // ::
+
+    // Operators
+    OP_ASSIGN,       // =
+    OP_PLUS,         // +
+    OP_MINUS,        // -
+    OP_STAR,         // *
+    OP_SLASH,        // /
+    OP_PERCENT,      // %
+    OP_AMP,          // &
+    OP_PIPE,         // |
+    OP_CARET,        // ^
+    OP_TILDE,        // ~
+    OP_LT,           // <
+    OP_GT,           // >
+    OP_EQ_EQ,        // ==
+    OP_NOT_EQ,       // !=
+    OP_LT_EQ,        // <=
+    OP_GT_EQ,        // >=
+    OP_PLUS_EQ,      // +=
+    OP_MINUS_EQ,     // -=
+    OP_STAR_EQ,      // *=
+    OP_SLASH_EQ,     // /=
+    OP_SLASH_SLASH,  // //
+    OP_STAR_STAR,    // **
+    OP_LSHIFT,       // <<
+    OP_RSHIFT,       // >>
+
+    OP_OTHER,        // any other single character
+};
+
+// Token value. The lexeme borrows from the source buffer passed to the
+// lexer, so tokens must not outlive that buffer. IDENT and KEYWORD tokens
+// carry their interned symbol, and their lexeme is a static spelling (symbol
+// or keyword table) instead. `offset` is the byte offset of the token's
+// first character; INDENT and DEDENT sit at the start of their line,
+// NEWLINE at the end of its line, ENDMARKER at the end of the source.
+//
+// The lexeme is stored as pointer + 32-bit length, which keeps a token at
+// 24 bytes on 64-bit targets.
 struct Token {
     TokenType type = TokenType::ENDMARKER;
-    std::string lexeme;
-    SourceLocation loc;
+    TokenKind kind = TokenKind::None;
+    SymbolId sym = kNoSymbol;
+    SourceOffset offset = 0;
+    std::uint32_t length = 0;
+    const char* text = "";
 
     Token() = default;
-    Token(TokenType t, std::string l, SourceLocation s)
-        : type(t), lexeme(std::move(l)), loc(s) {}
+    Token(TokenType t, std::string_view l, SourceOffset at,
+          SymbolId id = kNoSymbol, TokenKind k = TokenKind::None)
+        : type(t), kind(k), sym(id), offset(at),
+          length(static_cast<std::uint32_t>(l.size())), text(l.data()) {}
+
+    std::string_view lexeme() const { return {text, length}; }
+    void set_lexeme(std::string_view l) {
+        text = l.data();
+        length = static_cast<std::uint32_t>(l.size());
+    }
 };
 
+static_assert(sizeof(Token) <= 16 + sizeof(const char*),
+              "Token is expected to pack into 24 bytes on 64-bit targets");
+
 // Helpers
 std::string token_type_to_string(TokenType t);
-std::string token_to_string(const Token& tok);
+// "TYPE ('lexeme') @line:col"; `lines` must index the token's source.
+std::string token_to_string(const Token& tok,
+                            const diagnostics::LineTable& lines);
 
 } // namespace lexer
 } // namespace cimple
@@ -6,7 +6,8 @@ namespace cimple {
 namespace lexer {
 
 std::string token_type_to_string(TokenType t);
-std::string token_to_string(const Token& tok);
+std::string token_to_string(const Token& tok,
+                            const diagnostics::LineTable& lines);
 
 } // namespace lexer
 } // namespace cimple
@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cimple {
+namespace parser {
+
+// ---------------------------------------------------------------------------
+// Bump allocator that owns a module's AST.
+//
+// Nodes, child lists and literal text are carved out of large blocks and
+// are never freed individually: destroying the arena releases the whole
+// tree at once. Everything allocated here must therefore be trivially
+// destructible.
+// ---------------------------------------------------------------------------
+class Arena {
+public:
+  Arena() = default;
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+  Arena(Arena &&other) noexcept { *this = std::move(other); }
+  Arena &operator=(Arena &&other) noexcept {
+    blocks_ = std::move(other.blocks_);
+    cur_ = std::exchange(other.cur_, nullptr);
+    end_ = std::exchange(other.end_, nullptr);
+    bytes_ = std::exchange(other.bytes_, 0);
+    return *this;
+  }
+
+  void *allocate(std::size_t size, std::size_t align) {
+    auto p = reinterpret_cast<std::uintptr_t>(cur_);
+    std::uintptr_t aligned = (p + align - 1) & ~(std::uintptr_t(align) - 1);
+    if (!cur_ || aligned + size > reinterpret_cast<std::uintptr_t>(end_)) {
+      grow(size + align);
+      p = reinterpret_cast<std::uintptr_t>(cur_);
+      aligned = (p + align - 1) & ~(std::uintptr_t(align) - 1);
+    }
+    cur_ = reinterpret_cast<char *>(aligned + size);
+    return reinterpret_cast<void *>(aligned);
+  }
+
+  template <typename T, typename... Args> T *make(Args &&...args) {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "arena objects are never destroyed");
+    return new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+  }
+
+  // Copy of `items`, owned by the arena.
+  template <typename T> T *copy_array(const T *items, std::size_t n) {
+    static_assert(std::is_trivially_copyable<T>::value &&
+                      std::is_trivially_destructible<T>::value,
+                  "arena arrays are copied bytewise and never destroyed");
+    if (n == 0)
+      return nullptr;
+    void *mem = allocate(n * sizeof(T), alignof(T));
+    std::memcpy(mem, items, n * sizeof(T));
+    return static_cast<T *>(mem);
+  }
+
+  std::string_view copy_string(std::string_view s) {
+    return {copy_array(s.data(), s.size()), s.size()};
+  }
+
+  // Take over `other`'s blocks, so what was allocated there lives as long
+  // as this arena. Allocation continues in this arena's current block.
+  void adopt(Arena &&other) {
+    for (auto &block : other.blocks_)
+      blocks_.push_back(std::move(block));
+    bytes_ += other.bytes_;
+    other = Arena();
+  }
+
+  // Bytes reserved from the system so far.
+  std::size_t bytes_reserved() const { return bytes_; }
+
+private:
+  static constexpr std::size_t kBlockSize = 64 * 1024;
+
+  void grow(std::size_t min_size) {
+    const std::size_t size = min_size > kBlockSize ? min_size : kBlockSize;
+    blocks_.emplace_back(new char[size]);
+    cur_ = blocks_.back().get();
+    end_ = cur_ + size;
+    bytes_ += size;
+  }
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char *cur_ = nullptr;
+  char *end_ = nullptr;
+  std::size_t bytes_ = 0;
+};
+
+// Read-only array that lives in an Arena: an AST child list. Trivially
+// copyable, so it can be embedded in arena nodes.
+template <typename T> class ArenaSpan {
+public:
+  ArenaSpan() = default;
+  ArenaSpan(T *data, std::size_t size)
+      : data_(data), size_(static_cast<std::uint32_t>(size)) {}
+  ArenaSpan(Arena &arena, const std::vector<T> &items)
+      : ArenaSpan(arena.copy_array(items.data(), items.size()), items.size()) {}
+
+  T *begin() const { return data_; }
+  T *end() const { return data_ + size_; }
+  T &operator[](std::size_t i) const { return data_[i]; }
+  T &back() const { return data_[size_ - 1]; }
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+private:
+  T *data_ = nullptr;
+  std::uint32_t size_ = 0;
+};
+
+} // namespace parser
+} // namespace cimple
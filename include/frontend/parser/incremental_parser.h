@@ -0,0 +1,60 @@
+#pragma once
+#include "parser.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace cimple {
+namespace parser {
+
+// ---------------------------------------------------------------------------
+// Incremental reparsing for editor and watch-mode workflows.
+//
+// parse() splits the source into top-level spans: a span starts at a line
+// that begins with a token at indentation 0 (except `elif`/`else`, which
+// continue the `if` before them) and runs to the next such line. Each span
+// is keyed by a hash of its bytes. A span whose key matches one from the
+// previous parse() keeps that parse's statements, moved to the span's new
+// offset, and is not even lexed. Only the other spans are lexed and parsed,
+// so a one-line edit reparses one top-level definition.
+//
+// The result is the module a full Parser would build from the same source.
+// A span whose statements run past its end (a block with no INDENT, say)
+// is parsed together with the spans after it, and only a span that parsed
+// from exactly its first token to exactly its last, without errors, is kept
+// for reuse.
+// ---------------------------------------------------------------------------
+class IncrementalParser {
+public:
+  struct Stats {
+    std::size_t spans = 0;    // top-level spans in the last source
+    std::size_t reparsed = 0; // spans parsed rather than reused
+  };
+
+  // Parse `source`, reusing what the previous call parsed where the source
+  // is unchanged. The module, whose nodes also live in arenas kept by this
+  // parser, is valid until the next call. `source` need not outlive it.
+  const Module &parse(std::string_view source);
+
+  const Stats &stats() const { return stats_; }
+
+private:
+  // A reusable span: its statements and the arena holding them.
+  struct Span {
+    std::uint64_t size = 0;
+    lexer::SourceOffset begin = 0; // offset in the source it last came from
+    StmtList stmts;
+    std::shared_ptr<Arena> arena;
+  };
+
+  Module module_; // owns only the top-level statement list
+  std::shared_ptr<Arena> latest_; // nodes of the last parse, reusable or not
+  std::unordered_multimap<std::uint64_t, Span> spans_; // keyed by hash
+  Stats stats_;
+};
+
+} // namespace parser
+} // namespace cimple
@@ -0,0 +1,181 @@
+#pragma once
+#include "../lexer/token.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace cimple {
+namespace parser {
+
+// ---------------------------------------------------------------------------
+// Operator kinds and the binary operator table.
+//
+// The parser decides an operator's kind once, from its token; passes switch
+// on the enum instead of comparing spellings. `and`/`or` are binary operator
+// kinds too, but build a LogicalExpr so they keep short-circuit evaluation.
+// ---------------------------------------------------------------------------
+
+enum class BinOpKind : std::uint8_t {
+  Or,
+  And,
+  Eq,
+  Ne,
+  Lt,
+  Gt,
+  Le,
+  Ge,
+  BitOr,
+  BitXor,
+  BitAnd,
+  Shl,
+  Shr,
+  Add,
+  Sub,
+  Mul,
+  Div,
+  FloorDiv,
+  Mod,
+  Pow,
+};
+
+enum class UnOpKind : std::uint8_t {
+  Not,    // not x
+  Neg,    // -x
+  BitNot, // ~x
+};
+
+enum class Assoc : std::uint8_t { Left, Right };
+
+// Binding power of each operator level; higher binds tighter. The levels
+// follow Python: prefix `not` sits between `and` and the comparisons
+// (`not a < b` is `not (a < b)`), prefix `-`/`~` bind tighter than every
+// binary operator except `**`, so `-2 ** 2` is `-(2 ** 2)`.
+enum Precedence : std::uint8_t {
+  kPrecNone = 0,
+  kPrecOr,
+  kPrecAnd,
+  kPrecNot,
+  kPrecComparison,
+  kPrecBitOr,
+  kPrecBitXor,
+  kPrecBitAnd,
+  kPrecShift,
+  kPrecAdditive,
+  kPrecMultiplicative,
+  kPrecUnary,
+  kPrecPower,
+};
+
+struct BinaryOperatorInfo {
+  lexer::TokenKind token = lexer::TokenKind::None;
+  BinOpKind op = BinOpKind::Or;
+  Precedence precedence = kPrecNone;
+  Assoc assoc = Assoc::Left;
+  const char *spelling = "";
+};
+
+// One row per BinOpKind, in enum order.
+inline constexpr BinaryOperatorInfo kBinaryOperators[] = {
+    {lexer::TokenKind::KW_OR, BinOpKind::Or, kPrecOr, Assoc::Left, "or"},
+    {lexer::TokenKind::KW_AND, BinOpKind::And, kPrecAnd, Assoc::Left, "and"},
+    {lexer::TokenKind::OP_EQ_EQ, BinOpKind::Eq, kPrecComparison, Assoc::Left,
+     "=="},
+    {lexer::TokenKind::OP_NOT_EQ, BinOpKind::Ne, kPrecComparison, Assoc::Left,
+     "!="},
+    {lexer::TokenKind::OP_LT, BinOpKind::Lt, kPrecComparison, Assoc::Left,
+     "<"},
+    {lexer::TokenKind::OP_GT, BinOpKind::Gt, kPrecComparison, Assoc::Left,
+     ">"},
+    {lexer::TokenKind::OP_LT_EQ, BinOpKind::Le, kPrecComparison, Assoc::Left,
+     "<="},
+    {lexer::TokenKind::OP_GT_EQ, BinOpKind::Ge, kPrecComparison, Assoc::Left,
+     ">="},
+    {lexer::TokenKind::OP_PIPE, BinOpKind::BitOr, kPrecBitOr, Assoc::Left,
+     "|"},
+    {lexer::TokenKind::OP_CARET, BinOpKind::BitXor, kPrecBitXor, Assoc::Left,
+     "^"},
+    {lexer::TokenKind::OP_AMP, BinOpKind::BitAnd, kPrecBitAnd, Assoc::Left,
+     "&"},
+    {lexer::TokenKind::OP_LSHIFT, BinOpKind::Shl, kPrecShift, Assoc::Left,
+     "<<"},
+    {lexer::TokenKind::OP_RSHIFT, BinOpKind::Shr, kPrecShift, Assoc::Left,
+     ">>"},
+    {lexer::TokenKind::OP_PLUS, BinOpKind::Add, kPrecAdditive, Assoc::Left,
+     "+"},
+    {lexer::TokenKind::OP_MINUS, BinOpKind::Sub, kPrecAdditive, Assoc::Left,
+     "-"},
+    {lexer::TokenKind::OP_STAR, BinOpKind::Mul, kPrecMultiplicative,
+     Assoc::Left, "*"},
+    {lexer::TokenKind::OP_SLASH, BinOpKind::Div, kPrecMultiplicative,
+     Assoc::Left, "/"},
+    {lexer::TokenKind::OP_SLASH_SLASH, BinOpKind::FloorDiv,
+     kPrecMultiplicative, Assoc::Left, "//"},
+    {lexer::TokenKind::OP_PERCENT, BinOpKind::Mod, kPrecMultiplicative,
+     Assoc::Left, "%"},
+    {lexer::TokenKind::OP_STAR_STAR, BinOpKind::Pow, kPrecPower, Assoc::Right,
+     "**"},
+};
+
+constexpr bool binary_operators_in_enum_order() {
+  std::size_t i = 0;
+  for (const BinaryOperatorInfo &info : kBinaryOperators)
+    if (static_cast<std::size_t>(info.op) != i++)
+      return false;
+  return true;
+}
+static_assert(binary_operators_in_enum_order(),
+              "kBinaryOperators rows must follow BinOpKind order");
+
+// TokenKind -> row of kBinaryOperators, or nullptr for non-operators.
+constexpr std::size_t kTokenKindCount =
+    static_cast<std::size_t>(lexer::TokenKind::OP_OTHER) + 1;
+
+constexpr std::array<const BinaryOperatorInfo *, kTokenKindCount>
+make_binary_operator_index() {
+  std::array<const BinaryOperatorInfo *, kTokenKindCount> index{};
+  for (const BinaryOperatorInfo &info : kBinaryOperators)
+    index[static_cast<std::size_t>(info.token)] = &info;
+  return index;
+}
+
+inline constexpr std::array<const BinaryOperatorInfo *, kTokenKindCount>
+    kBinaryOperatorIndex = make_binary_operator_index();
+
+// The binary operator a token spells, or nullptr.
+inline const BinaryOperatorInfo *find_binary_operator(lexer::TokenKind k) {
+  return kBinaryOperatorIndex[static_cast<std::size_t>(k)];
+}
+
+constexpr const BinaryOperatorInfo &binary_operator(BinOpKind op) {
+  return kBinaryOperators[static_cast<std::size_t>(op)];
+}
+
+constexpr const char *op_spelling(BinOpKind op) {
+  return binary_operator(op).spelling;
+}
+
+constexpr const char *op_spelling(UnOpKind op) {
+  return op == UnOpKind::Not ? "not" : op == UnOpKind::Neg ? "-" : "~";
+}
+
+constexpr bool is_comparison(BinOpKind op) {
+  return binary_operator(op).precedence == kPrecComparison;
+}
+
+// + - * / // % **
+constexpr bool is_arithmetic(BinOpKind op) {
+  return binary_operator(op).precedence >= kPrecAdditive;
+}
+
+// | ^ & << >> (integer operands only)
+constexpr bool is_bitwise(BinOpKind op) {
+  return binary_operator(op).precedence >= kPrecBitOr &&
+         binary_operator(op).precedence <= kPrecShift;
+}
+
+constexpr bool is_logical(BinOpKind op) {
+  return op == BinOpKind::And || op == BinOpKind::Or;
+}
+
+} // namespace parser
+} // namespace cimple
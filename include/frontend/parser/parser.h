@@ -2,176 +2,387 @@
 
 #include "../lexer/lexer.h"
 #include "../token_stream.h"
-#include <memory>
+#include "arena.h"
+#include "operators.h"
+#include <cassert>
+#include <cstdint>
+#include <iosfwd>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace cimple {
 namespace parser {
 
-// Richer AST node hierarchy
+// Richer AST node hierarchy. Identifiers carry their interned SymbolId,
+// which passes compare and hash; the spelled name is kept for printing.
+//
+// Nodes live in the owning Module's Arena. They are trivially destructible
+// (no virtual destructor, no owning members): child links are raw pointers,
+// child lists are ArenaSpans, and text is a string_view into the arena or
+// the symbol table.
+//
+// Every node records its concrete type in `kind`, so passes dispatch with a
+// switch (see ast/ast_visitor.h) and test types with isa/dyn_cast/cast below
+// instead of RTTI.
+//
+// `offset` is the byte offset, in the module's source, of the token that
+// introduces the node: a literal or name, the operator of a unary, binary
+// or logical expression (the first operator of a comparison chain), the
+// keyword of a compound or control statement, and the first token of an
+// assignment or expression statement. diagnostics::LineTable turns it into
+// a line and column.
+//
+// A new kind also needs a case in shift() (incremental_parser.cpp), which
+// moves every offset in a subtree that IncrementalParser reuses.
+enum class NodeKind : std::uint8_t {
+  // Expressions
+  NumberLiteral,
+  StringLiteral,
+  BoolLiteral,
+  VarRef,
+  CallExpr,
+  BinaryOp,
+  UnaryOp,
+  LogicalExpr,
+  CompareChain,
+  // Statements
+  ExprStmt,
+  AssignStmt,
+  ReturnStmt,
+  FuncDef,
+  IfStmt,
+  WhileStmt,
+  BreakStmt,
+  ContinueStmt,
+};
+
 struct Node {
-  virtual ~Node() = default;
+  NodeKind kind;
+  lexer::SourceOffset offset = 0; // fits beside `kind`; no size cost
+  explicit Node(NodeKind k) : kind(k) {}
   virtual std::string to_string() const = 0;
 };
 
-struct Expr : Node {};
+// Type tests on nodes, keyed by each node type's `kKind`. `cast` requires
+// the node to have that type; `dyn_cast` returns nullptr otherwise.
+template <typename T> bool isa(const Node *n) {
+  return n && n->kind == T::kKind;
+}
+template <typename T> const T *dyn_cast(const Node *n) {
+  return isa<T>(n) ? static_cast<const T *>(n) : nullptr;
+}
+template <typename T> T *dyn_cast(Node *n) {
+  return isa<T>(n) ? static_cast<T *>(n) : nullptr;
+}
+template <typename T> const T *cast(const Node *n) {
+  assert(isa<T>(n));
+  return static_cast<const T *>(n);
+}
+
+struct Expr : Node {
+  using Node::Node;
+};
+struct Stmt;
+
+using ExprList = ArenaSpan<Expr *>;
+using StmtList = ArenaSpan<Stmt *>;
 
+// Numeric literal, decoded once when parsed. A literal containing '.' is a
+// Float; `in_range` is false when the text does not fit an int64 (or
+// double), and consumers must report it rather than read the payload.
+// `num_kind` is named apart from Node::kind, which stays the NodeKind.
 struct NumberLiteral : Expr {
-  std::string value;
-  NumberLiteral(std::string v) : value(std::move(v)) {}
-  std::string to_string() const override { return "Number(" + value + ")"; }
+  static constexpr NodeKind kKind = NodeKind::NumberLiteral;
+  enum Kind : std::uint8_t { Int, Float };
+
+  std::string_view value; // source text
+  Kind num_kind = Int;
+  bool in_range = true;
+  std::int64_t int_value = 0;
+  double float_value = 0.0;
+
+  explicit NumberLiteral(std::string_view v);
+  bool is_float() const { return num_kind == Float; }
+  std::string to_string() const override {
+    return "Number(" + std::string(value) + ")";
+  }
 };
 
 struct StringLiteral : Expr {
-  std::string value;
-  StringLiteral(std::string v) : value(std::move(v)) {}
-  std::string to_string() const override { return "String(" + value + ")"; }
+  static constexpr NodeKind kKind = NodeKind::StringLiteral;
+  std::string_view value; // raw literal, quotes included
+  explicit StringLiteral(std::string_view v) : Expr(kKind), value(v) {}
+  std::string to_string() const override {
+    return "String(" + std::string(value) + ")";
+  }
 };
 
 struct BoolLiteral : Expr {
+  static constexpr NodeKind kKind = NodeKind::BoolLiteral;
   bool value;
-  BoolLiteral(bool v) : value(v) {}
+  BoolLiteral(bool v) : Expr(kKind), value(v) {}
   std::string to_string() const override {
     return value ? "Bool(True)" : "Bool(False)";
   }
 };
 
 struct VarRef : Expr {
-  std::string name;
-  VarRef(std::string n) : name(std::move(n)) {}
-  std::string to_string() const override { return "Var(" + name + ")"; }
+  static constexpr NodeKind kKind = NodeKind::VarRef;
+  std::string_view name;
+  lexer::SymbolId id;
+  explicit VarRef(lexer::SymbolId s)
+      : Expr(kKind), name(lexer::symbol_name(s)), id(s) {}
+  std::string to_string() const override {
+    return "Var(" + std::string(name) + ")";
+  }
 };
 
 struct CallExpr : Expr {
-  std::unique_ptr<Expr> callee;
-  std::vector<std::unique_ptr<Expr>> args;
+  static constexpr NodeKind kKind = NodeKind::CallExpr;
+  CallExpr() : Expr(kKind) {}
+  Expr *callee = nullptr;
+  ExprList args;
   std::string to_string() const override { return "Call(...)"; }
 };
 
 struct BinaryOp : Expr {
-  std::string op;
-  std::unique_ptr<Expr> left, right;
-  BinaryOp(std::string o, std::unique_ptr<Expr> l, std::unique_ptr<Expr> r)
-      : op(std::move(o)), left(std::move(l)), right(std::move(r)) {}
-  std::string to_string() const override { return "BinOp(" + op + ")"; }
+  static constexpr NodeKind kKind = NodeKind::BinaryOp;
+  BinOpKind op; // never And/Or (see LogicalExpr)
+  Expr *left, *right;
+  BinaryOp(BinOpKind o, Expr *l, Expr *r)
+      : Expr(kKind), op(o), left(l), right(r) {}
+  std::string to_string() const override {
+    return std::string("BinOp(") + op_spelling(op) + ")";
+  }
 };
 
 struct UnaryOp : Expr {
-  std::string op; // "not", "-"
-  std::unique_ptr<Expr> operand;
-  UnaryOp(std::string o, std::unique_ptr<Expr> e)
-      : op(std::move(o)), operand(std::move(e)) {}
-  std::string to_string() const override { return "UnaryOp(" + op + ")"; }
+  static constexpr NodeKind kKind = NodeKind::UnaryOp;
+  UnOpKind op;
+  Expr *operand;
+  UnaryOp(UnOpKind o, Expr *e) : Expr(kKind), op(o), operand(e) {}
+  std::string to_string() const override {
+    return std::string("UnaryOp(") + op_spelling(op) + ")";
+  }
 };
 
 // Logical and/or with short-circuit semantics.
 // Separate from BinaryOp so the evaluator and LLVM backend can implement
 // short-circuit branching without touching arithmetic code paths.
 struct LogicalExpr : Expr {
-  std::string op; // "and" or "or"
-  std::unique_ptr<Expr> left;
-  std::unique_ptr<Expr> right;
-  LogicalExpr(std::string o, std::unique_ptr<Expr> l, std::unique_ptr<Expr> r)
-      : op(std::move(o)), left(std::move(l)), right(std::move(r)) {}
-  std::string to_string() const override { return "LogicalExpr(" + op + ")"; }
+  static constexpr NodeKind kKind = NodeKind::LogicalExpr;
+  BinOpKind op; // And or Or
+  Expr *left;
+  Expr *right;
+  LogicalExpr(BinOpKind o, Expr *l, Expr *r)
+      : Expr(kKind), op(o), left(l), right(r) {}
+  std::string to_string() const override {
+    return std::string("LogicalExpr(") + op_spelling(op) + ")";
+  }
+};
+
+// Two or more chained comparisons: `a < b <= c` means `a < b and b <= c`,
+// with `b` evaluated once. ops[i] compares operands[i] and operands[i + 1].
+struct CompareChain : Expr {
+  static constexpr NodeKind kKind = NodeKind::CompareChain;
+  CompareChain() : Expr(kKind) {}
+  ExprList operands;
+  ArenaSpan<BinOpKind> ops;
+  std::string to_string() const override { return "CompareChain"; }
 };
 
 // Statements
-struct Stmt : Node {};
+struct Stmt : Node {
+  using Node::Node;
+};
 
 struct ExprStmt : Stmt {
-  std::unique_ptr<Expr> expr;
-  ExprStmt(std::unique_ptr<Expr> e) : expr(std::move(e)) {}
+  static constexpr NodeKind kKind = NodeKind::ExprStmt;
+  Expr *expr;
+  explicit ExprStmt(Expr *e) : Stmt(kKind), expr(e) {}
   std::string to_string() const override { return "ExprStmt"; }
 };
 
 struct AssignStmt : Stmt {
-  std::string target;
-  std::unique_ptr<Expr> value;
-  AssignStmt(std::string t, std::unique_ptr<Expr> v)
-      : target(std::move(t)), value(std::move(v)) {}
+  static constexpr NodeKind kKind = NodeKind::AssignStmt;
+  std::string_view target;
+  lexer::SymbolId target_id;
+  Expr *value;
+  AssignStmt(lexer::SymbolId t, Expr *v)
+      : Stmt(kKind), target(lexer::symbol_name(t)), target_id(t),
+        value(v) {}
   std::string to_string() const override {
-    return "AssignStmt(" + target + ")";
+    return "AssignStmt(" + std::string(target) + ")";
   }
 };
 
 struct ReturnStmt : Stmt {
-  std::unique_ptr<Expr> value;
-  ReturnStmt(std::unique_ptr<Expr> v) : value(std::move(v)) {}
+  static constexpr NodeKind kKind = NodeKind::ReturnStmt;
+  Expr *value;
+  explicit ReturnStmt(Expr *v) : Stmt(kKind), value(v) {}
   std::string to_string() const override { return "ReturnStmt"; }
 };
 
 struct FuncDef : Stmt {
-  std::string name;
-  std::vector<std::string> params;
-  std::vector<std::unique_ptr<Stmt>> body;
-  std::string to_string() const override { return "FuncDef(" + name + ")"; }
+  static constexpr NodeKind kKind = NodeKind::FuncDef;
+  FuncDef() : Stmt(kKind) {}
+  std::string_view name;
+  lexer::SymbolId name_id = lexer::kNoSymbol;
+  ArenaSpan<std::string_view> params;
+  ArenaSpan<lexer::SymbolId> param_ids; // parallel to `params`
+  StmtList body;
+  std::string to_string() const override {
+    return "FuncDef(" + std::string(name) + ")";
+  }
 };
 
 // if / elif / else
 struct IfBranch {
-  std::unique_ptr<Expr> condition; // nullptr for else branch
-  std::vector<std::unique_ptr<Stmt>> body;
+  Expr *condition = nullptr; // nullptr for else branch
+  StmtList body;
 };
 
 struct IfStmt : Stmt {
-  std::vector<IfBranch> branches; // branches[0] = if, [1..n-1] = elif, last may
-                                  // be else (condition==nullptr)
+  static constexpr NodeKind kKind = NodeKind::IfStmt;
+  IfStmt() : Stmt(kKind) {}
+  ArenaSpan<IfBranch> branches; // branches[0] = if, [1..n-1] = elif, last
+                                // may be else (condition==nullptr)
   std::string to_string() const override { return "IfStmt"; }
 };
 
 // while loop
 struct WhileStmt : Stmt {
-  std::unique_ptr<Expr> condition;
-  std::vector<std::unique_ptr<Stmt>> body;
+  static constexpr NodeKind kKind = NodeKind::WhileStmt;
+  WhileStmt() : Stmt(kKind) {}
+  Expr *condition = nullptr;
+  StmtList body;
   std::string to_string() const override { return "WhileStmt"; }
 };
 
 // break — exits the nearest enclosing while loop
 struct BreakStmt : Stmt {
+  static constexpr NodeKind kKind = NodeKind::BreakStmt;
+  BreakStmt() : Stmt(kKind) {}
   std::string to_string() const override { return "BreakStmt"; }
 };
 
 // continue — skips the rest of the current loop body, starts next iteration
 struct ContinueStmt : Stmt {
+  static constexpr NodeKind kKind = NodeKind::ContinueStmt;
+  ContinueStmt() : Stmt(kKind) {}
   std::string to_string() const override { return "ContinueStmt"; }
 };
 
+// A parsed module. Owns the arena holding every node reachable from `body`;
+// the tree is freed, in one go, when the module is destroyed. Move-only.
+// (An IncrementalParser's module is the exception: the parser keeps the
+// nodes, spread over several arenas.)
 struct Module {
-  std::vector<std::unique_ptr<Stmt>> body;
+  Arena arena;
+  StmtList body;
 };
 
+class IncrementalParser;
+
+// Buffered token inputs of at least this many tokens are parsed by
+// Parser::parse_module_parallel when the machine has more than one core.
+constexpr std::size_t kParallelParseMinTokens = 1u << 20;
+
 class Parser {
 public:
-  Parser(const std::vector<lexer::Token> &tokens);
+  // Borrows `tokens`; they must stay alive while parse_module() runs.
+  explicit Parser(const std::vector<lexer::Token> &tokens);
+  Parser(std::vector<lexer::Token> &&) = delete;
+  // Pulls tokens from `lexer` as it goes, in constant token memory.
+  explicit Parser(lexer::Lexer &lexer);
 
   Module parse_module();
 
+  // Parse a buffered token input on up to `threads` threads, one run of
+  // top-level statements each. The module, and the errors reported, are
+  // the same as parse_module()'s.
+  Module parse_module_parallel(unsigned threads);
+
+  // Errors reported (on stderr) so far.
+  std::size_t error_count() const { return errors_; }
+
 private:
+  // Drives the module loop itself to skip reused statements.
+  friend class IncrementalParser;
+
+  // parse_module_parallel: one thread's run of top-level statements.
+  struct Chunk;
+  Parser(const lexer::Token *first, const lexer::Token *last,
+         std::ostream &diag);
+  static void parse_chunk(Chunk *chunk);
+
   TokenStream ts;
+  const std::vector<lexer::Token> *tokens_ = nullptr; // if buffered
+  Arena *arena_ = nullptr; // the module being parsed
+  std::ostream *diag_;     // where errors are reported
+  std::size_t errors_ = 0;
 
-  std::unique_ptr<Stmt> parse_statement();
-  std::unique_ptr<Stmt> parse_simple_statement();
-  std::unique_ptr<FuncDef> parse_funcdef();
-  std::unique_ptr<IfStmt> parse_if();
-  std::unique_ptr<WhileStmt> parse_while();
+  // Child lists are collected on these stacks and copied into the arena
+  // once complete; nested lists push above their parent's entries.
+  std::vector<Stmt *> stmt_stack_;
+  std::vector<Expr *> expr_stack_;
+
+  // True when the next token has subkind `k`.
+  bool at(lexer::TokenKind k) const { return ts.peek().kind == k; }
+  // Consume the next token if it has subkind `k`.
+  bool accept(lexer::TokenKind k) {
+    if (!at(k))
+      return false;
+    ts.next();
+    return true;
+  }
+
+  // The binary operator spelled by the next token, if it is on level `prec`.
+  const BinaryOperatorInfo *binary_operator_at(Precedence prec) const {
+    const BinaryOperatorInfo *op = find_binary_operator(ts.peek().kind);
+    return op && op->precedence == prec ? op : nullptr;
+  }
+
+  // A node located at source offset `pos`.
+  template <typename T, typename... Args>
+  T *make(lexer::SourceOffset pos, Args &&...args) {
+    T *node = arena_->make<T>(std::forward<Args>(args)...);
+    node->offset = pos;
+    return node;
+  }
+  // Move stack[mark, end) into the arena.
+  template <typename T>
+  ArenaSpan<T> pop_list(std::vector<T> &stack, std::size_t mark) {
+    ArenaSpan<T> list(arena_->copy_array(stack.data() + mark,
+                                         stack.size() - mark),
+                      stack.size() - mark);
+    stack.resize(mark);
+    return list;
+  }
+
+  // Skip the blank lines, comments and stray indentation tokens between
+  // top-level statements; false once the input is exhausted.
+  bool skip_to_module_statement();
+
+  Stmt *parse_statement();
+  Stmt *parse_simple_statement();
+  FuncDef *parse_funcdef();
+  IfStmt *parse_if();
+  WhileStmt *parse_while();
 
   // Parse an indented block of statements (after NEWLINE + INDENT)
-  std::vector<std::unique_ptr<Stmt>> parse_block();
-
-  // Expression grammar (low → high precedence):
-  //   logical_or → logical_and → comparison → additive → term → unary → factor
-  std::unique_ptr<Expr> parse_expression();  // entry: calls parse_logical_or
-  std::unique_ptr<Expr> parse_logical_or();  // handles 'or'
-  std::unique_ptr<Expr> parse_logical_and(); // handles 'and'
-  std::unique_ptr<Expr> parse_comparison();  // handles ==, !=, <, >, <=, >=
-  std::unique_ptr<Expr> parse_additive();    // handles + and -
-  std::unique_ptr<Expr> parse_term();        // handles * and /
-  std::unique_ptr<Expr> parse_unary();       // handles 'not' and unary '-'
-  std::unique_ptr<Expr> parse_factor(); // literals, identifiers, calls, parens
-  std::vector<std::unique_ptr<Expr>> parse_arglist();
+  StmtList parse_block();
+
+  // Expressions (see the grammar in parser.cpp). parse_expression parses
+  // operators binding at least as tightly as `min_prec`.
+  Expr *parse_expression(Precedence min_prec = kPrecOr);
+  Expr *parse_comparison_chain(Expr *first, BinOpKind op,
+                               lexer::SourceOffset pos);
+  Expr *parse_prefix(); // 'not', unary '-' and '~', then a factor
+  Expr *parse_factor(); // literals, identifiers, calls, parens
+  ExprList parse_arglist();
 };
 
 } // namespace parser
@@ -0,0 +1,79 @@
+#pragma once
+#include "../parser/parser.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cimple {
+namespace semantic {
+
+// ---------------------------------------------------------------------------
+// Name resolution for the bytecode VM.
+//
+// Binds every variable read and write to a slot before execution, replacing
+// the evaluator's per-access ScopeStack probes. Block scopes (if branches,
+// while loops) are flattened into their function's frame, so a local is a
+// single index into a flat per-call slot array; module-level names are
+// global slots (the `<main>` frame's own function-scope slots).
+//
+// Slot semantics reproduce ScopeStack exactly. A scope only ever receives
+// writes from statements directly inside it, so the bindings visible from an
+// enclosing scope cannot change while an inner block or callee is active.
+// Each scope can therefore copy the outer value of every name it assigns on
+// entry, after which a read needs no fallback chain: it sees the innermost
+// scope that assigns the name, or a global, or nothing.
+// ---------------------------------------------------------------------------
+
+struct VarBinding {
+  enum Kind : std::uint8_t { Unbound, Local, Global } kind = Unbound;
+  std::uint32_t slot = 0; // frame slot (Local) or global index (Global)
+};
+
+// Slots (re)initialized when control enters a block scope: each slot takes
+// the value its name resolves to just outside the block.
+struct BlockLayout {
+  std::vector<std::pair<std::uint32_t, VarBinding>> init;
+};
+
+struct FrameLayout {
+  std::uint32_t num_params = 0;  // parameters occupy slots [0, num_params)
+  std::uint32_t scope_slots = 0; // function-scope slots, cleared per call
+  std::uint32_t num_slots = 0;   // including the widest nest of block slots
+  // Function-scope names that shadow a global: until assigned (or when the
+  // argument is missing) they read the global, as ScopeStack falls back.
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> inherit_globals;
+  std::vector<std::string> slot_names;
+};
+
+struct Resolution {
+  std::vector<lexer::SymbolId> globals;
+  FrameLayout main;
+  std::unordered_map<const parser::FuncDef *, FrameLayout> functions;
+
+  // Bindings for VarRef reads and AssignStmt targets.
+  std::unordered_map<const parser::Node *, VarBinding> vars;
+  // Block layouts keyed by the block's statement list.
+  std::unordered_map<const void *, BlockLayout> blocks;
+
+  // Function definitions the slot model cannot express (duplicate parameter
+  // names); callers must execute those modules another way.
+  std::vector<const parser::FuncDef *> unsupported;
+
+  VarBinding binding(const parser::Node *node) const {
+    auto it = vars.find(node);
+    return it == vars.end() ? VarBinding{} : it->second;
+  }
+  const BlockLayout &block(const void *stmts) const {
+    static const BlockLayout empty;
+    auto it = blocks.find(stmts);
+    return it == blocks.end() ? empty : it->second;
+  }
+};
+
+// Resolve the module body and every top-level function definition.
+Resolution resolve_names(const parser::Module &module);
+
+} // namespace semantic
+} // namespace cimple
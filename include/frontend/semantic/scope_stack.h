@@ -15,7 +15,9 @@ namespace semantic {
 // - At top-level, names resolve through all active scopes (nearest first).
 // - Inside a function scope, names resolve in the current function chain first.
 //   If not found there, only the global scope is consulted (not caller frames).
-template <typename T> class ScopeStack {
+//
+// `Key` is the name type: std::string, or lexer::SymbolId for interned names.
+template <typename T, typename Key = std::string> class ScopeStack {
 public:
   enum class ScopeKind { Block, Function };
 
@@ -35,19 +37,19 @@ public:
     }
   }
 
-  void set_local(const std::string &name, const T &value) {
+  void set_local(const Key &name, const T &value) {
     frames_.back().values[name] = value;
   }
 
-  void set_local(const std::string &name, T &&value) {
+  void set_local(const Key &name, T &&value) {
     frames_.back().values[name] = std::move(value);
   }
 
-  void set_global(const std::string &name, const T &value) {
+  void set_global(const Key &name, const T &value) {
     frames_.front().values[name] = value;
   }
 
-  const T *lookup(const std::string &name) const {
+  const T *lookup(const Key &name) const {
     const std::size_t floor = current_function_floor_index();
     for (std::size_t i = frames_.size(); i-- > floor;) {
       auto it = frames_[i].values.find(name);
@@ -66,7 +68,7 @@ public:
     return nullptr;
   }
 
-  T *lookup_mut(const std::string &name) {
+  T *lookup_mut(const Key &name) {
     const std::size_t floor = current_function_floor_index();
     for (std::size_t i = frames_.size(); i-- > floor;) {
       auto it = frames_[i].values.find(name);
@@ -85,7 +87,7 @@ public:
     return nullptr;
   }
 
-  const T *lookup_current(const std::string &name) const {
+  const T *lookup_current(const Key &name) const {
     auto it = frames_.back().values.find(name);
     if (it == frames_.back().values.end()) {
       return nullptr;
@@ -93,7 +95,7 @@ public:
     return &it->second;
   }
 
-  T *lookup_current_mut(const std::string &name) {
+  T *lookup_current_mut(const Key &name) {
     auto it = frames_.back().values.find(name);
     if (it == frames_.back().values.end()) {
       return nullptr;
@@ -103,13 +105,13 @@ public:
 
   bool in_function_scope() const { return current_function_floor_index() > 0; }
 
-  const std::unordered_map<std::string, T> &global_values() const {
+  const std::unordered_map<Key, T> &global_values() const {
     return frames_.front().values;
   }
 
 private:
   struct Frame {
-    std::unordered_map<std::string, T> values;
+    std::unordered_map<Key, T> values;
     bool function_boundary = false;
   };
 
@@ -22,10 +22,14 @@ public:
 // Type checker - validates operations against inferred types
 // Catches compile-time errors like: string + int, wrong function argument
 // types, etc.
+//
+// Errors are located with `lines` when given (the module's source), and
+// reported without a position otherwise.
 class TypeChecker {
 public:
-  TypeChecker(const parser::Module &module, const TypeEnv &type_env)
-      : module_(module), type_env_(type_env) {}
+  TypeChecker(const parser::Module &module, const TypeEnv &type_env,
+              const diagnostics::LineTable *lines = nullptr)
+      : module_(module), type_env_(type_env), lines_(lines) {}
 
   // Run type checking - throws TypeCheckError if errors found
   void check();
@@ -34,10 +38,11 @@ public:
   std::vector<std::string> get_errors();
 
 private:
-  using ScopedTypeEnv = ScopeStack<TypeKind>;
+  using ScopedTypeEnv = ScopeStack<TypeKind, lexer::SymbolId>;
 
   const parser::Module &module_;
   const TypeEnv &type_env_;
+  const diagnostics::LineTable *lines_;
   std::vector<std::string> errors_;
 
   void check_stmt(const parser::Stmt *stmt, ScopedTypeEnv &local_env,
@@ -45,7 +50,7 @@ private:
 
   TypeKind check_expr(const parser::Expr *expr, ScopedTypeEnv &local_env);
 
-  void check_binary_op(const parser::BinaryOp *op, TypeKind left_type,
+  void check_binary_op(parser::BinOpKind op, TypeKind left_type,
                        TypeKind right_type, lexer::SourceLocation loc);
 
   void check_call(const parser::CallExpr *call, ScopedTypeEnv &local_env);
@@ -63,7 +68,8 @@ private:
 // Returns true if type checking passes, false otherwise
 // Errors are collected and can be retrieved
 bool check_types(const parser::Module &module, const TypeEnv &type_env,
-                 std::vector<std::string> &errors);
+                 std::vector<std::string> &errors,
+                 const diagnostics::LineTable *lines = nullptr);
 
 } // namespace semantic
 } // namespace cimple
@@ -8,14 +8,23 @@ namespace semantic {
 
 enum class TypeKind { Unknown, Int, Float, String, Bool, Void };
 
+// Inferred types keyed by interned name (see lexer::SymbolTable).
 struct TypeEnv {
-    std::unordered_map<std::string, TypeKind> vars;
-    std::unordered_map<std::string, TypeKind> functions; // function return types
+    std::unordered_map<lexer::SymbolId, TypeKind> vars;
+    std::unordered_map<lexer::SymbolId, TypeKind> functions; // function return types
 };
 
 // Run simple type inference on a module. Returns TypeEnv with inferred types.
 TypeEnv infer_types(const parser::Module& module);
 
+// The type of a name that may hold either type: numbers widen to Float,
+// Unknown and Void give way to the other, any other pair is Unknown.
+TypeKind unify(TypeKind a, TypeKind b);
+
+// Result types of the operators, as inference assigns them.
+TypeKind unary_type(parser::UnOpKind op, TypeKind operand);
+TypeKind binary_type(parser::BinOpKind op, TypeKind left, TypeKind right);
+
 std::string type_to_string(TypeKind t);
 
 } // namespace semantic
@@ -1,22 +1,56 @@
 #pragma once
 #include "frontend/lexer/lexer.h"
+#include <array>
 #include <vector>
 #include <cstddef>
+#include <cstdint>
 
 namespace cimple {
 
+// Read-only cursor over tokens, in one of two modes:
+//
+// - Buffered: borrows a token buffer owned by the caller (normally lex()'s
+//   output). peek() and next() hand out references into the buffer, which
+//   must outlive the stream.
+// - Streaming: pulls tokens from a lexer::Lexer on demand into a small ring,
+//   so token memory stays constant however large the source is. Lookahead
+//   is limited to kMaxLookahead tokens and rewind() to the tokens still in
+//   the ring. A returned reference stays valid until kHistory more tokens
+//   have been consumed; copy a token that must live longer.
 class TokenStream {
 public:
-    TokenStream(const std::vector<lexer::Token>& toks);
+    static constexpr size_t kRingSize = 64;
+    static constexpr size_t kMaxLookahead = 8;
+    static constexpr size_t kHistory = kRingSize - kMaxLookahead - 1;
+
+    explicit TokenStream(const std::vector<lexer::Token>& toks);
+    TokenStream(const lexer::Token* first, const lexer::Token* last);
+    // Borrowing a temporary would dangle.
+    TokenStream(std::vector<lexer::Token>&&) = delete;
+    // Streaming; `lexer` must outlive the stream.
+    explicit TokenStream(lexer::Lexer& lexer);
 
     const lexer::Token& peek(size_t lookahead = 0) const;
-    lexer::Token next();
+    const lexer::Token& next();
     bool eof() const;
     void rewind(size_t count = 1);
 
+    // Buffered mode only: index of the next token in the buffer.
+    size_t position() const { return static_cast<size_t>(cur_ - begin_); }
+
 private:
-    std::vector<lexer::Token> tokens;
-    size_t idx = 0;
+    const lexer::Token* begin_ = nullptr;
+    const lexer::Token* end_ = nullptr;
+    const lexer::Token* cur_ = nullptr;
+
+    // Streaming mode. Token number n lives in ring_[n % kRingSize]; head_
+    // is the next token to consume and tail_ the number pulled so far.
+    lexer::Lexer* lexer_ = nullptr;
+    mutable std::array<lexer::Token, kRingSize> ring_{};
+    std::uint64_t head_ = 0;
+    mutable std::uint64_t tail_ = 0;
+
+    const lexer::Token& ring_peek(size_t lookahead) const;
 };
 
 } // namespace cimple
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace cimple {
+namespace utils {
+
+// ---------------------------------------------------------------------------
+// Read-only source file contents.
+//
+// Regular files are memory-mapped, so loading costs no copy. Pipes, stdin
+// ("-") and files the mapping cannot serve are read into an owned buffer
+// instead. Either way the byte after the contents is a '\0' sentinel.
+//
+// Tokens and other views into text() borrow from the buffer, which must
+// outlive them. Move-only.
+// ---------------------------------------------------------------------------
+class SourceBuffer {
+public:
+  // std::nullopt when `path` cannot be opened or read.
+  static std::optional<SourceBuffer> open(const std::string &path);
+
+  SourceBuffer(SourceBuffer &&other) noexcept;
+  SourceBuffer &operator=(SourceBuffer &&other) noexcept;
+  SourceBuffer(const SourceBuffer &) = delete;
+  SourceBuffer &operator=(const SourceBuffer &) = delete;
+  ~SourceBuffer();
+
+  std::string_view text() const { return {data_, size_}; }
+  const char *data() const { return data_; }
+  std::size_t size() const { return size_; }
+  bool is_mapped() const { return mapping_ != nullptr; }
+
+private:
+  SourceBuffer() = default;
+  void release();
+
+  const char *data_ = "";
+  std::size_t size_ = 0;
+  void *mapping_ = nullptr; // base of the mapped view, if any
+  std::size_t mapping_size_ = 0;
+  std::string owned_; // fallback storage; std::string keeps the '\0'
+};
+
+} // namespace utils
+} // namespace cimple
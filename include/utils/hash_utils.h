@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace cimple {
+namespace utils {
+
+// ---------------------------------------------------------------------------
+// Fast 64-bit content hash.
+//
+// Meant for change detection (is this the same source as last time?), not
+// for hash tables facing untrusted keys or for security: it reads eight
+// bytes per step and mixes with multiply/rotate, so hashing a large source
+// costs far less than lexing it. Results are stable across runs and
+// platforms of the same endianness.
+// ---------------------------------------------------------------------------
+
+std::uint64_t hash_bytes(const void *data, std::size_t size,
+                         std::uint64_t seed = 0);
+
+inline std::uint64_t hash_string(std::string_view s, std::uint64_t seed = 0) {
+  return hash_bytes(s.data(), s.size(), seed);
+}
+
+} // namespace utils
+} // namespace cimple
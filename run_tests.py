@@ -2,9 +2,11 @@
 """Oracle harness for CIMPLE.
 
 For each .cimp program:
-1) Run evaluator (`cimple run`) -> expected output
-2) Build native executable (`cimple build`) and run it -> actual output
-3) Compare stdout byte-for-byte
+0) Run the front-end self-checks (FRONT_END_CHECKS); none may report MISMATCH
+1) Run the tree-walking evaluator (`cimple run --tree-walk`) -> expected output
+2) Run the bytecode VM (`cimple run`) -> must match the evaluator
+3) Build native executable (`cimple build`) and run it -> actual output
+4) Compare stdout byte-for-byte
 """
 
 from __future__ import annotations
@@ -22,6 +24,22 @@ from typing import Iterable, Optional
 
 IS_WINDOWS = os.name == "nt"
 
+# Debug commands that compare a fast front-end path with the plain one on a
+# test file and print MISMATCH when they disagree. Normal runs only take
+# the parallel paths for very large sources and never use the AST cache
+# (see COMMAND_ENV), so the tests exercise them here.
+FRONT_END_CHECKS: list[tuple[str, list[str]]] = [
+    ("parallel lexer", ["lexcheck", "{file}", "2", "3", "7"]),
+    ("incremental parser", ["reparsebench", "{file}"]),
+    ("parallel parser", ["parsebench", "{file}"]),
+    ("AST cache", ["cachecheck", "{file}"]),
+    ("flat AST", ["astbench", "{file}"]),
+]
+
+# Every run parses the test afresh: a cached AST would hide front-end
+# changes, and the cache would leave .cimpc files next to the tests.
+COMMAND_ENV = {**os.environ, "CIMPLE_NO_CACHE": "1"}
+
 
 @dataclass
 class CommandResult:
@@ -41,6 +59,7 @@ def run_command(argv: list[str], cwd: Path, timeout: float) -> CommandResult:
         proc = subprocess.run(
             argv,
             cwd=str(cwd),
+            env=COMMAND_ENV,
             capture_output=True,
             text=False,
             timeout=timeout,
@@ -118,18 +137,47 @@ def print_failure_details(title: str, result: CommandResult) -> None:
             print(f"      {line}")
 
 
-def unified_output_diff(expected: bytes, actual: bytes, test_name: str) -> str:
+def unified_output_diff(
+    expected: bytes, actual: bytes, test_name: str, actual_label: str = "native"
+) -> str:
     expected_text = decode(expected).splitlines(keepends=True)
     actual_text = decode(actual).splitlines(keepends=True)
     diff = difflib.unified_diff(
         expected_text,
         actual_text,
         fromfile=f"{test_name} evaluator",
-        tofile=f"{test_name} native",
+        tofile=f"{test_name} {actual_label}",
     )
     return "".join(diff)
 
 
+def print_output_mismatch(
+    expected: bytes, actual: bytes, test_name: str, actual_label: str
+) -> None:
+    diff = unified_output_diff(expected, actual, test_name, actual_label)
+    if diff:
+        for line in diff.rstrip("\n").splitlines():
+            print(f"    {line}")
+    else:
+        print("    outputs differ at byte level (non-text diff)")
+        print(f"    evaluator bytes: {list(expected)}")
+        print(f"    {actual_label} bytes: {list(actual)}")
+
+
+def run_front_end_checks(
+    cimple: Path, test_file: Path, repo_root: Path, timeout: float
+) -> bool:
+    ok = True
+    for label, template in FRONT_END_CHECKS:
+        argv = [str(cimple)] + [a.replace("{file}", str(test_file)) for a in template]
+        res = run_command(argv, repo_root, timeout)
+        if res.returncode != 0 or b"MISMATCH" in res.stdout:
+            ok = False
+            print(f"  FAIL: {label} check")
+            print_failure_details(template[0], res)
+    return ok
+
+
 def parse_args(argv: Optional[Iterable[str]] = None) -> argparse.Namespace:
     parser = argparse.ArgumentParser(description="Run CIMPLE oracle tests.")
     parser.add_argument(
@@ -187,7 +235,15 @@ def main(argv: Optional[Iterable[str]] = None) -> int:
         rel_name = test_file.relative_to(repo_root)
         print(f"\n[TEST] {rel_name}")
 
-        eval_res = run_command([str(cimple), "run", str(test_file)], repo_root, args.timeout)
+        if not run_front_end_checks(cimple, test_file, repo_root, args.timeout):
+            failed += 1
+            if args.stop_on_fail:
+                break
+            continue
+
+        eval_res = run_command(
+            [str(cimple), "run", "--tree-walk", str(test_file)], repo_root, args.timeout
+        )
         if eval_res.returncode != 0:
             failed += 1
             print("  FAIL: evaluator command failed")
@@ -196,9 +252,26 @@ def main(argv: Optional[Iterable[str]] = None) -> int:
                 break
             continue
 
+        vm_res = run_command([str(cimple), "run", str(test_file)], repo_root, args.timeout)
+        if vm_res.returncode != 0:
+            failed += 1
+            print("  FAIL: VM command failed")
+            print_failure_details("vm", vm_res)
+            if args.stop_on_fail:
+                break
+            continue
+
+        if eval_res.stdout != vm_res.stdout:
+            failed += 1
+            print("  FAIL: VM output mismatch")
+            print_output_mismatch(eval_res.stdout, vm_res.stdout, str(rel_name), "vm")
+            if args.stop_on_fail:
+                break
+            continue
+
         if backend_disabled:
             skipped += 1
-            print(f"  SKIP: native backend unavailable ({backend_disabled_reason})")
+            print(f"  SKIP: VM matches; native backend unavailable ({backend_disabled_reason})")
             continue
 
         exe_path = expected_exe_path(test_file)
@@ -212,7 +285,7 @@ def main(argv: Optional[Iterable[str]] = None) -> int:
             backend_disabled = True
             backend_disabled_reason = "LLVM backend not enabled in current cimple binary"
             skipped += 1
-            print(f"  SKIP: {backend_disabled_reason}")
+            print(f"  SKIP: VM matches; {backend_disabled_reason}")
             continue
 
         if build_res.returncode != 0:
@@ -244,14 +317,9 @@ def main(argv: Optional[Iterable[str]] = None) -> int:
         if eval_res.stdout != native_res.stdout:
             failed += 1
             print("  FAIL: output mismatch")
-            diff = unified_output_diff(eval_res.stdout, native_res.stdout, str(rel_name))
-            if diff:
-                for line in diff.rstrip("\n").splitlines():
-                    print(f"    {line}")
-            else:
-                print("    outputs differ at byte level (non-text diff)")
-                print(f"    evaluator bytes: {list(eval_res.stdout)}")
-                print(f"    native bytes:    {list(native_res.stdout)}")
+            print_output_mismatch(
+                eval_res.stdout, native_res.stdout, str(rel_name), "native"
+            )
             if args.stop_on_fail:
                 break
             continue
@@ -9,6 +9,7 @@
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Support/FileSystem.h>
 #include <fstream>
+#include <iostream>
 
 namespace cimple {
 namespace backend {
@@ -25,7 +26,7 @@ void ModuleBuilder::build_module(const parser::Module& ast_module, const semanti
 
     // Build all top-level functions
     for (const auto& stmt : ast_module.body) {
-        if (auto func_def = dynamic_cast<const parser::FuncDef*>(stmt.get())) {
+        if (auto func_def = parser::dyn_cast<parser::FuncDef>(stmt)) {
             build_function(func_def, type_env);
         }
     }
@@ -35,7 +36,7 @@ void ModuleBuilder::build_function(const parser::FuncDef* func_def, const semant
     if (!func_def) return;
 
     // Get return type
-    auto ret_type_it = type_env.functions.find(func_def->name);
+    auto ret_type_it = type_env.functions.find(func_def->name_id);
     semantic::TypeKind ret_type_kind = (ret_type_it != type_env.functions.end()) 
         ? ret_type_it->second : semantic::TypeKind::Void;
     
@@ -56,7 +57,7 @@ void ModuleBuilder::build_function(const parser::FuncDef* func_def, const semant
     ::llvm::Function* func = ::llvm::Function::Create(
         func_type,
         ::llvm::Function::ExternalLinkage,
-        func_def->name,
+        std::string(func_def->name),
         &llvm_ctx_.get_module()
     );
 
@@ -69,7 +70,7 @@ void ModuleBuilder::build_function(const parser::FuncDef* func_def, const semant
     size_t param_idx = 0;
     for (auto& arg : func->args()) {
         if (param_idx < func_def->params.size()) {
-            local_vars_[func_def->params[param_idx]] = &arg;
+            local_vars_[std::string(func_def->params[param_idx])] = &arg;
             param_idx++;
         }
     }
@@ -77,7 +78,7 @@ void ModuleBuilder::build_function(const parser::FuncDef* func_def, const semant
     // Build function body
     for (const auto& body_stmt : func_def->body) {
         if (body_stmt) {
-            build_stmt(body_stmt.get(), type_env);
+            build_stmt(body_stmt, type_env);
         }
     }
 
@@ -106,40 +107,55 @@ void ModuleBuilder::build_function(const parser::FuncDef* func_def, const semant
 void ModuleBuilder::build_stmt(const parser::Stmt* stmt, const semantic::TypeEnv& type_env) {
     if (!stmt) return;
 
-    if (auto assign = dynamic_cast<const parser::AssignStmt*>(stmt)) {
-        ::llvm::Value* value = build_expr(assign->value.get(), type_env);
+    switch (stmt->kind) {
+    case parser::NodeKind::AssignStmt: {
+        auto assign = parser::cast<parser::AssignStmt>(stmt);
+        ::llvm::Value* value = build_expr(assign->value, type_env);
         if (value) {
-            local_vars_[assign->target] = value;
+            local_vars_[std::string(assign->target)] = value;
         }
+        break;
     }
-    else if (auto ret = dynamic_cast<const parser::ReturnStmt*>(stmt)) {
-        ::llvm::Value* ret_val = build_expr(ret->value.get(), type_env);
+    case parser::NodeKind::ReturnStmt: {
+        auto ret = parser::cast<parser::ReturnStmt>(stmt);
+        ::llvm::Value* ret_val = build_expr(ret->value, type_env);
         if (ret_val) {
             builder_->CreateRet(ret_val);
         }
+        break;
     }
-    else if (auto expr_stmt = dynamic_cast<const parser::ExprStmt*>(stmt)) {
+    case parser::NodeKind::ExprStmt:
         // Expression statements are evaluated but result is discarded
-        build_expr(expr_stmt->expr.get(), type_env);
+        build_expr(parser::cast<parser::ExprStmt>(stmt)->expr, type_env);
+        break;
+    default:
+        break;
     }
 }
 
 ::llvm::Value* ModuleBuilder::build_expr(const parser::Expr* expr, const semantic::TypeEnv& type_env) {
     if (!expr) return nullptr;
 
-    if (auto num = dynamic_cast<const parser::NumberLiteral*>(expr)) {
-        if (num->value.find('.') != std::string::npos) {
+    switch (expr->kind) {
+    case parser::NodeKind::NumberLiteral: {
+        auto num = parser::cast<parser::NumberLiteral>(expr);
+        if (!num->in_range) {
+            std::cerr << "Numeric literal out of range: " << num->value << "\n";
+            return nullptr;
+        }
+        if (num->is_float()) {
             // Float literal
-            double val = std::stod(num->value);
+            double val = num->float_value;
             return ::llvm::ConstantFP::get(type_mapper_.get_context(), ::llvm::APFloat(val));
         } else {
             // Integer literal
-            int64_t val = std::stoll(num->value);
+            int64_t val = num->int_value;
             return ::llvm::ConstantInt::get(type_mapper_.get_context(), ::llvm::APInt(32, val, true));
         }
     }
 
-    if (auto str = dynamic_cast<const parser::StringLiteral*>(expr)) {
+    case parser::NodeKind::StringLiteral: {
+        auto str = parser::cast<parser::StringLiteral>(expr);
         // Create global string constant
         ::llvm::Constant* str_const = ::llvm::ConstantDataArray::getString(
             type_mapper_.get_context(),
@@ -164,21 +180,23 @@ void ModuleBuilder::build_stmt(const parser::Stmt* stmt, const semantic::TypeEnv
         );
     }
 
-    if (auto var_ref = dynamic_cast<const parser::VarRef*>(expr)) {
-        auto it = local_vars_.find(var_ref->name);
+    case parser::NodeKind::VarRef: {
+        auto var_ref = parser::cast<parser::VarRef>(expr);
+        auto it = local_vars_.find(std::string(var_ref->name));
         if (it != local_vars_.end()) {
             return it->second;
         }
         return nullptr;
     }
 
-    if (auto bin_op = dynamic_cast<const parser::BinaryOp*>(expr)) {
-        ::llvm::Value* left = build_expr(bin_op->left.get(), type_env);
-        ::llvm::Value* right = build_expr(bin_op->right.get(), type_env);
+    case parser::NodeKind::BinaryOp: {
+        auto bin_op = parser::cast<parser::BinaryOp>(expr);
+        ::llvm::Value* left = build_expr(bin_op->left, type_env);
+        ::llvm::Value* right = build_expr(bin_op->right, type_env);
         
         if (!left || !right) return nullptr;
 
-        if (bin_op->op == "+") {
+        if (bin_op->op == parser::BinOpKind::Add) {
             // Check if both are integers or floats
             if (left->getType()->isIntegerTy() && right->getType()->isIntegerTy()) {
                 return builder_->CreateAdd(left, right, "addtmp");
@@ -192,7 +210,7 @@ void ModuleBuilder::build_stmt(const parser::Stmt* stmt, const semantic::TypeEnv
                 }
                 return builder_->CreateFAdd(left, right, "addtmp");
             }
-        } else if (bin_op->op == "-") {
+        } else if (bin_op->op == parser::BinOpKind::Sub) {
             if (left->getType()->isIntegerTy() && right->getType()->isIntegerTy()) {
                 return builder_->CreateSub(left, right, "subtmp");
             } else {
@@ -204,7 +222,7 @@ void ModuleBuilder::build_stmt(const parser::Stmt* stmt, const semantic::TypeEnv
                 }
                 return builder_->CreateFSub(left, right, "subtmp");
             }
-        } else if (bin_op->op == "*") {
+        } else if (bin_op->op == parser::BinOpKind::Mul) {
             if (left->getType()->isIntegerTy() && right->getType()->isIntegerTy()) {
                 return builder_->CreateMul(left, right, "multmp");
             } else {
@@ -216,7 +234,7 @@ void ModuleBuilder::build_stmt(const parser::Stmt* stmt, const semantic::TypeEnv
                 }
                 return builder_->CreateFMul(left, right, "multmp");
             }
-        } else if (bin_op->op == "/") {
+        } else if (bin_op->op == parser::BinOpKind::Div) {
             if (left->getType()->isIntegerTy() && right->getType()->isIntegerTy()) {
                 return builder_->CreateSDiv(left, right, "divtmp");
             } else {
@@ -229,23 +247,28 @@ void ModuleBuilder::build_stmt(const parser::Stmt* stmt, const semantic::TypeEnv
                 return builder_->CreateFDiv(left, right, "divtmp");
             }
         }
+        return nullptr;
     }
 
-    if (auto call = dynamic_cast<const parser::CallExpr*>(expr)) {
-        if (auto callee_var = dynamic_cast<const parser::VarRef*>(call->callee.get())) {
+    case parser::NodeKind::CallExpr: {
+        auto call = parser::cast<parser::CallExpr>(expr);
+        if (auto callee_var = parser::dyn_cast<parser::VarRef>(call->callee)) {
             ::llvm::Function* func = llvm_ctx_.get_module().getFunction(callee_var->name);
             if (func) {
                 std::vector<::llvm::Value*> args;
                 for (const auto& arg_expr : call->args) {
-                    ::llvm::Value* arg_val = build_expr(arg_expr.get(), type_env);
+                    ::llvm::Value* arg_val = build_expr(arg_expr, type_env);
                     if (arg_val) args.push_back(arg_val);
                 }
                 return builder_->CreateCall(func, args, "calltmp");
             }
         }
+        return nullptr;
     }
 
-    return nullptr;
+    default:
+        return nullptr;
+    }
 }
 
 void ModuleBuilder::emit_ir_to_file(const std::string& filename) {
@@ -1 +1,38 @@
-// source_location.cpp - stub
+// source_location.cpp - lazy offset -> line:column lookups
+#include "diagnostics/source_location.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace cimple::diagnostics;
+
+// Every line starts at 0 or just after a '\n', including the empty line
+// after a trailing newline (where the lexer places ENDMARKER).
+void LineTable::build() const {
+  line_starts_.push_back(0);
+  const char *const begin = source_.data();
+  const char *const end = begin + source_.size();
+  for (const char *p = begin; p < end;) {
+    const void *nl = std::memchr(p, '\n', static_cast<std::size_t>(end - p));
+    if (!nl)
+      break;
+    p = static_cast<const char *>(nl) + 1;
+    line_starts_.push_back(static_cast<SourceOffset>(p - begin));
+  }
+}
+
+SourceLocation LineTable::locate(SourceOffset offset) const {
+  if (line_starts_.empty())
+    build();
+  offset = static_cast<SourceOffset>(
+      std::min<std::size_t>(offset, source_.size()));
+
+  // The last line starting at or before `offset`.
+  const auto next =
+      std::upper_bound(line_starts_.begin(), line_starts_.end(), offset);
+  const SourceOffset start = *(next - 1);
+
+  int column = 1;
+  for (SourceOffset i = start; i < offset; ++i)
+    column += source_[i] == '\t' ? kTabWidth : 1;
+  return {static_cast<int>(next - line_starts_.begin()), column};
+}
@@ -0,0 +1,497 @@
+// ast_cache.cpp - save and load parsed modules as .cimpc files
+#include "frontend/ast/ast_cache.h"
+#include "frontend/ast/flat_ast.h"
+#include "utils/file_loader.h"
+#include "utils/hash_utils.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#ifndef CIMPLE_VERSION
+#define CIMPLE_VERSION "dev"
+#endif
+// Hash of the front-end sources, generated by the CMake build. Other builds
+// fall back to the time this file was compiled.
+#if __has_include("cimple_build_id.h")
+#include "cimple_build_id.h"
+#endif
+#ifndef CIMPLE_BUILD_ID
+#define CIMPLE_BUILD_ID __DATE__ " " __TIME__
+#endif
+
+using namespace cimple;
+using namespace cimple::ast;
+
+namespace {
+
+// Bump whenever the payload layout or the meaning of a column changes.
+constexpr std::uint32_t kFormatVersion = 1;
+constexpr char kMagic[8] = {'C', 'I', 'M', 'P', 'C', '\0', '\r', '\n'};
+// Reads back differently on a machine of the other endianness.
+constexpr std::uint32_t kByteOrderMark = 0x01020304;
+
+constexpr std::uint32_t kHasTypes = 1;
+
+struct Header {
+  char magic[8];
+  std::uint32_t format;
+  std::uint32_t byte_order;
+  std::uint64_t compiler; // see compiler_id()
+  std::uint64_t source_hash;
+  std::uint64_t source_size;
+  std::uint64_t options_hash;
+  std::uint64_t payload_size;
+  std::uint64_t payload_hash;
+  std::uint32_t flags;
+  std::uint32_t reserved;
+};
+static_assert(sizeof(Header) % 8 == 0, "the payload starts 8-byte aligned");
+static_assert(std::is_trivially_copyable<Header>::value, "");
+
+std::uint64_t compiler_id() {
+  return utils::hash_string(CIMPLE_BUILD_ID,
+                            utils::hash_string(CIMPLE_VERSION, kFormatVersion));
+}
+
+// ---------------------------------------------------------------------------
+// Payload encoding. Every array is a u64 element count followed by the
+// elements, padded to a multiple of 8 bytes. A string table is an array of
+// u32 end offsets followed by an array of the concatenated characters.
+// ---------------------------------------------------------------------------
+
+class Writer {
+public:
+  template <typename T> void array(const T *items, std::size_t n) {
+    static_assert(std::is_trivially_copyable<T>::value, "");
+    const auto count = static_cast<std::uint64_t>(n);
+    append(&count, sizeof count);
+    append(items, n * sizeof(T));
+    out_.resize((out_.size() + 7) & ~std::size_t(7), '\0');
+  }
+  template <typename T> void array(const std::vector<T> &items) {
+    array(items.data(), items.size());
+  }
+  template <typename T> void value(T v) { array(&v, 1); }
+
+  template <typename Strings> void strings(const Strings &items) {
+    std::vector<std::uint32_t> ends;
+    std::string chars;
+    for (std::string_view s : items) {
+      chars.append(s.data(), s.size());
+      ends.push_back(static_cast<std::uint32_t>(chars.size()));
+    }
+    array(ends);
+    array(chars.data(), chars.size());
+  }
+
+  const std::string &data() const { return out_; }
+
+private:
+  void append(const void *p, std::size_t n) {
+    out_.append(static_cast<const char *>(p), n);
+  }
+
+  std::string out_;
+};
+
+// Reads what Writer wrote, bounds-checking every array; after the first
+// failure every read fails.
+class Reader {
+public:
+  Reader(const char *data, std::size_t size) : p_(data), end_(data + size) {}
+
+  bool ok() const { return ok_; }
+  bool at_end() const { return p_ == end_; }
+
+  template <typename T> bool array(std::vector<T> &out) {
+    const char *items;
+    std::size_t n;
+    if (!next(sizeof(T), items, n))
+      return false;
+    out.resize(n);
+    if (n)
+      std::memcpy(out.data(), items, n * sizeof(T));
+    return true;
+  }
+  template <typename T> bool value(T &v) {
+    std::vector<T> one;
+    if (!array(one) || one.size() != 1)
+      return ok_ = false;
+    v = one[0];
+    return true;
+  }
+
+  // Views into the mapped file; valid while it stays mapped.
+  bool strings(std::vector<std::string_view> &out) {
+    std::vector<std::uint32_t> ends;
+    const char *chars;
+    std::size_t size;
+    if (!array(ends) || !next(1, chars, size))
+      return false;
+    out.clear();
+    out.reserve(ends.size());
+    std::uint32_t begin = 0;
+    for (std::uint32_t end : ends) {
+      if (end < begin || end > size)
+        return ok_ = false;
+      out.emplace_back(chars + begin, end - begin);
+      begin = end;
+    }
+    return true;
+  }
+
+private:
+  bool next(std::size_t elem_size, const char *&items, std::size_t &n) {
+    std::uint64_t count;
+    if (!ok_ || end_ - p_ < static_cast<std::ptrdiff_t>(sizeof count))
+      return ok_ = false;
+    std::memcpy(&count, p_, sizeof count);
+    p_ += sizeof count;
+    const auto left = static_cast<std::size_t>(end_ - p_);
+    if (count > left / elem_size)
+      return ok_ = false;
+    n = static_cast<std::size_t>(count);
+    items = p_;
+    const std::size_t padded = (n * elem_size + 7) & ~std::size_t(7);
+    p_ += padded < left ? padded : left;
+    return true;
+  }
+
+  const char *p_;
+  const char *end_;
+  bool ok_ = true;
+};
+
+// ---------------------------------------------------------------------------
+// Symbols. SymbolIds are only meaningful within one process, so the file
+// stores each symbol the module mentions as an index into its own name
+// table; loading interns the names and maps the indices back.
+// ---------------------------------------------------------------------------
+
+bool has_symbol(NodeKind k) {
+  return k == NodeKind::VarRef || k == NodeKind::AssignStmt ||
+         k == NodeKind::FuncDef;
+}
+
+// Rewrite the symbols in `ast`'s `a` column and parameter lists with `map`;
+// false if `map` rejects one.
+template <typename F> bool map_symbols(FlatAst &ast, F &&map) {
+  for (NodeId id = 0; id < ast.size(); ++id) {
+    if (!has_symbol(ast.kind[id]))
+      continue;
+    if (!map(ast.a[id]))
+      return false;
+    if (ast.kind[id] == NodeKind::FuncDef) {
+      const std::uint32_t params = ast.b[id];
+      for (std::uint32_t i = 0; i < ast.lists[params]; ++i)
+        if (!map(ast.lists[params + 1 + i]))
+          return false;
+    }
+  }
+  return true;
+}
+
+// A TypeEnv table is an array of (symbol index, TypeKind) pairs.
+using TypeTable = std::unordered_map<lexer::SymbolId, semantic::TypeKind>;
+
+template <typename F>
+void write_types(Writer &w, const TypeTable &types, F &&local) {
+  std::vector<std::uint32_t> pairs;
+  for (const auto &kv : types) {
+    pairs.push_back(local(kv.first));
+    pairs.push_back(static_cast<std::uint32_t>(kv.second));
+  }
+  w.array(pairs);
+}
+
+bool decode_types(const std::vector<std::uint32_t> &pairs,
+                  const std::vector<lexer::SymbolId> &symbols,
+                  TypeTable &out) {
+  if (pairs.size() % 2 != 0)
+    return false;
+  for (std::size_t i = 0; i < pairs.size(); i += 2) {
+    if (pairs[i] >= symbols.size() ||
+        pairs[i + 1] > static_cast<std::uint32_t>(semantic::TypeKind::Void))
+      return false;
+    out[symbols[pairs[i]]] = static_cast<semantic::TypeKind>(pairs[i + 1]);
+  }
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// Structural checks. unflatten() trusts its input, so a loaded FlatAst must
+// have in-range kinds, operators and side-table indices, and children that
+// precede their parents (post-order) and have the right category.
+// ---------------------------------------------------------------------------
+
+class Validator {
+public:
+  explicit Validator(const FlatAst &ast) : ast_(ast) {}
+
+  bool run() {
+    const std::size_t n = ast_.size();
+    if (ast_.op.size() != n || ast_.a.size() != n || ast_.b.size() != n ||
+        ast_.first.size() != n || ast_.offset.size() != n)
+      return false;
+    for (NodeId id = 0; id < n; ++id)
+      if (!row(id))
+        return false;
+    return stmt_list(ast_.module_body, static_cast<NodeId>(n));
+  }
+
+private:
+  const FlatAst &ast_;
+
+  static bool is_expr(NodeKind k) { return k < NodeKind::ExprStmt; }
+
+  // Child `c` of row `id`: an earlier expression row, or kNoNode.
+  bool expr(NodeId c, NodeId id) const {
+    return c == kNoNode || (c < id && is_expr(ast_.kind[c]));
+  }
+  bool list(std::uint32_t offset) const {
+    return offset < ast_.lists.size() &&
+           ast_.lists[offset] < ast_.lists.size() - offset;
+  }
+  bool expr_list(std::uint32_t offset, NodeId id) const {
+    if (!list(offset))
+      return false;
+    for (NodeId c : ast_.list(offset))
+      if (c == kNoNode || !expr(c, id))
+        return false;
+    return true;
+  }
+  bool stmt_list(std::uint32_t offset, NodeId id) const {
+    if (!list(offset))
+      return false;
+    for (NodeId c : ast_.list(offset))
+      if (c >= id || is_expr(ast_.kind[c]))
+        return false;
+    return true;
+  }
+  static bool bin_op(std::uint32_t op) {
+    return op <= static_cast<std::uint32_t>(parser::BinOpKind::Pow);
+  }
+
+  bool row(NodeId id) const {
+    const std::uint32_t a = ast_.a[id], b = ast_.b[id];
+    const std::uint8_t op = ast_.op[id];
+    if (ast_.first[id] > id)
+      return false;
+    switch (ast_.kind[id]) {
+    case NodeKind::NumberLiteral:
+      return b < ast_.text.size() &&
+             a < ((op & 1) == parser::NumberLiteral::Float ? ast_.floats.size()
+                                                           : ast_.ints.size());
+    case NodeKind::StringLiteral:
+      return b < ast_.text.size();
+    case NodeKind::BoolLiteral:
+    case NodeKind::VarRef:
+    case NodeKind::BreakStmt:
+    case NodeKind::ContinueStmt:
+      return true;
+    case NodeKind::CallExpr:
+      return expr(a, id) && expr_list(b, id);
+    case NodeKind::BinaryOp:
+      return bin_op(op) && !parser::is_logical(parser::BinOpKind(op)) &&
+             expr(a, id) && expr(b, id);
+    case NodeKind::LogicalExpr:
+      return parser::is_logical(parser::BinOpKind(op)) && expr(a, id) &&
+             expr(b, id);
+    case NodeKind::UnaryOp:
+      return op <= static_cast<std::uint8_t>(parser::UnOpKind::BitNot) &&
+             expr(a, id);
+    case NodeKind::CompareChain: {
+      if (!expr_list(a, id) || !list(b) ||
+          ast_.list(a).size() != ast_.list(b).size() + 1)
+        return false;
+      for (std::uint32_t chain_op : ast_.list(b))
+        if (!bin_op(chain_op) ||
+            !parser::is_comparison(parser::BinOpKind(chain_op)))
+          return false;
+      return true;
+    }
+    case NodeKind::ExprStmt:
+    case NodeKind::ReturnStmt:
+      return expr(a, id);
+    case NodeKind::AssignStmt:
+      return expr(b, id);
+    case NodeKind::FuncDef:
+      return list(b) && stmt_list(b + 1 + ast_.lists[b], id);
+    case NodeKind::IfStmt: {
+      if (!list(a) || !list(b) || ast_.list(a).size() != ast_.list(b).size())
+        return false;
+      for (NodeId c : ast_.list(a))
+        if (!expr(c, id))
+          return false;
+      for (std::uint32_t body : ast_.list(b))
+        if (!stmt_list(body, id))
+          return false;
+      return true;
+    }
+    case NodeKind::WhileStmt:
+      return expr(a, id) && stmt_list(b, id);
+    }
+    return false; // not a NodeKind
+  }
+};
+
+} // namespace
+
+CacheKey cimple::ast::make_cache_key(std::string_view source,
+                                     std::string_view options) {
+  CacheKey key;
+  key.source_hash = utils::hash_string(source);
+  key.source_size = source.size();
+  key.options_hash = utils::hash_string(options);
+  return key;
+}
+
+std::string cimple::ast::cache_path(const std::string &source_path) {
+  return source_path + "c";
+}
+
+bool cimple::ast::save_cached_module(const std::string &path,
+                                     const CacheKey &key,
+                                     const parser::Module &module,
+                                     const semantic::TypeEnv *types) {
+  FlatAst ast = flatten(module);
+
+  std::unordered_map<lexer::SymbolId, std::uint32_t> locals;
+  std::vector<std::string_view> names;
+  auto local = [&](lexer::SymbolId id) {
+    auto it = locals.emplace(id, static_cast<std::uint32_t>(names.size()));
+    if (it.second)
+      names.push_back(lexer::symbol_name(id));
+    return it.first->second;
+  };
+  map_symbols(ast, [&](std::uint32_t &sym) {
+    sym = local(sym);
+    return true;
+  });
+
+  Writer w;
+  w.value(static_cast<std::uint64_t>(ast.size()));
+  w.value(ast.module_body);
+  w.array(ast.kind);
+  w.array(ast.op);
+  w.array(ast.a);
+  w.array(ast.b);
+  w.array(ast.first);
+  w.array(ast.offset);
+  w.array(ast.lists);
+  w.array(ast.ints);
+  w.array(ast.floats);
+  w.strings(ast.text);
+  if (types) {
+    write_types(w, types->vars, local);
+    write_types(w, types->functions, local);
+  }
+  // Last, so that it includes the symbols the TypeEnv added.
+  w.strings(names);
+
+  Header h{};
+  std::memcpy(h.magic, kMagic, sizeof h.magic);
+  h.format = kFormatVersion;
+  h.byte_order = kByteOrderMark;
+  h.compiler = compiler_id();
+  h.source_hash = key.source_hash;
+  h.source_size = key.source_size;
+  h.options_hash = key.options_hash;
+  h.payload_size = w.data().size();
+  h.payload_hash = utils::hash_string(w.data());
+  h.flags = types ? kHasTypes : 0;
+
+  // Write a temporary and rename it over the cache, so a reader never sees
+  // a partial file.
+  const std::string tmp = path + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&h), sizeof h);
+    out.write(w.data().data(), static_cast<std::streamsize>(w.data().size()));
+    if (!out.flush()) {
+      out.close();
+      std::remove(tmp.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    // Windows will not rename over an existing file.
+    std::remove(path.c_str());
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+      std::remove(tmp.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+std::optional<CachedModule>
+cimple::ast::load_cached_module(const std::string &path, const CacheKey &key) {
+  auto file = utils::SourceBuffer::open(path);
+  if (!file || file->size() < sizeof(Header))
+    return std::nullopt;
+
+  Header h;
+  std::memcpy(&h, file->data(), sizeof h);
+  const char *payload = file->data() + sizeof h;
+  const std::size_t payload_size = file->size() - sizeof h;
+  if (std::memcmp(h.magic, kMagic, sizeof kMagic) != 0 ||
+      h.format != kFormatVersion || h.byte_order != kByteOrderMark ||
+      h.compiler != compiler_id() || h.source_hash != key.source_hash ||
+      h.source_size != key.source_size || h.options_hash != key.options_hash ||
+      h.payload_size != payload_size ||
+      h.payload_hash != utils::hash_bytes(payload, payload_size))
+    return std::nullopt;
+
+  Reader r(payload, payload_size);
+  FlatAst ast;
+  std::uint64_t rows = 0;
+  r.value(rows);
+  r.value(ast.module_body);
+  r.array(ast.kind);
+  r.array(ast.op);
+  r.array(ast.a);
+  r.array(ast.b);
+  r.array(ast.first);
+  r.array(ast.offset);
+  r.array(ast.lists);
+  r.array(ast.ints);
+  r.array(ast.floats);
+  r.strings(ast.text);
+  std::vector<std::uint32_t> var_types, function_types;
+  const bool has_types = h.flags & kHasTypes;
+  if (has_types) {
+    r.array(var_types);
+    r.array(function_types);
+  }
+  std::vector<std::string_view> names;
+  r.strings(names);
+  if (!r.ok() || !r.at_end() || rows != ast.size() || !Validator(ast).run())
+    return std::nullopt;
+
+  std::vector<lexer::SymbolId> symbols;
+  symbols.reserve(names.size());
+  for (std::string_view name : names)
+    symbols.push_back(lexer::intern(name));
+  const bool symbols_ok = map_symbols(ast, [&](std::uint32_t &sym) {
+    if (sym >= symbols.size())
+      return false;
+    sym = symbols[sym];
+    return true;
+  });
+  if (!symbols_ok)
+    return std::nullopt;
+
+  CachedModule cached{unflatten(ast), std::nullopt};
+  if (has_types) {
+    semantic::TypeEnv env;
+    if (!decode_types(var_types, symbols, env.vars) ||
+        !decode_types(function_types, symbols, env.functions))
+      return std::nullopt;
+    cached.types = std::move(env);
+  }
+  return cached;
+}
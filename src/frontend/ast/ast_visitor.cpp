@@ -1 +1,52 @@
-// ast_visitor.cpp - stub
+// ast_visitor.cpp - node kind names and the visitors' fallback
+#include "frontend/ast/ast_visitor.h"
+#include <cstdio>
+#include <cstdlib>
+
+using namespace cimple;
+
+const char *cimple::ast::node_kind_name(NodeKind kind) {
+  switch (kind) {
+  case NodeKind::NumberLiteral:
+    return "NumberLiteral";
+  case NodeKind::StringLiteral:
+    return "StringLiteral";
+  case NodeKind::BoolLiteral:
+    return "BoolLiteral";
+  case NodeKind::VarRef:
+    return "VarRef";
+  case NodeKind::CallExpr:
+    return "CallExpr";
+  case NodeKind::BinaryOp:
+    return "BinaryOp";
+  case NodeKind::UnaryOp:
+    return "UnaryOp";
+  case NodeKind::LogicalExpr:
+    return "LogicalExpr";
+  case NodeKind::CompareChain:
+    return "CompareChain";
+  case NodeKind::ExprStmt:
+    return "ExprStmt";
+  case NodeKind::AssignStmt:
+    return "AssignStmt";
+  case NodeKind::ReturnStmt:
+    return "ReturnStmt";
+  case NodeKind::FuncDef:
+    return "FuncDef";
+  case NodeKind::IfStmt:
+    return "IfStmt";
+  case NodeKind::WhileStmt:
+    return "WhileStmt";
+  case NodeKind::BreakStmt:
+    return "BreakStmt";
+  case NodeKind::ContinueStmt:
+    return "ContinueStmt";
+  }
+  return "?";
+}
+
+void cimple::ast::unhandled_node(const parser::Node *node) {
+  std::fprintf(stderr, "internal error: unhandled AST node %s\n",
+               node_kind_name(node->kind));
+  std::abort();
+}
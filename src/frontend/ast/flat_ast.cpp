@@ -0,0 +1,345 @@
+// flat_ast.cpp - build the structure-of-arrays form of a parsed module
+#include "frontend/ast/flat_ast.h"
+#include "frontend/ast/ast_visitor.h"
+#include <cstdlib>
+#include <new>
+
+using namespace cimple;
+using namespace cimple::ast;
+
+namespace {
+
+class Flattener {
+public:
+  explicit Flattener(FlatAst &out) : out_(out) {}
+
+  std::uint32_t module_body(const parser::StmtList &body) {
+    return stmt_list(body);
+  }
+
+private:
+  FlatAst &out_;
+  // Ids of a list being collected; nested lists push above their parent's
+  // entries, as in the parser.
+  std::vector<std::uint32_t> stack_;
+
+  NodeId next_id() const { return static_cast<NodeId>(out_.kind.size()); }
+
+  NodeId row(const parser::Node *n, NodeId first, std::uint8_t op,
+             std::uint32_t a, std::uint32_t b) {
+    const NodeId id = next_id();
+    out_.kind.push_back(n->kind);
+    out_.offset.push_back(n->offset);
+    out_.op.push_back(op);
+    out_.a.push_back(a);
+    out_.b.push_back(b);
+    out_.first.push_back(first);
+    return id;
+  }
+
+  std::uint32_t add_text(std::string_view s) {
+    out_.text.push_back(s);
+    return static_cast<std::uint32_t>(out_.text.size() - 1);
+  }
+
+  // Move stack_[mark, end) into `lists`; returns the list's offset.
+  std::uint32_t pop_list(std::size_t mark) {
+    const auto offset = static_cast<std::uint32_t>(out_.lists.size());
+    out_.lists.push_back(static_cast<std::uint32_t>(stack_.size() - mark));
+    out_.lists.insert(out_.lists.end(), stack_.begin() + mark, stack_.end());
+    stack_.resize(mark);
+    return offset;
+  }
+
+  std::uint32_t expr_list(const parser::ExprList &list) {
+    const std::size_t mark = stack_.size();
+    for (const parser::Expr *e : list)
+      stack_.push_back(expr(e));
+    return pop_list(mark);
+  }
+
+  std::uint32_t stmt_list(const parser::StmtList &list) {
+    const std::size_t mark = stack_.size();
+    for (const parser::Stmt *s : list)
+      if (s)
+        stack_.push_back(stmt(s));
+    return pop_list(mark);
+  }
+
+  NodeId expr(const parser::Expr *e) {
+    if (!e)
+      return kNoNode;
+    const NodeId first = next_id();
+    switch (e->kind) {
+    case NodeKind::NumberLiteral: {
+      auto n = parser::cast<parser::NumberLiteral>(e);
+      const auto op = static_cast<std::uint8_t>(
+          n->num_kind | (n->in_range ? 0 : kOutOfRange));
+      std::uint32_t payload;
+      if (n->is_float()) {
+        payload = static_cast<std::uint32_t>(out_.floats.size());
+        out_.floats.push_back(n->float_value);
+      } else {
+        payload = static_cast<std::uint32_t>(out_.ints.size());
+        out_.ints.push_back(n->int_value);
+      }
+      return row(e, first, op, payload, add_text(n->value));
+    }
+    case NodeKind::StringLiteral:
+      return row(e, first, 0, 0,
+                 add_text(parser::cast<parser::StringLiteral>(e)->value));
+    case NodeKind::BoolLiteral:
+      return row(e, first, parser::cast<parser::BoolLiteral>(e)->value ? 1 : 0,
+                 0, 0);
+    case NodeKind::VarRef:
+      return row(e, first, 0, parser::cast<parser::VarRef>(e)->id, 0);
+    case NodeKind::CallExpr: {
+      auto c = parser::cast<parser::CallExpr>(e);
+      const NodeId callee = expr(c->callee);
+      const std::uint32_t args = expr_list(c->args);
+      return row(e, first, 0, callee, args);
+    }
+    case NodeKind::BinaryOp: {
+      auto bin = parser::cast<parser::BinaryOp>(e);
+      const NodeId left = expr(bin->left);
+      const NodeId right = expr(bin->right);
+      return row(e, first, static_cast<std::uint8_t>(bin->op), left, right);
+    }
+    case NodeKind::LogicalExpr: {
+      auto lg = parser::cast<parser::LogicalExpr>(e);
+      const NodeId left = expr(lg->left);
+      const NodeId right = expr(lg->right);
+      return row(e, first, static_cast<std::uint8_t>(lg->op), left, right);
+    }
+    case NodeKind::UnaryOp: {
+      auto u = parser::cast<parser::UnaryOp>(e);
+      const NodeId operand = expr(u->operand);
+      return row(e, first, static_cast<std::uint8_t>(u->op), operand, 0);
+    }
+    case NodeKind::CompareChain: {
+      auto ch = parser::cast<parser::CompareChain>(e);
+      const std::uint32_t operands = expr_list(ch->operands);
+      const std::size_t mark = stack_.size();
+      for (parser::BinOpKind op : ch->ops)
+        stack_.push_back(static_cast<std::uint32_t>(op));
+      return row(e, first, 0, operands, pop_list(mark));
+    }
+    default:
+      unhandled_node(e);
+    }
+  }
+
+  NodeId stmt(const parser::Stmt *s) {
+    const NodeId first = next_id();
+    switch (s->kind) {
+    case NodeKind::ExprStmt:
+      return row(s, first, 0,
+                 expr(parser::cast<parser::ExprStmt>(s)->expr), 0);
+    case NodeKind::AssignStmt: {
+      auto as = parser::cast<parser::AssignStmt>(s);
+      return row(s, first, 0, as->target_id, expr(as->value));
+    }
+    case NodeKind::ReturnStmt:
+      return row(s, first, 0,
+                 expr(parser::cast<parser::ReturnStmt>(s)->value), 0);
+    case NodeKind::FuncDef: {
+      // The body's rows come first; its list is written right after the
+      // parameter list so one offset locates both.
+      auto fn = parser::cast<parser::FuncDef>(s);
+      const std::size_t mark = stack_.size();
+      for (const parser::Stmt *child : fn->body)
+        if (child)
+          stack_.push_back(stmt(child));
+      const auto params = static_cast<std::uint32_t>(out_.lists.size());
+      out_.lists.push_back(static_cast<std::uint32_t>(fn->param_ids.size()));
+      out_.lists.insert(out_.lists.end(), fn->param_ids.begin(),
+                        fn->param_ids.end());
+      pop_list(mark);
+      return row(s, first, 0, fn->name_id, params);
+    }
+    case NodeKind::IfStmt: {
+      auto is = parser::cast<parser::IfStmt>(s);
+      const std::size_t mark = stack_.size();
+      for (const parser::IfBranch &branch : is->branches) {
+        stack_.push_back(expr(branch.condition));
+        stack_.push_back(stmt_list(branch.body));
+      }
+      // Split the (condition, body) pairs into two parallel lists.
+      const std::size_t n = (stack_.size() - mark) / 2;
+      const auto conditions = static_cast<std::uint32_t>(out_.lists.size());
+      out_.lists.push_back(static_cast<std::uint32_t>(n));
+      for (std::size_t i = 0; i < n; ++i)
+        out_.lists.push_back(stack_[mark + 2 * i]);
+      const auto bodies = static_cast<std::uint32_t>(out_.lists.size());
+      out_.lists.push_back(static_cast<std::uint32_t>(n));
+      for (std::size_t i = 0; i < n; ++i)
+        out_.lists.push_back(stack_[mark + 2 * i + 1]);
+      stack_.resize(mark);
+      return row(s, first, 0, conditions, bodies);
+    }
+    case NodeKind::WhileStmt: {
+      auto ws = parser::cast<parser::WhileStmt>(s);
+      const NodeId condition = expr(ws->condition);
+      const std::uint32_t body = stmt_list(ws->body);
+      return row(s, first, 0, condition, body);
+    }
+    case NodeKind::BreakStmt:
+    case NodeKind::ContinueStmt:
+      return row(s, first, 0, 0, 0);
+    default:
+      unhandled_node(s);
+    }
+  }
+};
+
+// Rebuilds the pointer tree row by row. Post-order means every child row
+// has already been turned into a node when its parent's row is reached.
+class Unflattener {
+public:
+  Unflattener(const FlatAst &ast, parser::Arena &arena)
+      : ast_(ast), arena_(arena), nodes_(ast.size(), nullptr) {
+    for (NodeId id = 0; id < ast.size(); ++id)
+      nodes_[id] = build(ast.node(id));
+  }
+
+  parser::StmtList stmt_list(ListRef ids) {
+    return span<parser::Stmt *>(ids, [&](NodeId id) { return stmt(id); });
+  }
+
+private:
+  const FlatAst &ast_;
+  parser::Arena &arena_;
+  std::vector<parser::Node *> nodes_;
+
+  parser::Expr *expr(NodeId id) const {
+    return id == kNoNode ? nullptr : static_cast<parser::Expr *>(nodes_[id]);
+  }
+  parser::Stmt *stmt(NodeId id) const {
+    return static_cast<parser::Stmt *>(nodes_[id]);
+  }
+
+  template <typename T, typename F>
+  parser::ArenaSpan<T> span(ListRef items, F &&convert) {
+    T *data = static_cast<T *>(
+        arena_.allocate(items.size() * sizeof(T), alignof(T)));
+    for (std::size_t i = 0; i < items.size(); ++i)
+      new (data + i) T(convert(items[i]));
+    return parser::ArenaSpan<T>(data, items.size());
+  }
+
+  parser::ExprList expr_list(ListRef ids) {
+    return span<parser::Expr *>(ids, [&](NodeId id) { return expr(id); });
+  }
+
+  std::string_view text(NodeRef n) { return arena_.copy_string(n.text()); }
+
+  parser::Node *build(NodeRef n) {
+    parser::Node *node = make(n);
+    node->offset = n.offset();
+    return node;
+  }
+
+  parser::Node *make(NodeRef n) {
+    switch (n.kind()) {
+    case NodeKind::NumberLiteral:
+      return arena_.make<parser::NumberLiteral>(text(n));
+    case NodeKind::StringLiteral:
+      return arena_.make<parser::StringLiteral>(text(n));
+    case NodeKind::BoolLiteral:
+      return arena_.make<parser::BoolLiteral>(n.bool_value());
+    case NodeKind::VarRef:
+      return arena_.make<parser::VarRef>(n.symbol());
+    case NodeKind::CallExpr: {
+      auto call = arena_.make<parser::CallExpr>();
+      call->callee = expr(n.callee().id());
+      call->args = expr_list(n.args());
+      return call;
+    }
+    case NodeKind::BinaryOp:
+      return arena_.make<parser::BinaryOp>(n.bin_op(), expr(n.left().id()),
+                                           expr(n.right().id()));
+    case NodeKind::LogicalExpr:
+      return arena_.make<parser::LogicalExpr>(
+          n.bin_op(), expr(n.left().id()), expr(n.right().id()));
+    case NodeKind::UnaryOp:
+      return arena_.make<parser::UnaryOp>(n.un_op(), expr(n.operand().id()));
+    case NodeKind::CompareChain: {
+      auto chain = arena_.make<parser::CompareChain>();
+      chain->operands = expr_list(n.operands());
+      chain->ops = span<parser::BinOpKind>(n.chain_ops(), [](std::uint32_t op) {
+        return static_cast<parser::BinOpKind>(op);
+      });
+      return chain;
+    }
+    case NodeKind::ExprStmt:
+      return arena_.make<parser::ExprStmt>(expr(n.expr().id()));
+    case NodeKind::AssignStmt:
+      return arena_.make<parser::AssignStmt>(n.symbol(),
+                                             expr(n.value().id()));
+    case NodeKind::ReturnStmt:
+      return arena_.make<parser::ReturnStmt>(expr(n.value().id()));
+    case NodeKind::FuncDef: {
+      auto fn = arena_.make<parser::FuncDef>();
+      fn->name_id = n.symbol();
+      fn->name = lexer::symbol_name(fn->name_id);
+      fn->param_ids = span<lexer::SymbolId>(
+          n.params(), [](std::uint32_t id) { return id; });
+      fn->params = span<std::string_view>(
+          n.params(), [](std::uint32_t id) { return lexer::symbol_name(id); });
+      fn->body = stmt_list(n.body());
+      return fn;
+    }
+    case NodeKind::IfStmt: {
+      auto is = arena_.make<parser::IfStmt>();
+      const ListRef conditions = n.conditions();
+      const ListRef bodies = n.bodies();
+      is->branches = span<parser::IfBranch>(
+          conditions, [&, i = std::size_t(0)](NodeId id) mutable {
+            parser::IfBranch branch;
+            branch.condition = expr(id);
+            branch.body = stmt_list(n.list(bodies[i++]));
+            return branch;
+          });
+      return is;
+    }
+    case NodeKind::WhileStmt: {
+      auto ws = arena_.make<parser::WhileStmt>();
+      ws->condition = expr(n.condition().id());
+      ws->body = stmt_list(n.body());
+      return ws;
+    }
+    case NodeKind::BreakStmt:
+      return arena_.make<parser::BreakStmt>();
+    case NodeKind::ContinueStmt:
+      return arena_.make<parser::ContinueStmt>();
+    }
+    std::abort(); // every kind is handled above
+  }
+};
+
+template <typename T> std::size_t column_bytes(const std::vector<T> &v) {
+  return v.capacity() * sizeof(T);
+}
+
+} // namespace
+
+std::size_t FlatAst::bytes() const {
+  return column_bytes(kind) + column_bytes(op) + column_bytes(a) +
+         column_bytes(b) + column_bytes(first) + column_bytes(offset) +
+         column_bytes(lists) + column_bytes(ints) + column_bytes(floats) +
+         column_bytes(text);
+}
+
+FlatAst cimple::ast::flatten(const parser::Module &module) {
+  FlatAst ast;
+  Flattener flattener(ast);
+  ast.module_body = flattener.module_body(module.body);
+  return ast;
+}
+
+parser::Module cimple::ast::unflatten(const FlatAst &ast) {
+  parser::Module module;
+  Unflattener unflattener(ast, module.arena);
+  module.body = unflattener.stmt_list(ast.body());
+  return module;
+}
@@ -0,0 +1,298 @@
+// bytecode.cpp - opcode names and disassembler
+#include "frontend/eval/bytecode.h"
+#include <sstream>
+
+using namespace cimple;
+using namespace cimple::eval;
+
+const char *cimple::eval::opcode_name(OpCode op) {
+  switch (op) {
+  case OpCode::LoadK:
+    return "LOADK";
+  case OpCode::LoadNil:
+    return "LOADNIL";
+  case OpCode::LoadBool:
+    return "LOADBOOL";
+  case OpCode::Move:
+    return "MOVE";
+  case OpCode::SetLocal:
+    return "SETLOCAL";
+  case OpCode::GetGlobal:
+    return "GETGLOBAL";
+  case OpCode::InheritGlobal:
+    return "INHERITGLOBAL";
+  case OpCode::Add:
+    return "ADD";
+  case OpCode::Sub:
+    return "SUB";
+  case OpCode::Mul:
+    return "MUL";
+  case OpCode::Div:
+    return "DIV";
+  case OpCode::FloorDiv:
+    return "FLOORDIV";
+  case OpCode::Mod:
+    return "MOD";
+  case OpCode::Pow:
+    return "POW";
+  case OpCode::BitAnd:
+    return "BAND";
+  case OpCode::BitOr:
+    return "BOR";
+  case OpCode::BitXor:
+    return "BXOR";
+  case OpCode::Shl:
+    return "SHL";
+  case OpCode::Shr:
+    return "SHR";
+  case OpCode::Eq:
+    return "EQ";
+  case OpCode::Ne:
+    return "NE";
+  case OpCode::Lt:
+    return "LT";
+  case OpCode::Gt:
+    return "GT";
+  case OpCode::Le:
+    return "LE";
+  case OpCode::Ge:
+    return "GE";
+  case OpCode::Neg:
+    return "NEG";
+  case OpCode::Not:
+    return "NOT";
+  case OpCode::BitNot:
+    return "BNOT";
+  case OpCode::ToBool:
+    return "TOBOOL";
+  case OpCode::Jmp:
+    return "JMP";
+  case OpCode::JmpIfFalse:
+    return "JMPF";
+  case OpCode::JmpIfTrue:
+    return "JMPT";
+  case OpCode::JmpIfUnset:
+    return "JMPUNSET";
+  case OpCode::Call:
+    return "CALL";
+  case OpCode::Print:
+    return "PRINT";
+  case OpCode::PrintLn:
+    return "PRINTLN";
+  case OpCode::Ret:
+    return "RET";
+  case OpCode::RetNil:
+    return "RETNIL";
+  case OpCode::Escape:
+    return "ESCAPE";
+  case OpCode::AddLocalK:
+    return "ADDLOCALK";
+  case OpCode::SubLocalK:
+    return "SUBLOCALK";
+  case OpCode::LoadKAdd:
+    return "LOADK+ADD";
+  case OpCode::LoadKSub:
+    return "LOADK+SUB";
+  case OpCode::EqJmp:
+    return "EQ+JMP";
+  case OpCode::NeJmp:
+    return "NE+JMP";
+  case OpCode::LtJmp:
+    return "LT+JMP";
+  case OpCode::GtJmp:
+    return "GT+JMP";
+  case OpCode::LeJmp:
+    return "LE+JMP";
+  case OpCode::GeJmp:
+    return "GE+JMP";
+  case OpCode::AddInt:
+    return "ADD.I";
+  case OpCode::SubInt:
+    return "SUB.I";
+  case OpCode::MulInt:
+    return "MUL.I";
+  case OpCode::AddFloat:
+    return "ADD.F";
+  case OpCode::SubFloat:
+    return "SUB.F";
+  case OpCode::MulFloat:
+    return "MUL.F";
+  case OpCode::DivFloat:
+    return "DIV.F";
+  case OpCode::Halt:
+    return "HALT";
+  }
+  return "<bad-op>";
+}
+
+OpCode cimple::eval::quickened_opcode(OpCode op, Value::Kind kind) {
+  if (kind == Value::Int) {
+    switch (op) {
+    case OpCode::Add:
+      return OpCode::AddInt;
+    case OpCode::Sub:
+      return OpCode::SubInt;
+    case OpCode::Mul:
+      return OpCode::MulInt;
+    default: // int / int may be either type
+      return op;
+    }
+  }
+  if (kind == Value::Float) {
+    switch (op) {
+    case OpCode::Add:
+      return OpCode::AddFloat;
+    case OpCode::Sub:
+      return OpCode::SubFloat;
+    case OpCode::Mul:
+      return OpCode::MulFloat;
+    case OpCode::Div:
+      return OpCode::DivFloat;
+    default:
+      return op;
+    }
+  }
+  return op;
+}
+
+OpCode cimple::eval::generic_opcode(OpCode op) {
+  switch (op) {
+  case OpCode::AddInt:
+  case OpCode::AddFloat:
+    return OpCode::Add;
+  case OpCode::SubInt:
+  case OpCode::SubFloat:
+    return OpCode::Sub;
+  case OpCode::MulInt:
+  case OpCode::MulFloat:
+    return OpCode::Mul;
+  case OpCode::DivFloat:
+    return OpCode::Div;
+  default:
+    return op;
+  }
+}
+
+namespace {
+
+// The superinstruction for `first` followed by `second`, or Halt if the
+// pair does not fuse.
+OpCode fused_opcode(const Instr &first, const Instr &second) {
+  if (first.op == OpCode::LoadK) {
+    if (generic_opcode(second.op) == OpCode::Add)
+      return OpCode::LoadKAdd;
+    if (generic_opcode(second.op) == OpCode::Sub)
+      return OpCode::LoadKSub;
+    return OpCode::Halt;
+  }
+  // The branch must test the comparison's result.
+  if ((second.op != OpCode::JmpIfFalse && second.op != OpCode::JmpIfTrue) ||
+      second.a != first.a)
+    return OpCode::Halt;
+  switch (first.op) {
+  case OpCode::Eq:
+    return OpCode::EqJmp;
+  case OpCode::Ne:
+    return OpCode::NeJmp;
+  case OpCode::Lt:
+    return OpCode::LtJmp;
+  case OpCode::Gt:
+    return OpCode::GtJmp;
+  case OpCode::Le:
+    return OpCode::LeJmp;
+  case OpCode::Ge:
+    return OpCode::GeJmp;
+  default:
+    return OpCode::Halt;
+  }
+}
+
+void disassemble_function(std::ostringstream &os, const Program &program,
+                          const Function &fn) {
+  os << "function " << fn.name << "(";
+  for (std::size_t i = 0; i < fn.num_params; ++i)
+    os << (i ? ", " : "") << fn.slot_names[i];
+  os << ")  regs=" << fn.num_regs << " consts=" << fn.constants.size()
+     << "\n";
+  os << "  slots:";
+  for (std::size_t i = 0; i < fn.slot_names.size(); ++i)
+    os << " r" << i << "=" << fn.slot_names[i];
+  os << "\n";
+
+  for (std::size_t pc = 0; pc < fn.code.size(); ++pc) {
+    const Instr &ins = fn.code[pc];
+    os << "  " << pc << "\t" << opcode_name(ins.op) << "\t";
+    switch (ins.op) {
+    case OpCode::LoadK:
+    case OpCode::LoadKAdd:
+    case OpCode::LoadKSub:
+    case OpCode::AddLocalK:
+    case OpCode::SubLocalK:
+      os << "r" << ins.a << ", k" << ins.bx() << "\t; "
+         << fn.constants[ins.bx()].to_string();
+      break;
+    case OpCode::GetGlobal:
+    case OpCode::InheritGlobal:
+      os << "r" << ins.a << ", g" << ins.bx() << "\t; "
+         << program.main.slot_names[ins.bx()];
+      break;
+    case OpCode::LoadNil:
+    case OpCode::Print:
+    case OpCode::PrintLn:
+    case OpCode::Ret:
+      os << "r" << ins.a;
+      break;
+    case OpCode::LoadBool:
+      os << "r" << ins.a << ", " << (ins.n ? "True" : "False");
+      break;
+    case OpCode::Move:
+    case OpCode::SetLocal:
+    case OpCode::Neg:
+    case OpCode::Not:
+    case OpCode::BitNot:
+    case OpCode::ToBool:
+      os << "r" << ins.a << ", r" << ins.b;
+      break;
+    case OpCode::Jmp:
+      os << "-> " << ins.bx();
+      break;
+    case OpCode::JmpIfFalse:
+    case OpCode::JmpIfTrue:
+    case OpCode::JmpIfUnset:
+      os << "r" << ins.a << " -> " << ins.bx();
+      break;
+    case OpCode::Call:
+      os << "r" << ins.a << ", " << program.functions[ins.b].name << "(r"
+         << ins.c << " x" << static_cast<int>(ins.n) << ")";
+      break;
+    case OpCode::RetNil:
+    case OpCode::Escape:
+    case OpCode::Halt:
+      break;
+    default:
+      os << "r" << ins.a << ", r" << ins.b << ", r" << ins.c;
+      break;
+    }
+    os << "\n";
+  }
+}
+
+} // namespace
+
+void cimple::eval::fuse_superinstructions(std::vector<Instr> &code) {
+  for (std::size_t pc = 0; pc + 1 < code.size(); ++pc) {
+    const OpCode fused = fused_opcode(code[pc], code[pc + 1]);
+    if (fused != OpCode::Halt)
+      code[pc++].op = fused; // the second instruction is not a first one
+  }
+}
+
+std::string cimple::eval::disassemble(const Program &program) {
+  std::ostringstream os;
+  for (const Function &fn : program.functions) {
+    disassemble_function(os, program, fn);
+    os << "\n";
+  }
+  disassemble_function(os, program, program.main);
+  return os.str();
+}
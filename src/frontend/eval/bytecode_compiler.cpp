@@ -0,0 +1,770 @@
+// bytecode_compiler.cpp - lower parser::Module to register bytecode
+#include "frontend/eval/bytecode_compiler.h"
+#include "frontend/semantic/resolver.h"
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+using namespace cimple;
+using namespace cimple::eval;
+
+namespace {
+
+constexpr std::uint32_t kMaxRegs = std::numeric_limits<std::uint16_t>::max();
+constexpr std::uint32_t kMaxArgs = std::numeric_limits<std::uint8_t>::max();
+
+using FunctionIndex = std::unordered_map<lexer::SymbolId, std::uint16_t>;
+
+// Signals that the module cannot be encoded; caught by compile_program.
+struct CompileLimit : std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+OpCode unary_opcode(parser::UnOpKind op) {
+  switch (op) {
+  case parser::UnOpKind::Not:
+    return OpCode::Not;
+  case parser::UnOpKind::Neg:
+    return OpCode::Neg;
+  case parser::UnOpKind::BitNot:
+    return OpCode::BitNot;
+  }
+  return OpCode::Not;
+}
+
+OpCode binary_opcode(parser::BinOpKind op) {
+  switch (op) {
+  case parser::BinOpKind::Add:
+    return OpCode::Add;
+  case parser::BinOpKind::Sub:
+    return OpCode::Sub;
+  case parser::BinOpKind::Mul:
+    return OpCode::Mul;
+  case parser::BinOpKind::Div:
+    return OpCode::Div;
+  case parser::BinOpKind::FloorDiv:
+    return OpCode::FloorDiv;
+  case parser::BinOpKind::Mod:
+    return OpCode::Mod;
+  case parser::BinOpKind::Pow:
+    return OpCode::Pow;
+  case parser::BinOpKind::BitAnd:
+    return OpCode::BitAnd;
+  case parser::BinOpKind::BitOr:
+    return OpCode::BitOr;
+  case parser::BinOpKind::BitXor:
+    return OpCode::BitXor;
+  case parser::BinOpKind::Shl:
+    return OpCode::Shl;
+  case parser::BinOpKind::Shr:
+    return OpCode::Shr;
+  case parser::BinOpKind::Eq:
+    return OpCode::Eq;
+  case parser::BinOpKind::Ne:
+    return OpCode::Ne;
+  case parser::BinOpKind::Lt:
+    return OpCode::Lt;
+  case parser::BinOpKind::Gt:
+    return OpCode::Gt;
+  case parser::BinOpKind::Le:
+    return OpCode::Le;
+  case parser::BinOpKind::Ge:
+    return OpCode::Ge;
+  case parser::BinOpKind::And:
+  case parser::BinOpKind::Or:
+    break; // LogicalExpr only
+  }
+  throw CompileLimit(std::string("no opcode for operator '") +
+                     parser::op_spelling(op) + "'");
+}
+
+class FunctionCompiler {
+public:
+  FunctionCompiler(Function &out, const FunctionIndex &functions,
+                   const semantic::Resolution &names,
+                   const semantic::FrameLayout &layout,
+                   const semantic::TypeEnv *types, bool is_main)
+      : fn_(out), functions_(functions), names_(names), types_(types),
+        is_main_(is_main), next_reg_(layout.num_slots) {
+    if (layout.num_slots > kMaxRegs)
+      throw CompileLimit("function '" + fn_.name + "' has too many variables");
+    fn_.num_params = layout.num_params;
+    fn_.scope_slots = layout.scope_slots;
+    fn_.num_regs = layout.num_slots;
+    fn_.slot_names = layout.slot_names;
+  }
+
+  // Function body. The prologue lets function-scope names that shadow a
+  // global read it until assigned (and stand in for missing arguments).
+  void compile_body(const parser::StmtList &body,
+                    const semantic::FrameLayout &layout) {
+    for (const auto &inherit : layout.inherit_globals)
+      emit_bx(OpCode::InheritGlobal, inherit.first, inherit.second);
+    for (const auto &stmt : body)
+      compile_stmt(stmt);
+    emit(OpCode::RetNil);
+    fuse_superinstructions(fn_.code);
+  }
+
+  // Module body: every top-level statement is an independent unit. A
+  // `return`, `break` or `continue` that escapes one only abandons that
+  // statement, exactly like the evaluator's module loop ignoring the signal.
+  void compile_module(const parser::Module &module) {
+    for (const auto &stmt : module.body) {
+      compile_stmt(stmt);
+      patch_to_here(stmt_exits_);
+      stmt_exits_.clear();
+    }
+    emit(OpCode::Halt);
+    fuse_superinstructions(fn_.code);
+  }
+
+private:
+  struct Loop {
+    std::vector<std::size_t> continues; // jumps to the condition
+    std::vector<std::size_t> breaks;
+  };
+
+  Function &fn_;
+  const FunctionIndex &functions_;
+  const semantic::Resolution &names_;
+  const semantic::TypeEnv *types_; // optional
+  const bool is_main_;
+
+  std::uint32_t next_reg_;
+  std::vector<Loop> loops_;
+  std::vector<std::size_t> stmt_exits_;
+  // Literals loaded once ahead of the loop whose condition uses them.
+  std::unordered_map<const parser::Expr *, std::uint32_t> hoisted_;
+  // Inferred expression types, memoized by static_type().
+  std::unordered_map<const parser::Expr *, semantic::TypeKind> expr_types_;
+
+  std::unordered_map<long long, std::uint32_t> int_consts_;
+  std::unordered_map<std::uint64_t, std::uint32_t> float_consts_;
+  std::unordered_map<std::string, std::uint32_t> string_consts_;
+
+  // -------------------------------------------------------------------------
+  // Emission helpers
+  // -------------------------------------------------------------------------
+
+  std::size_t emit(OpCode op, std::uint32_t a = 0, std::uint32_t b = 0,
+                   std::uint32_t c = 0, std::uint32_t n = 0) {
+    Instr ins;
+    ins.op = op;
+    ins.a = static_cast<std::uint16_t>(a);
+    ins.b = static_cast<std::uint16_t>(b);
+    ins.c = static_cast<std::uint16_t>(c);
+    ins.n = static_cast<std::uint8_t>(n);
+    fn_.code.push_back(ins);
+    return fn_.code.size() - 1;
+  }
+
+  std::size_t emit_bx(OpCode op, std::uint32_t a, std::uint32_t bx) {
+    std::size_t at = emit(op, a);
+    fn_.code[at].set_bx(bx);
+    return at;
+  }
+
+  std::size_t here() const { return fn_.code.size(); }
+
+  void patch(std::size_t at, std::size_t target) {
+    fn_.code[at].set_bx(static_cast<std::uint32_t>(target));
+  }
+
+  void patch_to_here(const std::vector<std::size_t> &sites) {
+    for (std::size_t at : sites)
+      patch(at, here());
+  }
+
+  std::uint32_t alloc_reg() {
+    if (next_reg_ >= kMaxRegs)
+      throw CompileLimit("function '" + fn_.name + "' needs too many registers");
+    std::uint32_t r = next_reg_++;
+    if (next_reg_ > fn_.num_regs)
+      fn_.num_regs = next_reg_;
+    return r;
+  }
+
+  std::uint32_t add_constant(Value v) {
+    fn_.constants.push_back(std::move(v));
+    return static_cast<std::uint32_t>(fn_.constants.size() - 1);
+  }
+
+  std::uint32_t int_constant(long long v) {
+    auto it = int_consts_.find(v);
+    if (it != int_consts_.end())
+      return it->second;
+    return int_consts_[v] = add_constant(Value::integer(v));
+  }
+
+  std::uint32_t float_constant(double v) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &v, sizeof bits);
+    auto it = float_consts_.find(bits);
+    if (it != float_consts_.end())
+      return it->second;
+    return float_consts_[bits] = add_constant(Value::floating(v));
+  }
+
+  std::uint32_t string_constant(const std::string &s) {
+    auto it = string_consts_.find(s);
+    if (it != string_consts_.end())
+      return it->second;
+    return string_consts_[s] = add_constant(Value::string(s));
+  }
+
+  // -------------------------------------------------------------------------
+  // Statements
+  // -------------------------------------------------------------------------
+
+  // Seed a block scope's slots from the bindings just outside it.
+  void enter_block(const parser::StmtList &body) {
+    for (const auto &init : names_.block(&body).init) {
+      const semantic::VarBinding &outer = init.second;
+      switch (outer.kind) {
+      case semantic::VarBinding::Local:
+        emit(OpCode::Move, init.first, outer.slot);
+        break;
+      case semantic::VarBinding::Global:
+        emit_bx(OpCode::GetGlobal, init.first, outer.slot);
+        break;
+      case semantic::VarBinding::Unbound:
+        emit(OpCode::LoadNil, init.first);
+        break;
+      }
+    }
+  }
+
+  // Leave the current function (or, in <main>, the current top-level
+  // statement) with `value` as the result.
+  void emit_return(std::uint32_t value) {
+    if (is_main_)
+      stmt_exits_.push_back(emit(OpCode::Jmp));
+    else
+      emit(OpCode::Ret, value);
+  }
+
+  // break/continue with no enclosing loop.
+  void emit_stray_loop_control() {
+    if (is_main_)
+      stmt_exits_.push_back(emit(OpCode::Jmp));
+    else
+      emit(OpCode::Escape);
+  }
+
+  void compile_stmt(const parser::Stmt *stmt) {
+    if (!stmt)
+      return;
+    const std::uint32_t mark = next_reg_;
+
+    switch (stmt->kind) {
+    case parser::NodeKind::AssignStmt:
+      compile_assign(parser::cast<parser::AssignStmt>(stmt));
+      break;
+    case parser::NodeKind::ExprStmt:
+      compile_expr(parser::cast<parser::ExprStmt>(stmt)->expr, alloc_reg());
+      break;
+    case parser::NodeKind::ReturnStmt:
+      emit_return(
+          compile_operand(parser::cast<parser::ReturnStmt>(stmt)->value));
+      break;
+    case parser::NodeKind::BreakStmt:
+      if (loops_.empty())
+        emit_stray_loop_control();
+      else
+        loops_.back().breaks.push_back(emit(OpCode::Jmp));
+      break;
+    case parser::NodeKind::ContinueStmt:
+      if (loops_.empty()) {
+        emit_stray_loop_control();
+      } else {
+        loops_.back().continues.push_back(emit(OpCode::Jmp));
+      }
+      break;
+    case parser::NodeKind::IfStmt:
+      compile_if(parser::cast<parser::IfStmt>(stmt));
+      break;
+    case parser::NodeKind::WhileStmt:
+      compile_while(parser::cast<parser::WhileStmt>(stmt));
+      break;
+    default:
+      // FuncDef: registered up front by compile_program; nested definitions
+      // are ignored, as in the evaluator.
+      break;
+    }
+
+    next_reg_ = mark;
+  }
+
+  // Assignment writes the target slot only when the value is set, so a
+  // failed expression leaves the variable untouched.
+  void compile_assign(const parser::AssignStmt *as) {
+    const semantic::VarBinding target = names_.binding(as);
+    const parser::Expr *value = as->value;
+    if (is_literal(value)) {
+      compile_expr(value, target.slot);
+      return;
+    }
+    if (compile_step(target.slot, value))
+      return;
+    emit(OpCode::SetLocal, target.slot, compile_operand(value));
+  }
+
+  // `x = x + k` or `x = x - k` for a local `x` and a number `k`, as one
+  // AddLocalK/SubLocalK. False if `value` has another shape.
+  bool compile_step(std::uint32_t slot, const parser::Expr *value) {
+    auto b = parser::dyn_cast<parser::BinaryOp>(value);
+    if (!b || (b->op != parser::BinOpKind::Add &&
+               b->op != parser::BinOpKind::Sub))
+      return false;
+    auto k = parser::dyn_cast<parser::NumberLiteral>(b->right);
+    bool is_local;
+    if (!k || !k->in_range || local_slot(b->left, is_local) != slot ||
+        !is_local)
+      return false;
+    emit_bx(b->op == parser::BinOpKind::Add ? OpCode::AddLocalK
+                                            : OpCode::SubLocalK,
+            slot,
+            k->is_float() ? float_constant(k->float_value)
+                          : int_constant(k->int_value));
+    return true;
+  }
+
+  void compile_if(const parser::IfStmt *is) {
+    std::vector<std::size_t> to_end;
+    for (const auto &branch : is->branches) {
+      std::size_t skip = 0;
+      bool conditional = branch.condition != nullptr;
+      if (conditional) {
+        const std::uint32_t mark = next_reg_;
+        skip = emit(OpCode::JmpIfFalse, compile_operand(branch.condition));
+        next_reg_ = mark;
+      }
+      enter_block(branch.body);
+      for (const auto &s : branch.body)
+        compile_stmt(s);
+      if (!conditional)
+        break; // else is always taken; later branches are unreachable
+      to_end.push_back(emit(OpCode::Jmp));
+      patch(skip, here());
+    }
+    patch_to_here(to_end);
+  }
+
+  // The condition is tested after the body, so an iteration runs one jump
+  // (JmpIfTrue back to the body) rather than a test and a jump back.
+  void compile_while(const parser::WhileStmt *ws) {
+    enter_block(ws->body);
+    // The condition's literal operands do not change between iterations.
+    // Their registers sit below the body's temporaries, so stay loaded.
+    const std::vector<const parser::Expr *> operands =
+        compared_operands(ws->condition);
+    for (const parser::Expr *operand : operands)
+      hoist_literal(operand);
+
+    const std::size_t to_test = emit(OpCode::Jmp);
+    const std::size_t body = here();
+    loops_.emplace_back();
+    for (const auto &s : ws->body)
+      compile_stmt(s);
+
+    patch(to_test, here());
+    patch_to_here(loops_.back().continues);
+    const std::uint32_t mark = next_reg_;
+    emit_bx(OpCode::JmpIfTrue, compile_operand(ws->condition),
+            static_cast<std::uint32_t>(body));
+    next_reg_ = mark;
+
+    patch_to_here(loops_.back().breaks);
+    loops_.pop_back();
+    for (const parser::Expr *operand : operands)
+      hoisted_.erase(operand);
+  }
+
+  // The operands of a comparison (or any binary operator), if `e` is one.
+  static std::vector<const parser::Expr *>
+  compared_operands(const parser::Expr *e) {
+    if (auto b = parser::dyn_cast<parser::BinaryOp>(e))
+      return {b->left, b->right};
+    if (auto ch = parser::dyn_cast<parser::CompareChain>(e))
+      return {ch->operands.begin(), ch->operands.end()};
+    return {};
+  }
+
+  // -------------------------------------------------------------------------
+  // Expressions: compile_expr leaves its result in `dst`; compile_operand
+  // returns a register holding the result, reading a local's slot in place.
+  // -------------------------------------------------------------------------
+
+  static bool is_literal(const parser::Expr *e) {
+    if (!e)
+      return false;
+    switch (e->kind) {
+    case parser::NodeKind::NumberLiteral:
+    case parser::NodeKind::StringLiteral:
+    case parser::NodeKind::BoolLiteral:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  void hoist_literal(const parser::Expr *e) {
+    if (!is_literal(e))
+      return;
+    const std::uint32_t r = alloc_reg();
+    compile_expr(e, r);
+    hoisted_[e] = r;
+  }
+
+  // A register holding `expr`'s value that may be read in place: a local's
+  // slot or a hoisted literal's register.
+  std::uint32_t operand_slot(const parser::Expr *expr, bool &in_place) const {
+    auto it = hoisted_.find(expr);
+    if (it != hoisted_.end()) {
+      in_place = true;
+      return it->second;
+    }
+    return local_slot(expr, in_place);
+  }
+
+  std::uint32_t local_slot(const parser::Expr *expr, bool &is_local) const {
+    is_local = false;
+    if (auto v = parser::dyn_cast<parser::VarRef>(expr)) {
+      semantic::VarBinding b = names_.binding(v);
+      if (b.kind == semantic::VarBinding::Local) {
+        is_local = true;
+        return b.slot;
+      }
+    }
+    return 0;
+  }
+
+  std::uint32_t compile_operand(const parser::Expr *expr) {
+    bool in_place;
+    std::uint32_t slot = operand_slot(expr, in_place);
+    if (in_place)
+      return slot;
+    std::uint32_t r = alloc_reg();
+    compile_expr(expr, r);
+    return r;
+  }
+
+  void compile_expr(const parser::Expr *expr, std::uint32_t dst) {
+    if (!expr) {
+      emit(OpCode::LoadNil, dst);
+      return;
+    }
+
+    switch (expr->kind) {
+    case parser::NodeKind::NumberLiteral: {
+      auto n = parser::cast<parser::NumberLiteral>(expr);
+      // The evaluator reports an out-of-range literal each time it runs.
+      if (!n->in_range)
+        throw CompileLimit("numeric literal '" + std::string(n->value) +
+                           "' is out of range");
+      emit_bx(OpCode::LoadK, dst,
+              n->is_float() ? float_constant(n->float_value)
+                            : int_constant(n->int_value));
+      return;
+    }
+
+    case parser::NodeKind::StringLiteral: {
+      auto s = parser::cast<parser::StringLiteral>(expr);
+      std::string raw(s->value);
+      if (raw.size() >= 2 && (raw.front() == '"' || raw.front() == '\''))
+        raw = raw.substr(1, raw.size() - 2);
+      emit_bx(OpCode::LoadK, dst, string_constant(raw));
+      return;
+    }
+
+    case parser::NodeKind::BoolLiteral:
+      emit(OpCode::LoadBool, dst, 0, 0,
+           parser::cast<parser::BoolLiteral>(expr)->value ? 1 : 0);
+      return;
+
+    case parser::NodeKind::VarRef: {
+      auto v = parser::cast<parser::VarRef>(expr);
+      semantic::VarBinding b = names_.binding(v);
+      switch (b.kind) {
+      case semantic::VarBinding::Local:
+        emit(OpCode::Move, dst, b.slot);
+        break;
+      case semantic::VarBinding::Global:
+        emit_bx(OpCode::GetGlobal, dst, b.slot);
+        break;
+      case semantic::VarBinding::Unbound:
+        emit(OpCode::LoadNil, dst);
+        break;
+      }
+      return;
+    }
+
+    case parser::NodeKind::UnaryOp: {
+      auto u = parser::cast<parser::UnaryOp>(expr);
+      const std::uint32_t mark = next_reg_;
+      std::uint32_t r = compile_operand(u->operand);
+      emit(unary_opcode(u->op), dst, r);
+      next_reg_ = mark;
+      return;
+    }
+
+    case parser::NodeKind::LogicalExpr:
+      compile_logical(parser::cast<parser::LogicalExpr>(expr), dst);
+      return;
+
+    case parser::NodeKind::BinaryOp:
+      compile_binary(parser::cast<parser::BinaryOp>(expr), dst);
+      return;
+
+    case parser::NodeKind::CompareChain:
+      compile_compare_chain(parser::cast<parser::CompareChain>(expr), dst);
+      return;
+
+    case parser::NodeKind::CallExpr:
+      compile_call(parser::cast<parser::CallExpr>(expr), dst);
+      return;
+
+    default:
+      emit(OpCode::LoadNil, dst);
+      return;
+    }
+  }
+
+  // and/or: an unset left operand poisons the result without evaluating the
+  // right one; otherwise the result is always a Bool.
+  void compile_logical(const parser::LogicalExpr *lg, std::uint32_t dst) {
+    compile_expr(lg->left, dst); // result register doubles as the test
+    const bool is_and = lg->op == parser::BinOpKind::And;
+    std::size_t unset = emit(OpCode::JmpIfUnset, dst);
+    std::size_t decided =
+        emit(is_and ? OpCode::JmpIfFalse : OpCode::JmpIfTrue, dst);
+    compile_expr(lg->right, dst);
+    emit(OpCode::ToBool, dst, dst);
+    std::size_t done = emit(OpCode::Jmp);
+    patch(decided, here());
+    emit(OpCode::LoadBool, dst, 0, 0, is_and ? 0 : 1);
+    patch(done, here());
+    patch(unset, here());
+  }
+
+  void compile_binary(const parser::BinaryOp *b, std::uint32_t dst) {
+    const std::uint32_t mark = next_reg_;
+    bool left_in_place;
+    std::uint32_t lhs = operand_slot(b->left, left_in_place);
+    if (!left_in_place) {
+      compile_expr(b->left, dst);
+      lhs = dst;
+    }
+    std::uint32_t rhs = compile_operand(b->right);
+    emit(arith_opcode(b), dst, lhs, rhs);
+    next_reg_ = mark;
+  }
+
+  // The opcode for `b`, quickened when inference expects two Ints or two
+  // Floats. The VM checks the guess (see OpCode::AddInt).
+  OpCode arith_opcode(const parser::BinaryOp *b) {
+    const OpCode op = binary_opcode(b->op);
+    if (!types_)
+      return op;
+    const semantic::TypeKind t = static_type(b->left);
+    if (t != static_type(b->right))
+      return op;
+    if (t == semantic::TypeKind::Int)
+      return quickened_opcode(op, Value::Int);
+    if (t == semantic::TypeKind::Float)
+      return quickened_opcode(op, Value::Float);
+    return op;
+  }
+
+  // The type inference gives `e`. Variables have one type per name across
+  // the module, and only module-scope ones are typed at all, so this is a
+  // hint rather than a fact.
+  semantic::TypeKind static_type(const parser::Expr *e) {
+    using semantic::TypeKind;
+    if (!e)
+      return TypeKind::Unknown;
+    auto memo = expr_types_.find(e);
+    if (memo != expr_types_.end())
+      return memo->second;
+
+    TypeKind t = TypeKind::Unknown;
+    switch (e->kind) {
+    case parser::NodeKind::NumberLiteral:
+      t = parser::cast<parser::NumberLiteral>(e)->is_float() ? TypeKind::Float
+                                                            : TypeKind::Int;
+      break;
+    case parser::NodeKind::StringLiteral:
+      t = TypeKind::String;
+      break;
+    case parser::NodeKind::BoolLiteral:
+    case parser::NodeKind::LogicalExpr:
+    case parser::NodeKind::CompareChain:
+      t = TypeKind::Bool;
+      break;
+    case parser::NodeKind::VarRef: {
+      auto v = parser::cast<parser::VarRef>(e);
+      const semantic::VarBinding b = names_.binding(v);
+      if (b.kind == semantic::VarBinding::Global ||
+          (is_main_ && b.kind == semantic::VarBinding::Local)) {
+        auto it = types_->vars.find(v->id);
+        if (it != types_->vars.end())
+          t = it->second;
+      }
+      break;
+    }
+    case parser::NodeKind::UnaryOp: {
+      auto u = parser::cast<parser::UnaryOp>(e);
+      t = semantic::unary_type(u->op, static_type(u->operand));
+      break;
+    }
+    case parser::NodeKind::BinaryOp: {
+      auto b = parser::cast<parser::BinaryOp>(e);
+      t = semantic::binary_type(b->op, static_type(b->left),
+                                static_type(b->right));
+      break;
+    }
+    case parser::NodeKind::CallExpr:
+      if (auto callee = parser::dyn_cast<parser::VarRef>(
+              parser::cast<parser::CallExpr>(e)->callee)) {
+        auto it = types_->functions.find(callee->id);
+        if (it != types_->functions.end())
+          t = it->second;
+      }
+      break;
+    default:
+      break;
+    }
+    expr_types_.emplace(e, t);
+    return t;
+  }
+
+  // a < b < c: each middle operand is evaluated once and kept in its own
+  // register; the first false (or unset) comparison is the result.
+  void compile_compare_chain(const parser::CompareChain *ch,
+                             std::uint32_t dst) {
+    const std::uint32_t mark = next_reg_;
+    std::vector<std::size_t> exits;
+    std::uint32_t lhs = compile_operand(ch->operands[0]);
+    for (std::size_t i = 0; i < ch->ops.size(); ++i) {
+      std::uint32_t rhs = compile_operand(ch->operands[i + 1]);
+      emit(binary_opcode(ch->ops[i]), dst, lhs, rhs);
+      if (i + 1 < ch->ops.size())
+        exits.push_back(emit(OpCode::JmpIfFalse, dst));
+      lhs = rhs;
+    }
+    for (std::size_t exit : exits)
+      patch(exit, here());
+    next_reg_ = mark;
+  }
+
+  void compile_call(const parser::CallExpr *c, std::uint32_t dst) {
+    auto callee = parser::dyn_cast<parser::VarRef>(c->callee);
+    if (!callee) {
+      emit(OpCode::LoadNil, dst);
+      return;
+    }
+
+    const bool is_print = callee->id == lexer::sym::print;
+    auto fn = functions_.find(callee->id);
+    if (!is_print && fn == functions_.end()) {
+      // Unknown callee: the evaluator yields nullopt without touching args.
+      emit(OpCode::LoadNil, dst);
+      return;
+    }
+    if (!is_print && c->args.size() > kMaxArgs)
+      throw CompileLimit("call to '" + std::string(callee->name) +
+                         "' has too many arguments");
+
+    // print writes each argument as soon as it is evaluated, so output from
+    // calls in later arguments interleaves exactly as in the evaluator.
+    if (is_print) {
+      for (const auto &arg : c->args) {
+        const std::uint32_t mark = next_reg_;
+        emit(OpCode::Print, compile_operand(arg));
+        next_reg_ = mark;
+      }
+      emit(OpCode::PrintLn, dst);
+      return;
+    }
+
+    const std::uint32_t mark = next_reg_;
+    std::uint32_t base = next_reg_;
+    std::vector<std::size_t> failed;
+    for (const auto &arg : c->args) {
+      std::uint32_t r = alloc_reg();
+      compile_expr(arg, r);
+      // A user call stops at the first unset argument.
+      if (!is_literal(arg))
+        failed.push_back(emit(OpCode::JmpIfUnset, r));
+    }
+    const auto argc = static_cast<std::uint32_t>(c->args.size());
+
+    emit(OpCode::Call, dst, fn->second, base, argc);
+    if (!failed.empty()) {
+      std::size_t done = emit(OpCode::Jmp);
+      patch_to_here(failed);
+      emit(OpCode::LoadNil, dst);
+      patch(done, here());
+    }
+    next_reg_ = mark;
+  }
+};
+
+} // namespace
+
+std::optional<Program>
+cimple::eval::compile_program(const parser::Module &module,
+                              const semantic::TypeEnv *types,
+                              std::string *error) {
+  Program program;
+  const semantic::Resolution names = semantic::resolve_names(module);
+
+  // Mirror the evaluator's function table: top-level definitions only, with
+  // a later `def` of the same name replacing an earlier one.
+  std::unordered_map<lexer::SymbolId, const parser::FuncDef *> defs;
+  std::vector<const parser::FuncDef *> order;
+  for (const auto &stmt : module.body) {
+    if (auto fn = parser::dyn_cast<parser::FuncDef>(stmt)) {
+      if (defs.find(fn->name_id) == defs.end())
+        order.push_back(fn);
+      defs[fn->name_id] = fn;
+    }
+  }
+
+  try {
+    if (!names.unsupported.empty())
+      throw CompileLimit("function '" +
+                         std::string(names.unsupported.front()->name) +
+                         "' repeats a parameter name");
+    if (order.size() > std::numeric_limits<std::uint16_t>::max())
+      throw CompileLimit("module defines too many functions");
+
+    FunctionIndex index;
+    for (const parser::FuncDef *fn : order)
+      index[fn->name_id] = static_cast<std::uint16_t>(index.size());
+
+    program.functions.resize(order.size());
+    for (const parser::FuncDef *first : order) {
+      const parser::FuncDef *fn = defs[first->name_id];
+      Function &out = program.functions[index[fn->name_id]];
+      out.name = fn->name;
+      const semantic::FrameLayout &layout = names.functions.at(fn);
+      FunctionCompiler(out, index, names, layout, types, /*is_main=*/false)
+          .compile_body(fn->body, layout);
+    }
+
+    program.main.name = "<main>";
+    FunctionCompiler(program.main, index, names, names.main, types,
+                     /*is_main=*/true)
+        .compile_module(module);
+  } catch (const CompileLimit &e) {
+    if (error)
+      *error = e.what();
+    return std::nullopt;
+  }
+
+  return program;
+}
@@ -1,4 +1,5 @@
 #include "frontend/eval/evaluator.h"
+#include "frontend/eval/arith.h"
 #include <cmath>
 #include <iostream>
 #include <vector>
@@ -25,99 +26,68 @@ private:
 
 } // namespace
 
-// ---------------------------------------------------------------------------
-// Value helpers
-// ---------------------------------------------------------------------------
-
-std::string Value::to_string() const {
-  switch (kind) {
-  case Int:
-    return std::to_string(i);
-  case Float:
-    return std::to_string(f);
-  case String:
-    return s;
-  case Bool:
-    return b ? "True" : "False";
-  default:
-    return "<unknown>";
-  }
-}
-
-Value Value::from_cimple_var(const semantic::CimpleVar &var) {
-  Value v;
-  if (var.is_int()) {
-    v.kind = Int;
-    v.i = var.get_int();
-  } else if (var.is_float()) {
-    v.kind = Float;
-    v.f = var.get_float();
-  } else if (var.is_string()) {
-    v.kind = String;
-    v.s = var.get_string();
-  } else {
-    v.kind = Unknown;
-  }
-  return v;
-}
-
-semantic::CimpleVar Value::to_cimple_var() const {
-  switch (kind) {
-  case Int:
-    return semantic::CimpleVar(static_cast<std::int64_t>(i));
-  case Float:
-    return semantic::CimpleVar(f);
-  case String:
-    return semantic::CimpleVar(s);
-  case Bool:
-    return semantic::CimpleVar(static_cast<std::int64_t>(b ? 1 : 0));
-  default:
-    return semantic::CimpleVar(std::int64_t(0));
-  }
-}
-
 // Return true if this Value is truthy (for if/while conditions)
 static bool is_truthy(const Value &v) {
-  switch (v.kind) {
+  switch (v.kind()) {
   case Value::Int:
-    return v.i != 0;
+    return v.as_int() != 0;
   case Value::Float:
-    return v.f != 0.0;
+    return v.as_float() != 0.0;
   case Value::String:
-    return !v.s.empty();
+    return !v.str().empty();
   case Value::Bool:
-    return v.b;
+    return v.as_bool();
   default:
     return false;
   }
 }
 
-static Value make_int(long long v) {
-  Value x;
-  x.kind = Value::Int;
-  x.i = v;
-  return x;
-}
-
-static Value make_float(double v) {
-  Value x;
-  x.kind = Value::Float;
-  x.f = v;
-  return x;
+static Value make_int(long long v) { return Value::integer(v); }
+
+static Value make_float(double v) { return Value::floating(v); }
+
+static Value make_bool(bool v) { return Value::boolean(v); }
+
+// Apply comparison operator `op` to two operands of the same type.
+template <typename T>
+static bool compare(parser::BinOpKind op, const T &l, const T &r) {
+  switch (op) {
+  case parser::BinOpKind::Eq:
+    return l == r;
+  case parser::BinOpKind::Ne:
+    return l != r;
+  case parser::BinOpKind::Lt:
+    return l < r;
+  case parser::BinOpKind::Gt:
+    return l > r;
+  case parser::BinOpKind::Le:
+    return l <= r;
+  case parser::BinOpKind::Ge:
+    return l >= r;
+  default:
+    return false;
+  }
 }
 
-static Value make_string(const std::string &s) {
-  Value x;
-  x.kind = Value::String;
-  x.s = s;
-  return x;
-}
+// Comparisons: numbers compare as doubles, strings lexicographically, bools
+// only for (in)equality; any other pairing has no value.
+static std::optional<Value> evaluate_comparison(parser::BinOpKind op,
+                                                const Value &L,
+                                                const Value &R) {
+  if (L.is_number() && R.is_number())
+    return make_bool(compare(op, L.as_double(), R.as_double()));
+
+  if (L.kind() == Value::String && R.kind() == Value::String)
+    return make_bool(compare(op, L.str(), R.str()));
+
+  if (L.kind() == Value::Bool && R.kind() == Value::Bool) {
+    if (op == parser::BinOpKind::Eq)
+      return make_bool(L.as_bool() == R.as_bool());
+    if (op == parser::BinOpKind::Ne)
+      return make_bool(L.as_bool() != R.as_bool());
+  }
 
-static Value make_bool(bool v) {
-  Value x;
-  x.kind = Value::Bool;
-  x.b = v;
-  return x;
+  return std::nullopt;
 }
 
 // ---------------------------------------------------------------------------
@@ -126,158 +96,113 @@ static Value make_bool(bool v) {
 
 std::optional<Value> cimple::eval::evaluate_expr(
     const parser::Expr *expr, const semantic::TypeEnv &tenv, ValueEnv &venv,
-    const std::unordered_map<std::string, parser::FuncDef *> &functions) {
+    const FunctionTable &functions) {
   if (!expr)
     return std::nullopt;
 
   (void)tenv;
 
   // --- Literals ---
-  if (auto n = dynamic_cast<const parser::NumberLiteral *>(expr)) {
-    if (n->value.find('.') != std::string::npos)
-      return make_float(std::stod(n->value));
-    return make_int(std::stoll(n->value));
+  switch (expr->kind) {
+  case parser::NodeKind::NumberLiteral: {
+    auto n = parser::cast<parser::NumberLiteral>(expr);
+    if (!n->in_range) {
+      std::cerr << "Numeric literal out of range: " << n->value << "\n";
+      return std::nullopt;
+    }
+    if (n->is_float())
+      return make_float(n->float_value);
+    return make_int(n->int_value);
   }
 
-  if (auto s = dynamic_cast<const parser::StringLiteral *>(expr)) {
+  case parser::NodeKind::StringLiteral: {
+    auto s = parser::cast<parser::StringLiteral>(expr);
     // Strip surrounding quotes from the lexer's raw string token
-    std::string raw = s->value;
+    std::string_view raw = s->value;
     if (raw.size() >= 2 && (raw.front() == '"' || raw.front() == '\''))
       raw = raw.substr(1, raw.size() - 2);
-    return make_string(raw);
+    return Value::string(raw);
   }
 
-  if (auto bl = dynamic_cast<const parser::BoolLiteral *>(expr)) {
+  case parser::NodeKind::BoolLiteral: {
+    auto bl = parser::cast<parser::BoolLiteral>(expr);
     return make_bool(bl->value);
   }
 
   // --- Variable reference ---
-  if (auto v = dynamic_cast<const parser::VarRef *>(expr)) {
-    if (const auto *found = venv.lookup(v->name)) {
-      return Value::from_cimple_var(*found);
+  case parser::NodeKind::VarRef: {
+    auto v = parser::cast<parser::VarRef>(expr);
+    if (const auto *found = venv.lookup(v->id)) {
+      return *found;
     }
     return std::nullopt;
   }
 
   // --- Unary operators ---
-  if (auto u = dynamic_cast<const parser::UnaryOp *>(expr)) {
-    auto operand = evaluate_expr(u->operand.get(), tenv, venv, functions);
+  case parser::NodeKind::UnaryOp: {
+    auto u = parser::cast<parser::UnaryOp>(expr);
+    auto operand = evaluate_expr(u->operand, tenv, venv, functions);
     if (!operand)
       return std::nullopt;
 
-    if (u->op == "not")
+    if (u->op == parser::UnOpKind::Not)
       return make_bool(!is_truthy(*operand));
 
-    if (u->op == "-") {
-      if (operand->kind == Value::Int)
-        return make_int(-operand->i);
-      if (operand->kind == Value::Float)
-        return make_float(-operand->f);
+    if (u->op == parser::UnOpKind::Neg) {
+      if (operand->kind() == Value::Int)
+        return make_int(-operand->as_int());
+      if (operand->kind() == Value::Float)
+        return make_float(-operand->as_float());
     }
 
+    if (u->op == parser::UnOpKind::BitNot && operand->kind() == Value::Int)
+      return make_int(~operand->as_int());
+
     return std::nullopt;
   }
 
   // --- Logical operators (and / or) with short-circuit evaluation ---
-  if (auto lg = dynamic_cast<const parser::LogicalExpr *>(expr)) {
-    auto left = evaluate_expr(lg->left.get(), tenv, venv, functions);
+  case parser::NodeKind::LogicalExpr: {
+    auto lg = parser::cast<parser::LogicalExpr>(expr);
+    auto left = evaluate_expr(lg->left, tenv, venv, functions);
     if (!left)
       return std::nullopt;
 
-    if (lg->op == "and") {
-      if (!is_truthy(*left))
-        return make_bool(false);
-      auto right = evaluate_expr(lg->right.get(), tenv, venv, functions);
-      if (!right)
-        return std::nullopt;
-      return make_bool(is_truthy(*right));
-    }
-
-    if (lg->op == "or") {
-      if (is_truthy(*left))
-        return make_bool(true);
-      auto right = evaluate_expr(lg->right.get(), tenv, venv, functions);
-      if (!right)
-        return std::nullopt;
-      return make_bool(is_truthy(*right));
-    }
-
-    return std::nullopt;
+    // Short-circuit: `and` stops on a falsy left, `or` on a truthy one.
+    const bool is_and = lg->op == parser::BinOpKind::And;
+    if (is_truthy(*left) != is_and)
+      return make_bool(!is_and);
+    auto right = evaluate_expr(lg->right, tenv, venv, functions);
+    if (!right)
+      return std::nullopt;
+    return make_bool(is_truthy(*right));
   }
 
   // --- Binary operators ---
-  if (auto b = dynamic_cast<const parser::BinaryOp *>(expr)) {
-    auto L = evaluate_expr(b->left.get(), tenv, venv, functions);
-    auto R = evaluate_expr(b->right.get(), tenv, venv, functions);
+  case parser::NodeKind::BinaryOp: {
+    auto b = parser::cast<parser::BinaryOp>(expr);
+    auto L = evaluate_expr(b->left, tenv, venv, functions);
+    auto R = evaluate_expr(b->right, tenv, venv, functions);
     if (!L || !R)
       return std::nullopt;
 
-    auto is_cmp = [](const std::string &op) {
-      return op == "==" || op == "!=" || op == "<" || op == ">" || op == "<=" ||
-             op == ">=";
-    };
-
-    if (is_cmp(b->op)) {
-      // Numeric comparison
-      if ((L->kind == Value::Int || L->kind == Value::Float) &&
-          (R->kind == Value::Int || R->kind == Value::Float)) {
-        const double lv = (L->kind == Value::Int) ? static_cast<double>(L->i) : L->f;
-        const double rv = (R->kind == Value::Int) ? static_cast<double>(R->i) : R->f;
-        if (b->op == "==")
-          return make_bool(lv == rv);
-        if (b->op == "!=")
-          return make_bool(lv != rv);
-        if (b->op == "<")
-          return make_bool(lv < rv);
-        if (b->op == ">")
-          return make_bool(lv > rv);
-        if (b->op == "<=")
-          return make_bool(lv <= rv);
-        if (b->op == ">=")
-          return make_bool(lv >= rv);
-      }
-
-      // String comparison
-      if (L->kind == Value::String && R->kind == Value::String) {
-        if (b->op == "==")
-          return make_bool(L->s == R->s);
-        if (b->op == "!=")
-          return make_bool(L->s != R->s);
-        if (b->op == "<")
-          return make_bool(L->s < R->s);
-        if (b->op == ">")
-          return make_bool(L->s > R->s);
-        if (b->op == "<=")
-          return make_bool(L->s <= R->s);
-        if (b->op == ">=")
-          return make_bool(L->s >= R->s);
-      }
-
-      // Bool equality
-      if (L->kind == Value::Bool && R->kind == Value::Bool) {
-        if (b->op == "==")
-          return make_bool(L->b == R->b);
-        if (b->op == "!=")
-          return make_bool(L->b != R->b);
-      }
-
-      return std::nullopt;
-    }
+    if (parser::is_comparison(b->op))
+      return evaluate_comparison(b->op, *L, *R);
 
     // Arithmetic operators
-    if ((L->kind == Value::Int || L->kind == Value::Float) &&
-        (R->kind == Value::Int || R->kind == Value::Float)) {
-      const bool both_int = (L->kind == Value::Int && R->kind == Value::Int);
+    if (L->is_number() && R->is_number()) {
+      const bool both_int = (L->kind() == Value::Int && R->kind() == Value::Int);
       if (both_int) {
-        const long long lv = L->i;
-        const long long rv = R->i;
-        if (b->op == "+")
+        const long long lv = L->as_int();
+        const long long rv = R->as_int();
+        switch (b->op) {
+        case parser::BinOpKind::Add:
           return make_int(lv + rv);
-        if (b->op == "-")
+        case parser::BinOpKind::Sub:
           return make_int(lv - rv);
-        if (b->op == "*")
+        case parser::BinOpKind::Mul:
           return make_int(lv * rv);
-        if (b->op == "/") {
+        case parser::BinOpKind::Div:
           if (rv == 0) {
             std::cerr << "Division by zero\n";
             return std::nullopt;
@@ -286,73 +211,142 @@ std::optional<Value> cimple::eval::evaluate_expr(
           if (lv % rv == 0)
             return make_int(lv / rv);
           return make_float(static_cast<double>(lv) / static_cast<double>(rv));
+        case parser::BinOpKind::FloorDiv:
+        case parser::BinOpKind::Mod:
+          if (rv == 0) {
+            std::cerr << "Division by zero\n";
+            return std::nullopt;
+          }
+          return make_int(b->op == parser::BinOpKind::Mod
+                              ? int_mod(lv, rv)
+                              : int_floor_div(lv, rv));
+        case parser::BinOpKind::Pow:
+          if (rv >= 0)
+            return make_int(int_pow(lv, rv));
+          if (lv == 0) {
+            std::cerr << "Division by zero\n";
+            return std::nullopt;
+          }
+          // A negative exponent gives a float, as in Python.
+          return make_float(std::pow(static_cast<double>(lv),
+                                     static_cast<double>(rv)));
+        case parser::BinOpKind::BitAnd:
+          return make_int(lv & rv);
+        case parser::BinOpKind::BitOr:
+          return make_int(lv | rv);
+        case parser::BinOpKind::BitXor:
+          return make_int(lv ^ rv);
+        case parser::BinOpKind::Shl:
+        case parser::BinOpKind::Shr:
+          if (rv < 0) {
+            std::cerr << "Negative shift count\n";
+            return std::nullopt;
+          }
+          return make_int(b->op == parser::BinOpKind::Shl
+                              ? int_shl(lv, rv)
+                              : int_shr(lv, rv));
+        default:
+          break;
         }
       } else {
-        const double lv = (L->kind == Value::Int) ? static_cast<double>(L->i) : L->f;
-        const double rv = (R->kind == Value::Int) ? static_cast<double>(R->i) : R->f;
-        if (b->op == "+")
+        const double lv = L->as_double();
+        const double rv = R->as_double();
+        switch (b->op) {
+        case parser::BinOpKind::Add:
           return make_float(lv + rv);
-        if (b->op == "-")
+        case parser::BinOpKind::Sub:
           return make_float(lv - rv);
-        if (b->op == "*")
+        case parser::BinOpKind::Mul:
           return make_float(lv * rv);
-        if (b->op == "/") {
+        case parser::BinOpKind::Div:
           if (rv == 0.0) {
             std::cerr << "Division by zero\n";
             return std::nullopt;
           }
           return make_float(lv / rv);
+        case parser::BinOpKind::FloorDiv:
+        case parser::BinOpKind::Mod:
+          if (rv == 0.0) {
+            std::cerr << "Division by zero\n";
+            return std::nullopt;
+          }
+          return make_float(b->op == parser::BinOpKind::Mod
+                                ? float_mod(lv, rv)
+                                : float_floor_div(lv, rv));
+        case parser::BinOpKind::Pow:
+          if (lv == 0.0 && rv < 0.0) {
+            std::cerr << "Division by zero\n";
+            return std::nullopt;
+          }
+          return make_float(std::pow(lv, rv));
+        default:
+          break; // bitwise operators take integers only
         }
       }
     }
 
     // String concatenation
-    if (b->op == "+" && L->kind == Value::String && R->kind == Value::String)
-      return make_string(L->s + R->s);
+    if (b->op == parser::BinOpKind::Add && L->kind() == Value::String &&
+        R->kind() == Value::String)
+      return Value::concat(L->str(), R->str());
 
     return std::nullopt;
   }
 
+  // --- Chained comparison: a < b < c is a < b and b < c, b evaluated once ---
+  case parser::NodeKind::CompareChain: {
+    auto ch = parser::cast<parser::CompareChain>(expr);
+    auto L = evaluate_expr(ch->operands[0], tenv, venv, functions);
+    for (std::size_t i = 0; i < ch->ops.size(); ++i) {
+      auto R = evaluate_expr(ch->operands[i + 1], tenv, venv, functions);
+      if (!L || !R)
+        return std::nullopt;
+      auto result = evaluate_comparison(ch->ops[i], *L, *R);
+      if (!result || !result->as_bool())
+        return result;
+      L = std::move(R);
+    }
+    return make_bool(true);
+  }
+
   // --- Function call ---
-  if (auto c = dynamic_cast<const parser::CallExpr *>(expr)) {
-    if (auto callee = dynamic_cast<const parser::VarRef *>(c->callee.get())) {
+  case parser::NodeKind::CallExpr: {
+    auto c = parser::cast<parser::CallExpr>(expr);
+    if (auto callee = parser::dyn_cast<parser::VarRef>(c->callee)) {
       // builtin: print
-      if (callee->name == "print") {
+      if (callee->id == lexer::sym::print) {
         for (auto &arg : c->args) {
-          auto v = evaluate_expr(arg.get(), tenv, venv, functions);
+          auto v = evaluate_expr(arg, tenv, venv, functions);
           if (v)
-            std::cout << v->to_string();
+            std::cout << *v;
         }
         std::cout << std::endl;
         return std::nullopt;
       }
 
       // user-defined function
-      auto it = functions.find(callee->name);
-      if (it != functions.end() && it->second) {
-        parser::FuncDef *fn = it->second;
-
+      if (parser::FuncDef *fn = functions.find(callee->id)) {
         std::vector<Value> arg_values;
         arg_values.reserve(c->args.size());
         for (const auto &arg : c->args) {
-          auto aval = evaluate_expr(arg.get(), tenv, venv, functions);
+          auto aval = evaluate_expr(arg, tenv, venv, functions);
           if (!aval) {
             return std::nullopt;
           }
-          arg_values.push_back(*aval);
+          arg_values.push_back(std::move(*aval));
         }
 
         ScopeGuard function_scope(venv, ValueEnv::ScopeKind::Function);
 
         const std::size_t nparams = fn->params.size();
         for (std::size_t i = 0; i < nparams && i < arg_values.size(); ++i) {
-          venv.set_local(fn->params[i], arg_values[i].to_cimple_var());
+          venv.set_local(fn->param_ids[i], std::move(arg_values[i]));
         }
 
         for (auto &bs : fn->body) {
-          auto res = cimple::eval::evaluate_stmt(bs.get(), tenv, venv, functions);
+          auto res = cimple::eval::evaluate_stmt(bs, tenv, venv, functions);
           if (res.is_return())
-            return res.value;
+            return std::move(res.value);
 
           // break/continue cannot escape a function call
           if (res.is_break() || res.is_continue()) {
@@ -364,9 +358,12 @@ std::optional<Value> cimple::eval::evaluate_expr(
         return std::nullopt;
       }
     }
+    return std::nullopt;
   }
 
-  return std::nullopt;
+  default:
+    return std::nullopt;
+  }
 }
 
 // ---------------------------------------------------------------------------
@@ -375,57 +372,62 @@ std::optional<Value> cimple::eval::evaluate_expr(
 
 StmtResult cimple::eval::evaluate_stmt(
     const parser::Stmt *stmt, const semantic::TypeEnv &tenv, ValueEnv &venv,
-    const std::unordered_map<std::string, parser::FuncDef *> &functions) {
+    const FunctionTable &functions) {
   if (!stmt)
     return StmtResult::normal();
 
   // --- Assignment ---
-  if (auto as = dynamic_cast<const parser::AssignStmt *>(stmt)) {
-    auto v = evaluate_expr(as->value.get(), tenv, venv, functions);
+  switch (stmt->kind) {
+  case parser::NodeKind::AssignStmt: {
+    auto as = parser::cast<parser::AssignStmt>(stmt);
+    auto v = evaluate_expr(as->value, tenv, venv, functions);
     if (v)
-      venv.set_local(as->target, v->to_cimple_var());
+      venv.set_local(as->target_id, std::move(*v));
     return StmtResult::normal();
   }
 
   // --- Expression statement (e.g. a function call like print(...)) ---
-  if (auto es = dynamic_cast<const parser::ExprStmt *>(stmt)) {
-    evaluate_expr(es->expr.get(), tenv, venv, functions);
+  case parser::NodeKind::ExprStmt: {
+    auto es = parser::cast<parser::ExprStmt>(stmt);
+    evaluate_expr(es->expr, tenv, venv, functions);
     return StmtResult::normal();
   }
 
   // --- return ---
-  if (auto rs = dynamic_cast<const parser::ReturnStmt *>(stmt)) {
-    auto v = evaluate_expr(rs->value.get(), tenv, venv, functions);
+  case parser::NodeKind::ReturnStmt: {
+    auto rs = parser::cast<parser::ReturnStmt>(stmt);
+    auto v = evaluate_expr(rs->value, tenv, venv, functions);
     return StmtResult::ret(v);
   }
 
   // --- break ---
-  if (dynamic_cast<const parser::BreakStmt *>(stmt))
+  case parser::NodeKind::BreakStmt:
     return StmtResult::brk();
 
   // --- continue ---
-  if (dynamic_cast<const parser::ContinueStmt *>(stmt))
+  case parser::NodeKind::ContinueStmt:
     return StmtResult::cont();
 
   // --- FuncDef at statement level (registered by module runner, skip here) ---
-  if (dynamic_cast<const parser::FuncDef *>(stmt))
+  case parser::NodeKind::FuncDef:
     return StmtResult::normal();
 
   // --- if / elif / else ---
-  if (auto is = dynamic_cast<const parser::IfStmt *>(stmt)) {
+  case parser::NodeKind::IfStmt: {
+    auto is = parser::cast<parser::IfStmt>(stmt);
     for (auto &branch : is->branches) {
       bool take = false;
       if (!branch.condition) {
         take = true; // else branch
       } else {
-        auto cond = evaluate_expr(branch.condition.get(), tenv, venv, functions);
+        auto cond = evaluate_expr(branch.condition, tenv, venv, functions);
         take = cond && is_truthy(*cond);
       }
 
       if (take) {
         ScopeGuard branch_scope(venv, ValueEnv::ScopeKind::Block);
         for (auto &s : branch.body) {
-          auto res = evaluate_stmt(s.get(), tenv, venv, functions);
+          auto res = evaluate_stmt(s, tenv, venv, functions);
           if (!res.is_normal())
             return res;
         }
@@ -438,17 +440,18 @@ StmtResult cimple::eval::evaluate_stmt(
   // --- while ---
   // This is the only place that catches Break and Continue.
   // Return still propagates upward.
-  if (auto ws = dynamic_cast<const parser::WhileStmt *>(stmt)) {
+  case parser::NodeKind::WhileStmt: {
+    auto ws = parser::cast<parser::WhileStmt>(stmt);
     ScopeGuard loop_scope(venv, ValueEnv::ScopeKind::Block);
 
     while (true) {
-      auto cond = evaluate_expr(ws->condition.get(), tenv, venv, functions);
+      auto cond = evaluate_expr(ws->condition, tenv, venv, functions);
       if (!cond || !is_truthy(*cond))
         break;
 
       bool did_break = false;
       for (auto &s : ws->body) {
-        auto res = evaluate_stmt(s.get(), tenv, venv, functions);
+        auto res = evaluate_stmt(s, tenv, venv, functions);
         if (res.is_break()) {
           did_break = true;
           break;
@@ -468,5 +471,7 @@ StmtResult cimple::eval::evaluate_stmt(
     return StmtResult::normal();
   }
 
-  return StmtResult::normal();
+  default:
+    return StmtResult::normal();
+  }
 }
@@ -0,0 +1,61 @@
+// value.cpp - compact tagged runtime value
+#include "frontend/eval/value.h"
+#include <new>
+#include <ostream>
+
+using namespace cimple;
+using namespace cimple::eval;
+
+char *Value::init_string(std::size_t size) {
+  kind_ = String;
+  if (size <= kSmallCapacity) {
+    aux_ = static_cast<std::uint8_t>(size);
+    return payload_;
+  }
+  void *mem = ::operator new(offsetof(HeapString, data) + size);
+  auto *h = static_cast<HeapString *>(mem);
+  h->refs = 1;
+  h->size = static_cast<std::uint32_t>(size);
+  aux_ = kHeap;
+  store(h);
+  return h->data;
+}
+
+Value Value::string(std::string_view s) {
+  Value x;
+  char *dst = x.init_string(s.size());
+  if (!s.empty())
+    std::memcpy(dst, s.data(), s.size());
+  return x;
+}
+
+Value Value::concat(std::string_view a, std::string_view b) {
+  Value x;
+  char *dst = x.init_string(a.size() + b.size());
+  if (!a.empty())
+    std::memcpy(dst, a.data(), a.size());
+  if (!b.empty())
+    std::memcpy(dst + a.size(), b.data(), b.size());
+  return x;
+}
+
+std::string Value::to_string() const {
+  switch (kind_) {
+  case Int:
+    return std::to_string(as_int());
+  case Float:
+    return std::to_string(as_float());
+  case String:
+    return std::string(str());
+  case Bool:
+    return as_bool() ? "True" : "False";
+  default:
+    return "<unknown>";
+  }
+}
+
+std::ostream &cimple::eval::operator<<(std::ostream &os, const Value &v) {
+  if (v.kind() == Value::String)
+    return os << v.str();
+  return os << v.to_string();
+}
@@ -0,0 +1,509 @@
+// vm.cpp - register VM for compiled bytecode
+#include "frontend/eval/vm.h"
+#include "frontend/eval/arith.h"
+#include <cmath>
+#include <iostream>
+
+// Direct threading: each handler jumps straight to the next one through a
+// table of label addresses (a GCC/Clang extension), giving every opcode its
+// own indirect branch to predict. Elsewhere the loop is a plain switch.
+#if defined(__GNUC__) || defined(__clang__)
+#define CIMPLE_VM_THREADED 1
+#endif
+
+using namespace cimple;
+using namespace cimple::eval;
+
+namespace {
+
+bool truthy(const Value &v) {
+  switch (v.kind()) {
+  case Value::Int:
+    return v.as_int() != 0;
+  case Value::Float:
+    return v.as_float() != 0.0;
+  case Value::String:
+    return !v.str().empty();
+  case Value::Bool:
+    return v.as_bool();
+  default:
+    return false;
+  }
+}
+
+void set_unset(Value &out) { out.reset(); }
+
+void set_int(Value &out, long long v) { out.set_int(v); }
+
+void set_float(Value &out, double v) { out.set_float(v); }
+
+void set_bool(Value &out, bool v) { out.set_bool(v); }
+
+// Arithmetic with the evaluator's promotion rules: int op int stays int
+// (except for inexact division and negative powers), anything involving a
+// float is float, and `+` also concatenates two strings.
+// `out` may alias an operand; it is written only after both are read.
+void arith(OpCode op, const Value &L, const Value &R, Value &out) {
+  if (L.is_number() && R.is_number()) {
+    if (L.kind() == Value::Int && R.kind() == Value::Int) {
+      const long long lv = L.as_int();
+      const long long rv = R.as_int();
+      switch (op) {
+      case OpCode::Add:
+        return set_int(out, lv + rv);
+      case OpCode::Sub:
+        return set_int(out, lv - rv);
+      case OpCode::Mul:
+        return set_int(out, lv * rv);
+      case OpCode::Pow:
+        if (rv >= 0)
+          return set_int(out, int_pow(lv, rv));
+        if (lv == 0) {
+          std::cerr << "Division by zero\n";
+          return set_unset(out);
+        }
+        return set_float(out, std::pow(static_cast<double>(lv),
+                                       static_cast<double>(rv)));
+      default:
+        if (rv == 0) {
+          std::cerr << "Division by zero\n";
+          return set_unset(out);
+        }
+        if (op == OpCode::FloorDiv)
+          return set_int(out, int_floor_div(lv, rv));
+        if (op == OpCode::Mod)
+          return set_int(out, int_mod(lv, rv));
+        if (lv % rv == 0)
+          return set_int(out, lv / rv);
+        return set_float(out, static_cast<double>(lv) / static_cast<double>(rv));
+      }
+    }
+    const double lv = L.as_double();
+    const double rv = R.as_double();
+    switch (op) {
+    case OpCode::Add:
+      return set_float(out, lv + rv);
+    case OpCode::Sub:
+      return set_float(out, lv - rv);
+    case OpCode::Mul:
+      return set_float(out, lv * rv);
+    case OpCode::Pow:
+      if (lv == 0.0 && rv < 0.0) {
+        std::cerr << "Division by zero\n";
+        return set_unset(out);
+      }
+      return set_float(out, std::pow(lv, rv));
+    default:
+      if (rv == 0.0) {
+        std::cerr << "Division by zero\n";
+        return set_unset(out);
+      }
+      if (op == OpCode::FloorDiv)
+        return set_float(out, float_floor_div(lv, rv));
+      if (op == OpCode::Mod)
+        return set_float(out, float_mod(lv, rv));
+      return set_float(out, lv / rv);
+    }
+  }
+
+  if (op == OpCode::Add && L.kind() == Value::String &&
+      R.kind() == Value::String) {
+    out = Value::concat(L.str(), R.str());
+    return;
+  }
+  set_unset(out);
+}
+
+// Bitwise operators take two integers; anything else is unset.
+void bitwise(OpCode op, const Value &L, const Value &R, Value &out) {
+  if (L.kind() != Value::Int || R.kind() != Value::Int)
+    return set_unset(out);
+  const long long lv = L.as_int();
+  const long long rv = R.as_int();
+  switch (op) {
+  case OpCode::BitAnd:
+    return set_int(out, lv & rv);
+  case OpCode::BitOr:
+    return set_int(out, lv | rv);
+  case OpCode::BitXor:
+    return set_int(out, lv ^ rv);
+  default:
+    if (rv < 0) {
+      std::cerr << "Negative shift count\n";
+      return set_unset(out);
+    }
+    return set_int(out, op == OpCode::Shl ? int_shl(lv, rv) : int_shr(lv, rv));
+  }
+}
+
+template <typename T> bool compare_values(OpCode op, const T &l, const T &r) {
+  switch (op) {
+  case OpCode::Eq:
+    return l == r;
+  case OpCode::Ne:
+    return l != r;
+  case OpCode::Lt:
+    return l < r;
+  case OpCode::Gt:
+    return l > r;
+  case OpCode::Le:
+    return l <= r;
+  default:
+    return l >= r;
+  }
+}
+
+// Comparisons: numbers compare as doubles, strings lexicographically, bools
+// only for (in)equality. Any other pairing is unset.
+void compare(OpCode op, const Value &L, const Value &R, Value &out) {
+  if (L.is_number() && R.is_number())
+    return set_bool(out, compare_values(op, L.as_double(), R.as_double()));
+  if (L.kind() == Value::String && R.kind() == Value::String)
+    return set_bool(out, compare_values(op, L.str(), R.str()));
+  if (L.kind() == Value::Bool && R.kind() == Value::Bool &&
+      (op == OpCode::Eq || op == OpCode::Ne))
+    return set_bool(out, compare_values(op, L.as_bool(), R.as_bool()));
+  set_unset(out);
+}
+
+// compare() into `out`, then whether `out` is set and true.
+inline bool compare_test(OpCode op, const Value &L, const Value &R,
+                         Value &out) {
+  if (L.kind() == Value::Int && R.kind() == Value::Int) {
+    const bool t = compare_values(op, static_cast<double>(L.as_int()),
+                                  static_cast<double>(R.as_int()));
+    set_bool(out, t);
+    return t;
+  }
+  if (L.is_number() && R.is_number()) {
+    const bool t = compare_values(op, L.as_double(), R.as_double());
+    set_bool(out, t);
+    return t;
+  }
+  compare(op, L, R, out);
+  return truthy(out);
+}
+
+// Add or Sub, with two Ints handled inline.
+inline void add_sub(OpCode op, const Value &L, const Value &R, Value &out) {
+  if (L.kind() == Value::Int && R.kind() == Value::Int)
+    return set_int(out, op == OpCode::Add ? L.as_int() + R.as_int()
+                                          : L.as_int() - R.as_int());
+  arith(op, L, R, out);
+}
+
+// Put the generic opcode back after a quickened instruction's guard failed.
+void deoptimize(Instr &ins) {
+  ins.op = generic_opcode(ins.op);
+  if (ins.n < kMaxDeopts)
+    ++ins.n;
+}
+
+// `x op k` written back to `x` unless unset, as `t = x op k; x = t` would.
+void step_local(OpCode op, Value &x, const Value &k) {
+  if (x.kind() == Value::Int && k.kind() == Value::Int) {
+    set_int(x, op == OpCode::Add ? x.as_int() + k.as_int()
+                                 : x.as_int() - k.as_int());
+    return;
+  }
+  if (!x.is_set())
+    return;
+  Value t;
+  arith(op, x, k, t);
+  if (t.is_set())
+    x = std::move(t);
+}
+
+} // namespace
+
+// Every opcode, for the dispatch table.
+#define CIMPLE_VM_OPCODES(X)                                                   \
+  X(LoadK) X(LoadNil) X(LoadBool) X(Move) X(SetLocal) X(GetGlobal)             \
+  X(InheritGlobal) X(Add) X(Sub) X(Mul) X(Div) X(FloorDiv) X(Mod) X(Pow)       \
+  X(BitAnd) X(BitOr) X(BitXor) X(Shl) X(Shr) X(Eq) X(Ne) X(Lt) X(Gt) X(Le)     \
+  X(Ge) X(Neg) X(Not) X(BitNot) X(ToBool) X(Jmp) X(JmpIfFalse) X(JmpIfTrue)    \
+  X(JmpIfUnset) X(Call) X(Print) X(PrintLn) X(Ret) X(RetNil) X(Escape)         \
+  X(AddLocalK) X(SubLocalK) X(LoadKAdd) X(LoadKSub) X(EqJmp) X(NeJmp)          \
+  X(LtJmp) X(GtJmp) X(LeJmp) X(GeJmp) X(AddInt) X(SubInt) X(MulInt)          \
+  X(AddFloat) X(SubFloat) X(MulFloat) X(DivFloat) X(Halt)
+
+#define CIMPLE_VM_COUNT(name) +1
+static_assert(0 CIMPLE_VM_OPCODES(CIMPLE_VM_COUNT) == kOpCodeCount,
+              "CIMPLE_VM_OPCODES must list every opcode once");
+#undef CIMPLE_VM_COUNT
+
+VM::VM(Program &program) : program_(program) {}
+
+// VM_OP(name) starts the handler for OpCode::name; VM_NEXT() ends it by
+// dispatching the instruction at `pc`. VM_FALLTHROUGH runs on into the
+// next handler.
+#ifdef CIMPLE_VM_THREADED
+#define VM_OP(name) op_##name
+#define VM_FALLTHROUGH
+#define VM_NEXT()                                                              \
+  do {                                                                         \
+    ins = &code[pc++];                                                         \
+    goto *table[static_cast<std::size_t>(ins->op)];                            \
+  } while (0)
+#else
+#define VM_OP(name) case OpCode::name
+#define VM_NEXT() continue
+#define VM_FALLTHROUGH [[fallthrough]]
+#endif
+
+void VM::run() {
+  frames_.clear();
+  frames_.push_back(CallFrame{&program_.main, 0, 0, 0});
+  regs_.assign(program_.main.num_regs, Value());
+
+  Function *fn = &program_.main;
+  Instr *code = fn->code.data();
+  const Value *K = fn->constants.data();
+  std::size_t pc = 0;
+  Value *R = regs_.data();
+  Instr *ins;
+
+#ifdef CIMPLE_VM_THREADED
+  void *table[kOpCodeCount];
+#define CIMPLE_VM_LABEL(name)                                                  \
+  table[static_cast<std::size_t>(OpCode::name)] = &&op_##name;
+  CIMPLE_VM_OPCODES(CIMPLE_VM_LABEL)
+#undef CIMPLE_VM_LABEL
+  VM_NEXT();
+#else
+  for (;;) {
+    ins = &code[pc++];
+    switch (ins->op) {
+#endif
+
+  VM_OP(LoadK):
+    R[ins->a] = K[ins->bx()];
+    VM_NEXT();
+  VM_OP(LoadNil):
+    set_unset(R[ins->a]);
+    VM_NEXT();
+  VM_OP(LoadBool):
+    set_bool(R[ins->a], ins->n != 0);
+    VM_NEXT();
+  VM_OP(Move):
+    R[ins->a] = R[ins->b];
+    VM_NEXT();
+  VM_OP(SetLocal):
+    if (R[ins->b].is_set())
+      R[ins->a] = R[ins->b];
+    VM_NEXT();
+  VM_OP(GetGlobal):
+    R[ins->a] = regs_[ins->bx()];
+    VM_NEXT();
+  VM_OP(InheritGlobal):
+    if (!R[ins->a].is_set())
+      R[ins->a] = regs_[ins->bx()];
+    VM_NEXT();
+
+  VM_OP(LoadKAdd):
+  VM_OP(LoadKSub): {
+    const OpCode op =
+        ins->op == OpCode::LoadKAdd ? OpCode::Add : OpCode::Sub;
+    R[ins->a] = K[ins->bx()];
+    ins = &code[pc++]; // the Add or Sub, quickened or not, for its operands
+    add_sub(op, R[ins->b], R[ins->c], R[ins->a]);
+    VM_NEXT();
+  }
+  // Generic arithmetic that may quicken: two operands of one kind rewrite
+  // the instruction to the specialized opcode for next time.
+  VM_OP(Add):
+  VM_OP(Sub):
+  VM_OP(Mul):
+  VM_OP(Div): {
+    const OpCode op = ins->op;
+    const Value &L = R[ins->b];
+    const Value &Rv = R[ins->c];
+    if (L.kind() == Rv.kind() && ins->n < kMaxDeopts)
+      ins->op = quickened_opcode(op, L.kind());
+    arith(op, L, Rv, R[ins->a]);
+    VM_NEXT();
+  }
+  VM_OP(FloorDiv):
+  VM_OP(Mod):
+  VM_OP(Pow): {
+    const Value &L = R[ins->b];
+    const Value &Rv = R[ins->c];
+    if (!L.is_set() || !Rv.is_set())
+      set_unset(R[ins->a]);
+    else
+      arith(ins->op, L, Rv, R[ins->a]);
+    VM_NEXT();
+  }
+  VM_OP(AddLocalK):
+    step_local(OpCode::Add, R[ins->a], K[ins->bx()]);
+    VM_NEXT();
+  VM_OP(SubLocalK):
+    step_local(OpCode::Sub, R[ins->a], K[ins->bx()]);
+    VM_NEXT();
+  VM_OP(BitAnd):
+  VM_OP(BitOr):
+  VM_OP(BitXor):
+  VM_OP(Shl):
+  VM_OP(Shr):
+    bitwise(ins->op, R[ins->b], R[ins->c], R[ins->a]);
+    VM_NEXT();
+  VM_OP(Eq):
+  VM_OP(Ne):
+  VM_OP(Lt):
+  VM_OP(Gt):
+  VM_OP(Le):
+  VM_OP(Ge):
+    compare(ins->op, R[ins->b], R[ins->c], R[ins->a]);
+    VM_NEXT();
+
+  // Compare, then branch on the result with the jump after it.
+#define CIMPLE_VM_COMPARE_JUMP(name)                                           \
+  VM_OP(name##Jmp):                                                            \
+    if (compare_test(OpCode::name, R[ins->b], R[ins->c], R[ins->a]) ==         \
+        (code[pc].op == OpCode::JmpIfTrue))                                    \
+      pc = code[pc].bx();                                                      \
+    else                                                                       \
+      ++pc;                                                                    \
+    VM_NEXT();
+  CIMPLE_VM_COMPARE_JUMP(Eq)
+  CIMPLE_VM_COMPARE_JUMP(Ne)
+  CIMPLE_VM_COMPARE_JUMP(Lt)
+  CIMPLE_VM_COMPARE_JUMP(Gt)
+  CIMPLE_VM_COMPARE_JUMP(Le)
+  CIMPLE_VM_COMPARE_JUMP(Ge)
+#undef CIMPLE_VM_COMPARE_JUMP
+
+  // Quickened arithmetic. A failed guard deoptimizes the instruction and
+  // runs the generic operation.
+#define CIMPLE_VM_QUICK(name, type, get, put, oper, guard)                     \
+  VM_OP(name##type): {                                                         \
+    const Value &L = R[ins->b];                                                \
+    const Value &Rv = R[ins->c];                                               \
+    if (L.kind() == Value::type && Rv.kind() == Value::type && (guard)) {      \
+      put(R[ins->a], L.get() oper Rv.get());                                   \
+      VM_NEXT();                                                               \
+    }                                                                          \
+    deoptimize(*ins);                                                          \
+    arith(ins->op, L, Rv, R[ins->a]);                                          \
+    VM_NEXT();                                                                 \
+  }
+  CIMPLE_VM_QUICK(Add, Int, as_int, set_int, +, true)
+  CIMPLE_VM_QUICK(Sub, Int, as_int, set_int, -, true)
+  CIMPLE_VM_QUICK(Mul, Int, as_int, set_int, *, true)
+  CIMPLE_VM_QUICK(Add, Float, as_float, set_float, +, true)
+  CIMPLE_VM_QUICK(Sub, Float, as_float, set_float, -, true)
+  CIMPLE_VM_QUICK(Mul, Float, as_float, set_float, *, true)
+  CIMPLE_VM_QUICK(Div, Float, as_float, set_float, /, Rv.as_float() != 0.0)
+#undef CIMPLE_VM_QUICK
+
+  VM_OP(Neg): {
+    const Value &v = R[ins->b];
+    if (v.kind() == Value::Int)
+      set_int(R[ins->a], -v.as_int());
+    else if (v.kind() == Value::Float)
+      set_float(R[ins->a], -v.as_float());
+    else
+      set_unset(R[ins->a]);
+    VM_NEXT();
+  }
+  VM_OP(BitNot): {
+    const Value &v = R[ins->b];
+    if (v.kind() == Value::Int)
+      set_int(R[ins->a], ~v.as_int());
+    else
+      set_unset(R[ins->a]);
+    VM_NEXT();
+  }
+  VM_OP(Not):
+  VM_OP(ToBool): {
+    const Value &v = R[ins->b];
+    if (!v.is_set()) {
+      set_unset(R[ins->a]);
+      VM_NEXT();
+    }
+    const bool t = truthy(v);
+    set_bool(R[ins->a], ins->op == OpCode::Not ? !t : t);
+    VM_NEXT();
+  }
+
+  VM_OP(Jmp):
+    pc = ins->bx();
+    VM_NEXT();
+  VM_OP(JmpIfFalse):
+    if (!truthy(R[ins->a]))
+      pc = ins->bx();
+    VM_NEXT();
+  VM_OP(JmpIfTrue):
+    if (truthy(R[ins->a]))
+      pc = ins->bx();
+    VM_NEXT();
+  VM_OP(JmpIfUnset):
+    if (!R[ins->a].is_set())
+      pc = ins->bx();
+    VM_NEXT();
+
+  VM_OP(Call): {
+    Function *callee = &program_.functions[ins->b];
+    const std::size_t base = frames_.back().base + ins->c;
+
+    frames_.back().pc = pc;
+    frames_.push_back(CallFrame{callee, 0, base, ins->a});
+    if (regs_.size() < base + callee->num_regs)
+      regs_.resize(base + callee->num_regs);
+
+    fn = callee;
+    code = fn->code.data();
+    K = fn->constants.data();
+    pc = 0;
+    R = regs_.data() + base;
+
+    // Arguments already sit in the parameter slots; everything else in
+    // the function scope starts unset (extra arguments included).
+    const std::uint32_t argc =
+        ins->n < fn->num_params ? ins->n : fn->num_params;
+    for (std::uint32_t i = argc; i < fn->scope_slots; ++i)
+      set_unset(R[i]);
+    VM_NEXT();
+  }
+  VM_OP(Print):
+    if (R[ins->a].is_set())
+      std::cout << R[ins->a];
+    VM_NEXT();
+  VM_OP(PrintLn):
+    std::cout << '\n';
+    set_unset(R[ins->a]);
+    VM_NEXT();
+  VM_OP(Escape):
+    std::cerr << "Invalid control flow: break/continue escaped function\n";
+    VM_FALLTHROUGH;
+  VM_OP(Ret):
+  VM_OP(RetNil): {
+    Value result;
+    if (ins->op == OpCode::Ret)
+      result = std::move(R[ins->a]);
+
+    const std::uint16_t ret_reg = frames_.back().ret_reg;
+    frames_.pop_back();
+
+    const CallFrame &caller = frames_.back();
+    fn = caller.fn;
+    code = fn->code.data();
+    K = fn->constants.data();
+    pc = caller.pc;
+    R = regs_.data() + caller.base;
+    R[ret_reg] = std::move(result);
+    VM_NEXT();
+  }
+  VM_OP(Halt):
+    std::cout.flush();
+    return;
+
+#ifndef CIMPLE_VM_THREADED
+    }
+  }
+#endif
+}
+
+#undef VM_OP
+#undef VM_NEXT
+#undef VM_FALLTHROUGH
@@ -1,195 +1,400 @@
 // lexer.cpp - basic lexer for the same syntax as Python
 // Optimized with std::string_view for zero-copy performance
 #include "frontend/lexer/lexer.h"
-#include <cctype>
+#include "frontend/lexer/char_class.h"
+#include "frontend/lexer/keywords.h"
+#include "frontend/lexer/scan.h"
+#include <algorithm>
 #include <sstream>
 #include <string_view>
-#include <unordered_set>
+#include <thread>
+#include <unordered_map>
 
 using namespace cimple::lexer;
 
-// Use unordered_set for O(1) keyword lookup with string_view
-static const std::unordered_set<std::string_view> keywords = {
-    "def",   "return", "if",   "elif", "else", "for",   "while",
-    "in",    "import", "from", "as",   "pass", "break", "continue",
-    "class", "and",    "or",   "not",  "True", "False", "None"};
+using cimple::diagnostics::kTabWidth;
 
-static bool is_keyword(std::string_view s) {
-  return keywords.find(s) != keywords.end();
-}
+namespace {
 
-std::vector<Token> cimple::lexer::lex(const std::string &source) {
-  return lex_from_view(source);
+struct OpMatch {
+  TokenKind kind;
+  size_t length;
+};
+
+// Classify the operator or punctuation at `s[0]`; `avail` (>= 1) is the
+// number of bytes left on the line. Two-character operators win over their
+// one-character prefix. Anything unrecognised is a one-byte OP_OTHER.
+OpMatch match_operator(const char *s, size_t avail) {
+  const char next = avail > 1 ? s[1] : '\0';
+  auto either = [next](char second, TokenKind two, TokenKind one) {
+    return next == second ? OpMatch{two, 2} : OpMatch{one, 1};
+  };
+  switch (s[0]) {
+  case '(':
+    return {TokenKind::OP_LPAREN, 1};
+  case ')':
+    return {TokenKind::OP_RPAREN, 1};
+  case '[':
+    return {TokenKind::OP_LBRACKET, 1};
+  case ']':
+    return {TokenKind::OP_RBRACKET, 1};
+  case '{':
+    return {TokenKind::OP_LBRACE, 1};
+  case '}':
+    return {TokenKind::OP_RBRACE, 1};
+  case ',':
+    return {TokenKind::OP_COMMA, 1};
+  case ';':
+    return {TokenKind::OP_SEMI, 1};
+  case '.':
+    return {TokenKind::OP_DOT, 1};
+  case '@':
+    return {TokenKind::OP_AT, 1};
+  case '%':
+    return {TokenKind::OP_PERCENT, 1};
+  case '&':
+    return {TokenKind::OP_AMP, 1};
+  case '|':
+    return {TokenKind::OP_PIPE, 1};
+  case '^':
+    return {TokenKind::OP_CARET, 1};
+  case '~':
+    return {TokenKind::OP_TILDE, 1};
+  case ':':
+    return either(':', TokenKind::OP_COLON_COLON, TokenKind::OP_COLON);
+  case '=':
+    return either('=', TokenKind::OP_EQ_EQ, TokenKind::OP_ASSIGN);
+  case '!':
+    return either('=', TokenKind::OP_NOT_EQ, TokenKind::OP_OTHER);
+  case '+':
+    return either('=', TokenKind::OP_PLUS_EQ, TokenKind::OP_PLUS);
+  case '-':
+    if (next == '>')
+      return {TokenKind::OP_ARROW, 2};
+    return either('=', TokenKind::OP_MINUS_EQ, TokenKind::OP_MINUS);
+  case '*':
+    if (next == '*')
+      return {TokenKind::OP_STAR_STAR, 2};
+    return either('=', TokenKind::OP_STAR_EQ, TokenKind::OP_STAR);
+  case '/':
+    if (next == '/')
+      return {TokenKind::OP_SLASH_SLASH, 2};
+    return either('=', TokenKind::OP_SLASH_EQ, TokenKind::OP_SLASH);
+  case '<':
+    if (next == '<')
+      return {TokenKind::OP_LSHIFT, 2};
+    return either('=', TokenKind::OP_LT_EQ, TokenKind::OP_LT);
+  case '>':
+    if (next == '>')
+      return {TokenKind::OP_RSHIFT, 2};
+    return either('=', TokenKind::OP_GT_EQ, TokenKind::OP_GT);
+  default:
+    return {TokenKind::OP_OTHER, 1};
+  }
 }
 
-std::vector<Token> cimple::lexer::lex_from_view(std::string_view source) {
-  std::vector<Token> out;
-  std::vector<int> indent_stack = {0};
-  int lineno = 0;
+} // namespace
 
-  // Process line by line using string_view to avoid copies
-  size_t line_start = 0;
-  while (line_start < source.length()) {
-    ++lineno;
+// ---------------------------------------------------------------------------
+// Lexer
+// ---------------------------------------------------------------------------
 
-    // Find end of line
-    size_t line_end = source.find('\n', line_start);
-    if (line_end == std::string_view::npos) {
-      line_end = source.length();
-    }
+struct Lexer::Chunk {
+  std::string_view text;
+  std::vector<Token> tokens; // offsets relative to `text`
 
-    std::string_view line = source.substr(line_start, line_end - line_start);
-    line_start = line_end + 1;
+  // Chunk-local symbols: IDENT tokens carry an index into `names` (from 1)
+  // until the merge interns them.
+  std::unordered_map<std::string_view, SymbolId> ids;
+  std::vector<std::string_view> names = {std::string_view()};
 
-    // Convert tabs to spaces (we need a string for this transformation)
-    std::string tline;
-    tline.reserve(line.length() * 4); // Reserve space for tab expansion
-    for (char c : line) {
-      if (c == '\t') {
-        tline.append(4, ' ');
-      } else {
-        tline.push_back(c);
-      }
-    }
+  SymbolId intern(std::string_view name) {
+    auto [it, inserted] =
+        ids.try_emplace(name, static_cast<SymbolId>(names.size()));
+    if (inserted)
+      names.push_back(name);
+    return it->second;
+  }
+};
+
+Lexer::Lexer(std::string_view source)
+    : source_(source), scan_(scan_kernels()) {}
 
-    // Now work with tline as string_view for the rest
-    std::string_view tline_view = tline;
+Lexer::Lexer(std::string_view source, Chunk &chunk)
+    : source_(source), scan_(scan_kernels()), chunk_(&chunk) {}
 
-    // Count leading spaces
+// Advance to the next line that holds a token, queueing its INDENT or
+// DEDENTs. Returns false at end of input.
+bool Lexer::start_line() {
+  while (line_start_ < source_.length()) {
+    const size_t line_end =
+        scan_.find_newline(source_.data(), line_start_, source_.length());
+    std::string_view line = source_.substr(line_start_, line_end - line_start_);
+    line_start_ = line_end + 1;
+    // A CR before the LF belongs to the line terminator. Sources are read in
+    // binary mode, so Windows line endings reach the lexer unchanged.
+    if (!line.empty() && line.back() == '\r')
+      line.remove_suffix(1);
+    const char *text = line.data();
+    const size_t len = line.length();
+
+    // Leading whitespace: a tab counts as kTabWidth columns.
     size_t pos = 0;
-    while (pos < tline_view.length() && tline_view[pos] == ' ')
+    int indent = 0;
+    for (;;) {
+      const size_t spaces_end = scan_.skip_spaces(text, pos, len);
+      indent += static_cast<int>(spaces_end - pos);
+      pos = spaces_end;
+      if (pos == len || text[pos] != '\t')
+        break;
+      indent += kTabWidth;
       ++pos;
+    }
 
     // Skip empty or comment-only lines
-    size_t first_non_ws = tline_view.find_first_not_of(' ');
-    if (first_non_ws == std::string_view::npos)
-      continue;
-    if (tline_view[first_non_ws] == '#')
+    if (pos == len || text[pos] == '#')
       continue;
 
-    int indent = static_cast<int>(pos);
-    if (indent > indent_stack.back()) {
-      indent_stack.push_back(indent);
-      out.push_back({TokenType::INDENT, "", {lineno, 1}});
+    if (chunk_) {
+      pending_indent_ = true;
+      line_indent_ = indent;
+    } else if (indent > indent_stack_.back()) {
+      indent_stack_.push_back(indent);
+      pending_indent_ = true;
     } else {
-      while (indent < indent_stack.back()) {
-        indent_stack.pop_back();
-        out.push_back({TokenType::DEDENT, "", {lineno, 1}});
+      while (indent < indent_stack_.back()) {
+        indent_stack_.pop_back();
+        ++pending_dedents_;
       }
     }
+    line_ = line;
+    pos_ = pos;
+    in_line_ = true;
+    return true;
+  }
+  return false;
+}
 
-    // Tokenize the rest of the line using string_view
-    size_t i = pos;
-    int col = static_cast<int>(pos) + 1;
-    while (i < tline_view.length()) {
-      char c = tline_view[i];
-      if (c == ' ' || c == '\r' || c == '\n') {
-        ++i;
-        ++col;
-        continue;
-      }
-      if (c == '#') {
-        // comment: skip rest of line, don't emit a token
-        break;
-      }
+Token Lexer::next() {
+  const auto end = static_cast<SourceOffset>(source_.length());
+  if (done_)
+    return {TokenType::ENDMARKER, "", end};
 
-      if (std::isalpha((unsigned char)c) || c == '_') {
-        size_t j = i + 1;
-        while (j < tline_view.length() &&
-               (std::isalnum((unsigned char)tline_view[j]) ||
-                tline_view[j] == '_'))
-          ++j;
-        std::string_view ident_view = tline_view.substr(i, j - i);
-        TokenType tt =
-            is_keyword(ident_view) ? TokenType::KEYWORD : TokenType::IDENT;
-        // Convert to string only when storing in Token
-        out.push_back({tt, std::string(ident_view), {lineno, col}});
-        col += static_cast<int>(j - i);
-        i = j;
-        continue;
-      }
+  if (!in_line_ && !start_line()) {
+    // close remaining indents
+    if (!chunk_ && indent_stack_.size() > 1) {
+      indent_stack_.pop_back();
+      ++count_;
+      return {TokenType::DEDENT, "", end};
+    }
+    done_ = true;
+    ++count_;
+    return {TokenType::ENDMARKER, "", end};
+  }
+
+  ++count_;
+  const SourceOffset line_offset = offset_of(line_.data());
+  if (pending_indent_) {
+    pending_indent_ = false;
+    // In chunk mode the INDENT carries the line's indent width in `sym`.
+    return {TokenType::INDENT, "", line_offset,
+            chunk_ ? static_cast<SymbolId>(line_indent_) : kNoSymbol};
+  }
+  if (pending_dedents_ > 0) {
+    --pending_dedents_;
+    return {TokenType::DEDENT, "", line_offset};
+  }
+  return scan_token();
+}
+
+// The next token of the current line, or its NEWLINE.
+Token Lexer::scan_token() {
+  const std::string_view line = line_;
+  const char *text = line.data();
+  const size_t len = line.length();
+  size_t i = pos_;
+
+  while (i < len) {
+    char c = text[i];
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+      ++i;
+      continue;
+    }
+    if (c == '#') {
+      // comment: skip rest of line, don't emit a token
+      break;
+    }
 
-      if (std::isdigit((unsigned char)c)) {
-        size_t j = i + 1;
-        bool has_dot = false;
-        while (j < tline_view.length() &&
-               (std::isdigit((unsigned char)tline_view[j]) ||
-                (!has_dot && tline_view[j] == '.'))) {
-          if (tline_view[j] == '.')
-            has_dot = true;
+    const SourceOffset loc = offset_of(text + i);
+    size_t j;
+    Token tok;
+    if (is_ident_start(c)) {
+      j = scan_.skip_ident(text, i + 1, len);
+      std::string_view ident_view = line.substr(i, j - i);
+      if (const KeywordEntry *kw = find_keyword(ident_view)) {
+        tok = {TokenType::KEYWORD, kw->name, loc, keyword_symbol(kw->kind),
+               kw->kind};
+      } else if (chunk_) {
+        tok = {TokenType::IDENT, ident_view, loc, chunk_->intern(ident_view)};
+      } else {
+        const SymbolId id = intern(ident_view);
+        tok = {TokenType::IDENT, symbol_name(id), loc, id};
+      }
+    } else if (is_digit(c)) {
+      // Digits with at most one '.'.
+      j = scan_.skip_digits(text, i + 1, len);
+      if (j < len && text[j] == '.')
+        j = scan_.skip_digits(text, j + 1, len);
+      tok = {TokenType::NUMBER, line.substr(i, j - i), loc};
+    } else if (c == '"' || c == '\'') {
+      // The lexeme is the raw literal, quotes and escapes included.
+      char quote = c;
+      j = i + 1;
+      while (j < len) {
+        j = scan_.find_quote_or_escape(text, j, len, quote);
+        if (j == len)
+          break;
+        if (text[j] == quote) {
           ++j;
+          break;
         }
-        std::string_view num_view = tline_view.substr(i, j - i);
-        out.push_back(
-            {TokenType::NUMBER, std::string(num_view), {lineno, col}});
-        col += static_cast<int>(j - i);
-        i = j;
-        continue;
+        // Backslash: skip the escaped character, if any.
+        j += j + 1 < len ? 2 : 1;
       }
+      tok = {TokenType::STRING, line.substr(i, j - i), loc};
+    } else {
+      // operators and punctuation
+      const OpMatch op = match_operator(text + i, len - i);
+      j = i + op.length;
+      tok = {TokenType::OP, line.substr(i, op.length), loc, kNoSymbol,
+             op.kind};
+    }
+    pos_ = j;
+    return tok;
+  }
 
-      if (c == '"' || c == '\'') {
-        char quote = c;
-        size_t j = i + 1;
-        std::string buf;
-        buf.push_back(quote);
-        while (j < tline_view.length()) {
-          char cc = tline_view[j];
-          buf.push_back(cc);
-          if (cc == quote) {
-            ++j;
-            break;
-          }
-          if (cc == '\\' && j + 1 < tline_view.length()) {
-            buf.push_back(tline_view[j + 1]);
-            j += 2;
-            continue;
+  // end of logical line, after any trailing comment
+  in_line_ = false;
+  return {TokenType::NEWLINE, "", offset_of(text + len)};
+}
+
+std::vector<Token> cimple::lexer::lex(const std::string &source) {
+  return lex_from_view(source);
+}
+
+std::vector<Token> cimple::lexer::lex_from_view(std::string_view source) {
+  std::vector<Token> out;
+  if (source.length() >= kParallelLexMinBytes) {
+    const unsigned threads = std::thread::hardware_concurrency();
+    if (threads > 1)
+      return lex_parallel(source, threads);
+  }
+
+  // Typical source averages well over four bytes per token; reserving up
+  // front avoids most reallocation on large files.
+  out.reserve(source.length() / 4 + 16);
+  Lexer lexer(source);
+  do {
+    out.push_back(lexer.next());
+  } while (out.back().type != TokenType::ENDMARKER);
+  return out;
+}
+
+// ---------------------------------------------------------------------------
+// Parallel lexing
+// ---------------------------------------------------------------------------
+
+void Lexer::lex_chunk(Chunk *chunk) {
+  Lexer lexer(chunk->text, *chunk);
+  chunk->tokens.reserve(chunk->text.length() / 4 + 16);
+  for (;;) {
+    Token tok = lexer.next();
+    if (tok.type == TokenType::ENDMARKER)
+      break;
+    chunk->tokens.push_back(tok);
+  }
+}
+
+std::vector<Token> cimple::lexer::lex_parallel(std::string_view source,
+                                               unsigned chunks) {
+  // Cut just after a newline near each multiple of source/chunks, so every
+  // chunk starts at the beginning of a line.
+  std::vector<Lexer::Chunk> parts;
+  const size_t target = source.length() / (chunks ? chunks : 1) + 1;
+  size_t start = 0;
+  while (start < source.length()) {
+    size_t end = std::min(start + target, source.length());
+    if (end < source.length()) {
+      end = source.find('\n', end - 1);
+      end = end == std::string_view::npos ? source.length() : end + 1;
+    }
+    parts.emplace_back().text = source.substr(start, end - start);
+    start = end;
+  }
+
+  std::vector<std::thread> workers;
+  for (size_t c = 1; c < parts.size(); ++c)
+    workers.emplace_back(&Lexer::lex_chunk, &parts[c]);
+  if (!parts.empty())
+    Lexer::lex_chunk(&parts[0]);
+  for (auto &w : workers)
+    w.join();
+
+  // Merge: rebase offsets onto the whole source, intern each chunk's
+  // identifiers in first-use order (so ids match the sequential lexer), and
+  // turn the per-line indent marks into INDENT/DEDENT against the running
+  // indent stack.
+  size_t total = 1;
+  for (const auto &part : parts)
+    total += part.tokens.size();
+  std::vector<Token> out;
+  out.reserve(total);
+
+  std::vector<int> indent_stack = {0};
+  std::vector<SymbolId> ids;
+  std::vector<std::string_view> spellings;
+  for (auto &part : parts) {
+    ids.assign(part.names.size(), kNoSymbol);
+    spellings.assign(part.names.size(), std::string_view());
+    for (size_t k = 1; k < part.names.size(); ++k) {
+      ids[k] = intern(part.names[k]);
+      spellings[k] = symbol_name(ids[k]);
+    }
+
+    const auto base =
+        static_cast<SourceOffset>(part.text.data() - source.data());
+    for (Token tok : part.tokens) {
+      tok.offset += base;
+      if (tok.type == TokenType::INDENT) {
+        const int indent = static_cast<int>(tok.sym);
+        if (indent > indent_stack.back()) {
+          indent_stack.push_back(indent);
+          out.push_back({TokenType::INDENT, "", tok.offset});
+        } else {
+          while (indent < indent_stack.back()) {
+            indent_stack.pop_back();
+            out.push_back({TokenType::DEDENT, "", tok.offset});
           }
-          ++j;
         }
-        out.push_back({TokenType::STRING, buf, {lineno, col}});
-        col += static_cast<int>(j - i);
-        i = j;
         continue;
       }
-
-      // operators and punctuation
-      std::string_view op_view = tline_view.substr(i, 1);
-      // support two-char ops
-      if (i + 1 < tline_view.length()) {
-        std::string_view two_view = tline_view.substr(i, 2);
-        static const std::vector<std::string_view> two_ops = {
-            "==", "!=", "<=", ">=", "+=", "-=", "*=",
-            "/=", "//", "**", "->", "::", "<<", ">>"};
-        for (auto &o : two_ops) {
-          if (o == two_view) {
-            out.push_back(
-                {TokenType::OP, std::string(two_view), {lineno, col}});
-            i += 2;
-            col += 2;
-            goto next_char;
-          }
-        }
+      if (tok.type == TokenType::IDENT) {
+        tok.set_lexeme(spellings[tok.sym]);
+        tok.sym = ids[tok.sym];
       }
-      out.push_back({TokenType::OP, std::string(op_view), {lineno, col}});
-      ++i;
-      ++col;
-    next_char:;
+      out.push_back(tok);
     }
-
-    // end of logical line
-    out.push_back({TokenType::NEWLINE,
-                   "",
-                   {lineno, static_cast<int>(tline_view.length()) + 1}});
+    // Release each chunk's tokens as soon as they are merged.
+    std::vector<Token>().swap(part.tokens);
   }
 
   // close remaining indents
+  const auto end = static_cast<SourceOffset>(source.length());
   while (indent_stack.size() > 1) {
     indent_stack.pop_back();
-    out.push_back(
-        {TokenType::DEDENT, "", {static_cast<int>(indent_stack.size()), 1}});
+    out.push_back({TokenType::DEDENT, "", end});
   }
-
-  out.push_back({TokenType::ENDMARKER, "", {lineno + 1, 1}});
+  out.push_back({TokenType::ENDMARKER, "", end});
   return out;
 }
 
@@ -221,11 +426,14 @@ std::string cimple::lexer::token_type_to_string(TokenType t) {
   return "<unknown>";
 }
 
-std::string cimple::lexer::token_to_string(const Token &tok) {
+std::string
+cimple::lexer::token_to_string(const Token &tok,
+                               const cimple::diagnostics::LineTable &lines) {
+  const SourceLocation loc = lines.locate(tok.offset);
   std::ostringstream ss;
   ss << token_type_to_string(tok.type) << " ";
-  if (!tok.lexeme.empty())
-    ss << "('" << tok.lexeme << "') ";
-  ss << "@" << tok.loc.line << ":" << tok.loc.column;
+  if (!tok.lexeme().empty())
+    ss << "('" << tok.lexeme() << "') ";
+  ss << "@" << loc.line << ":" << loc.column;
   return ss.str();
 }
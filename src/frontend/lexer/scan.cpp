@@ -0,0 +1,223 @@
+// scan.cpp - scalar and SSE2 byte-scanning kernels, runtime dispatch
+#include "frontend/lexer/scan.h"
+#include "frontend/lexer/char_class.h"
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CIMPLE_SCAN_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+using namespace cimple::lexer;
+
+// ---------------------------------------------------------------------------
+// Scalar kernels (also used for the tails of the vector kernels)
+// ---------------------------------------------------------------------------
+
+namespace {
+
+std::size_t scalar_find_newline(const char *s, std::size_t pos,
+                                std::size_t len) {
+  while (pos < len && s[pos] != '\n')
+    ++pos;
+  return pos;
+}
+
+std::size_t scalar_skip_spaces(const char *s, std::size_t pos,
+                               std::size_t len) {
+  while (pos < len && s[pos] == ' ')
+    ++pos;
+  return pos;
+}
+
+std::size_t scalar_skip_ident(const char *s, std::size_t pos,
+                              std::size_t len) {
+  while (pos < len && is_ident_char(s[pos]))
+    ++pos;
+  return pos;
+}
+
+std::size_t scalar_skip_digits(const char *s, std::size_t pos,
+                               std::size_t len) {
+  while (pos < len && is_digit(s[pos]))
+    ++pos;
+  return pos;
+}
+
+std::size_t scalar_find_quote_or_escape(const char *s, std::size_t pos,
+                                        std::size_t len, char quote) {
+  while (pos < len && s[pos] != quote && s[pos] != '\\')
+    ++pos;
+  return pos;
+}
+
+const ScanKernels kScalar = {scalar_find_newline, scalar_skip_spaces,
+                             scalar_skip_ident,   scalar_skip_digits,
+                             scalar_find_quote_or_escape, "scalar"};
+
+} // namespace
+
+const ScanKernels &cimple::lexer::detail::scalar_scan_kernels() {
+  return kScalar;
+}
+
+// ---------------------------------------------------------------------------
+// SSE2 kernels: 16 bytes per step
+// ---------------------------------------------------------------------------
+
+#ifdef CIMPLE_SCAN_SSE2
+namespace {
+
+inline unsigned first_set_bit(unsigned mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+// Bytes in [lo, hi], via a biased signed compare (SSE2 has no unsigned one).
+inline __m128i in_range(__m128i v, char lo, char hi) {
+  const __m128i biased =
+      _mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(0x80 - lo)));
+  return _mm_cmplt_epi8(biased,
+                        _mm_set1_epi8(static_cast<char>(-128 + (hi - lo) + 1)));
+}
+
+// Scan 16-byte blocks while `stop(block)` marks no byte, then finish with
+// the scalar kernel.
+template <typename Stop, typename Tail>
+std::size_t scan_blocks(const char *s, std::size_t pos, std::size_t len,
+                        Stop stop, Tail tail) {
+  while (pos + 16 <= len) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + pos));
+    const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(stop(v)));
+    if (mask)
+      return pos + first_set_bit(mask);
+    pos += 16;
+  }
+  return tail(pos);
+}
+
+std::size_t sse2_find_newline(const char *s, std::size_t pos,
+                              std::size_t len) {
+  const __m128i nl = _mm_set1_epi8('\n');
+  return scan_blocks(
+      s, pos, len, [&](__m128i v) { return _mm_cmpeq_epi8(v, nl); },
+      [&](std::size_t p) { return scalar_find_newline(s, p, len); });
+}
+
+std::size_t sse2_skip_spaces(const char *s, std::size_t pos,
+                             std::size_t len) {
+  const __m128i sp = _mm_set1_epi8(' ');
+  const __m128i ones = _mm_set1_epi8(-1);
+  return scan_blocks(
+      s, pos, len,
+      [&](__m128i v) { return _mm_xor_si128(_mm_cmpeq_epi8(v, sp), ones); },
+      [&](std::size_t p) { return scalar_skip_spaces(s, p, len); });
+}
+
+std::size_t sse2_skip_ident(const char *s, std::size_t pos, std::size_t len) {
+  const __m128i lower = _mm_set1_epi8(0x20);
+  const __m128i under = _mm_set1_epi8('_');
+  const __m128i ones = _mm_set1_epi8(-1);
+  return scan_blocks(
+      s, pos, len,
+      [&](__m128i v) {
+        const __m128i alpha = in_range(_mm_or_si128(v, lower), 'a', 'z');
+        const __m128i digit = in_range(v, '0', '9');
+        const __m128i ident = _mm_or_si128(
+            _mm_or_si128(alpha, digit), _mm_cmpeq_epi8(v, under));
+        return _mm_xor_si128(ident, ones);
+      },
+      [&](std::size_t p) { return scalar_skip_ident(s, p, len); });
+}
+
+std::size_t sse2_skip_digits(const char *s, std::size_t pos,
+                             std::size_t len) {
+  const __m128i ones = _mm_set1_epi8(-1);
+  return scan_blocks(
+      s, pos, len,
+      [&](__m128i v) { return _mm_xor_si128(in_range(v, '0', '9'), ones); },
+      [&](std::size_t p) { return scalar_skip_digits(s, p, len); });
+}
+
+std::size_t sse2_find_quote_or_escape(const char *s, std::size_t pos,
+                                      std::size_t len, char quote) {
+  const __m128i q = _mm_set1_epi8(quote);
+  const __m128i bs = _mm_set1_epi8('\\');
+  return scan_blocks(
+      s, pos, len,
+      [&](__m128i v) {
+        return _mm_or_si128(_mm_cmpeq_epi8(v, q), _mm_cmpeq_epi8(v, bs));
+      },
+      [&](std::size_t p) {
+        return scalar_find_quote_or_escape(s, p, len, quote);
+      });
+}
+
+const ScanKernels kSse2 = {sse2_find_newline, sse2_skip_spaces,
+                           sse2_skip_ident,   sse2_skip_digits,
+                           sse2_find_quote_or_escape, "sse2"};
+
+} // namespace
+#endif // CIMPLE_SCAN_SSE2
+
+const ScanKernels *cimple::lexer::detail::sse2_scan_kernels() {
+#ifdef CIMPLE_SCAN_SSE2
+  return &kSse2;
+#else
+  return nullptr;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+namespace {
+
+bool cpu_has_avx2() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#elif (defined(__GNUC__) || defined(__clang__)) &&                             \
+    (defined(__x86_64__) || defined(__i386__))
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+const ScanKernels &select_kernels() {
+  if (const ScanKernels *avx2 = detail::avx2_scan_kernels())
+    if (cpu_has_avx2())
+      return *avx2;
+  if (const ScanKernels *sse2 = detail::sse2_scan_kernels())
+    return *sse2;
+  return kScalar;
+}
+
+} // namespace
+
+const ScanKernels &cimple::lexer::scan_kernels() {
+  static const ScanKernels &kernels = select_kernels();
+  return kernels;
+}
@@ -0,0 +1,132 @@
+// scan_avx2.cpp - AVX2 byte-scanning kernels
+//
+// This file is compiled with AVX2 enabled (see tools/cimple_cli/
+// CMakeLists.txt) and only runs after scan_kernels() has checked the CPU.
+// It must not instantiate inline functions or templates shared with other
+// translation units: the linker could keep this file's AVX2-encoded copy for
+// the whole program. Scalar tails therefore go through the scalar kernel
+// table instead of the char-class helpers.
+#include "frontend/lexer/scan.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+using namespace cimple::lexer;
+
+namespace {
+
+unsigned first_set_bit(unsigned mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+__m256i in_range(__m256i v, char lo, char hi) {
+  const __m256i biased =
+      _mm256_add_epi8(v, _mm256_set1_epi8(static_cast<char>(0x80 - lo)));
+  return _mm256_cmpgt_epi8(
+      _mm256_set1_epi8(static_cast<char>(-128 + (hi - lo) + 1)), biased);
+}
+
+// Index of the first byte set in `stop` within the 32-byte block at `pos`,
+// or 32 when none is.
+unsigned first_stop(__m256i stop) {
+  const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(stop));
+  return mask ? first_set_bit(mask) : 32;
+}
+
+__m256i load(const char *s, std::size_t pos) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + pos));
+}
+
+std::size_t avx2_find_newline(const char *s, std::size_t pos,
+                              std::size_t len) {
+  const __m256i nl = _mm256_set1_epi8('\n');
+  for (; pos + 32 <= len; pos += 32) {
+    const unsigned i = first_stop(_mm256_cmpeq_epi8(load(s, pos), nl));
+    if (i < 32)
+      return pos + i;
+  }
+  return detail::scalar_scan_kernels().find_newline(s, pos, len);
+}
+
+std::size_t avx2_skip_spaces(const char *s, std::size_t pos,
+                             std::size_t len) {
+  const __m256i sp = _mm256_set1_epi8(' ');
+  const __m256i ones = _mm256_set1_epi8(-1);
+  for (; pos + 32 <= len; pos += 32) {
+    const __m256i v = load(s, pos);
+    const unsigned i =
+        first_stop(_mm256_xor_si256(_mm256_cmpeq_epi8(v, sp), ones));
+    if (i < 32)
+      return pos + i;
+  }
+  return detail::scalar_scan_kernels().skip_spaces(s, pos, len);
+}
+
+std::size_t avx2_skip_ident(const char *s, std::size_t pos, std::size_t len) {
+  const __m256i lower = _mm256_set1_epi8(0x20);
+  const __m256i under = _mm256_set1_epi8('_');
+  const __m256i ones = _mm256_set1_epi8(-1);
+  for (; pos + 32 <= len; pos += 32) {
+    const __m256i v = load(s, pos);
+    const __m256i alpha = in_range(_mm256_or_si256(v, lower), 'a', 'z');
+    const __m256i digit = in_range(v, '0', '9');
+    const __m256i ident = _mm256_or_si256(_mm256_or_si256(alpha, digit),
+                                          _mm256_cmpeq_epi8(v, under));
+    const unsigned i = first_stop(_mm256_xor_si256(ident, ones));
+    if (i < 32)
+      return pos + i;
+  }
+  return detail::scalar_scan_kernels().skip_ident(s, pos, len);
+}
+
+std::size_t avx2_skip_digits(const char *s, std::size_t pos,
+                             std::size_t len) {
+  const __m256i ones = _mm256_set1_epi8(-1);
+  for (; pos + 32 <= len; pos += 32) {
+    const __m256i v = load(s, pos);
+    const unsigned i = first_stop(_mm256_xor_si256(in_range(v, '0', '9'), ones));
+    if (i < 32)
+      return pos + i;
+  }
+  return detail::scalar_scan_kernels().skip_digits(s, pos, len);
+}
+
+std::size_t avx2_find_quote_or_escape(const char *s, std::size_t pos,
+                                      std::size_t len, char quote) {
+  const __m256i q = _mm256_set1_epi8(quote);
+  const __m256i bs = _mm256_set1_epi8('\\');
+  for (; pos + 32 <= len; pos += 32) {
+    const __m256i v = load(s, pos);
+    const unsigned i = first_stop(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, q), _mm256_cmpeq_epi8(v, bs)));
+    if (i < 32)
+      return pos + i;
+  }
+  return detail::scalar_scan_kernels().find_quote_or_escape(s, pos, len,
+                                                            quote);
+}
+
+const ScanKernels kAvx2 = {avx2_find_newline, avx2_skip_spaces,
+                           avx2_skip_ident,   avx2_skip_digits,
+                           avx2_find_quote_or_escape, "avx2"};
+
+} // namespace
+
+const ScanKernels *cimple::lexer::detail::avx2_scan_kernels() {
+  return &kAvx2;
+}
+
+#else
+
+const cimple::lexer::ScanKernels *
+cimple::lexer::detail::avx2_scan_kernels() {
+  return nullptr;
+}
+
+#endif
@@ -0,0 +1,40 @@
+// symbol_table.cpp - process-wide identifier interner
+#include "frontend/lexer/symbol_table.h"
+#include <iterator>
+
+using namespace cimple::lexer;
+
+SymbolTable &SymbolTable::global() {
+  static SymbolTable table;
+  return table;
+}
+
+SymbolTable::SymbolTable() {
+  // Order must match the `sym` enum.
+  static const char *const predefined[] = {
+      "def",   "return", "if",   "elif", "else", "for",   "while",
+      "in",    "import", "from", "as",   "pass", "break", "continue",
+      "class", "and",    "or",   "not",  "True", "False", "None",
+      "print"};
+  static_assert(std::size(predefined) + 1 == sym::kFirstDynamic,
+                "predefined symbols out of sync with the sym enum");
+  names_.emplace_back(); // kNoSymbol
+  for (const char *name : predefined)
+    intern(name);
+}
+
+SymbolId SymbolTable::intern(std::string_view name) {
+  auto it = ids_.find(name);
+  if (it != ids_.end())
+    return it->second;
+  std::string_view stored = storage_.emplace_back(name);
+  const auto id = static_cast<SymbolId>(names_.size());
+  names_.push_back(stored);
+  ids_.emplace(stored, id);
+  return id;
+}
+
+SymbolId SymbolTable::find(std::string_view name) const {
+  auto it = ids_.find(name);
+  return it == ids_.end() ? kNoSymbol : it->second;
+}
@@ -1,29 +1,64 @@
+// token_stream.cpp - token cursor over a borrowed buffer or a streaming lexer
 #include "frontend/token_stream.h"
 #include "frontend/lexer/lexer.h"
-#include <stdexcept>
+#include <algorithm>
 
 using namespace cimple;
 
+namespace {
+// Returned when the buffer is empty, so peek()/next() always have a token.
+const lexer::Token kEndMarker;
+} // namespace
+
 TokenStream::TokenStream(const std::vector<lexer::Token>& toks)
-    : tokens(toks), idx(0) {}
+    : TokenStream(toks.data(), toks.data() + toks.size()) {}
+
+TokenStream::TokenStream(const lexer::Token* first, const lexer::Token* last)
+    : begin_(first), end_(last), cur_(first) {}
+
+TokenStream::TokenStream(lexer::Lexer& lexer) : lexer_(&lexer) {}
+
+const lexer::Token& TokenStream::ring_peek(size_t lookahead) const {
+    lookahead = std::min(lookahead, kMaxLookahead);
+    // The lexer repeats ENDMARKER once exhausted, so filling never stalls.
+    while (tail_ <= head_ + lookahead) {
+        ring_[tail_ % kRingSize] = lexer_->next();
+        ++tail_;
+    }
+    return ring_[(head_ + lookahead) % kRingSize];
+}
 
 const lexer::Token& TokenStream::peek(size_t lookahead) const {
-    size_t i = idx + lookahead;
-    if (i >= tokens.size()) return tokens.back();
-    return tokens[i];
+    if (lexer_) return ring_peek(lookahead);
+    if (begin_ == end_) return kEndMarker;
+    if (lookahead >= static_cast<size_t>(end_ - cur_)) return end_[-1];
+    return cur_[lookahead];
 }
 
-lexer::Token TokenStream::next() {
-    if (idx >= tokens.size()) return tokens.back();
-    return tokens[idx++];
+const lexer::Token& TokenStream::next() {
+    if (lexer_) {
+        const lexer::Token& t = ring_peek(0);
+        if (t.type != lexer::TokenType::ENDMARKER) ++head_;
+        return t;
+    }
+    if (begin_ == end_) return kEndMarker;
+    if (cur_ == end_) return end_[-1];
+    return *cur_++;
 }
 
 bool TokenStream::eof() const {
-    if (tokens.empty()) return true;
-    return tokens.back().type == lexer::TokenType::ENDMARKER && idx >= tokens.size()-1;
+    if (lexer_) return ring_peek(0).type == lexer::TokenType::ENDMARKER;
+    if (begin_ == end_) return true;
+    return end_[-1].type == lexer::TokenType::ENDMARKER && cur_ >= end_ - 1;
 }
 
 void TokenStream::rewind(size_t count) {
-    if (count > idx) idx = 0; else idx -= count;
+    if (lexer_) {
+        // Only tokens not yet overwritten by lookahead can be revisited.
+        const std::uint64_t oldest =
+            tail_ > kRingSize ? tail_ - kRingSize : 0;
+        head_ = head_ - oldest < count ? oldest : head_ - count;
+        return;
+    }
+    if (count > static_cast<size_t>(cur_ - begin_)) cur_ = begin_; else cur_ -= count;
 }
-// token_stream.cpp - stub
@@ -0,0 +1,275 @@
+// incremental_parser.cpp - reuse unchanged top-level statements across parses
+#include "frontend/parser/incremental_parser.h"
+#include "utils/hash_utils.h"
+#include <cstring>
+
+using namespace cimple;
+using namespace cimple::parser;
+using lexer::TokenKind;
+using lexer::TokenType;
+
+namespace {
+
+bool starts_word(std::string_view line, std::string_view word) {
+  if (line.substr(0, word.size()) != word)
+    return false;
+  if (line.size() == word.size())
+    return true;
+  const char c = line[word.size()];
+  return !(c == '_' || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+           (c >= 'A' && c <= 'Z'));
+}
+
+// Byte offsets of the span starts (see incremental_parser.h), preceded by 0
+// and followed by the source size. The first span, from 0, holds whatever
+// comes before the first boundary and may be empty.
+//
+// The lexer never joins lines, so a line whose first byte begins a token
+// starts at indentation 0 whatever came before it: the lexer's state there
+// is that of a fresh lexer, and a span can be lexed on its own.
+std::vector<std::size_t> span_bounds(std::string_view source) {
+  std::vector<std::size_t> bounds{0};
+  const char *const data = source.data();
+  const std::size_t size = source.size();
+  for (std::size_t line = 0; line < size;) {
+    const char *nl =
+        static_cast<const char *>(std::memchr(data + line, '\n', size - line));
+    const std::size_t next =
+        nl ? static_cast<std::size_t>(nl - data) + 1 : size;
+    const char c = data[line];
+    if (line != 0 && c != ' ' && c != '\t' && c != '\r' && c != '\n' &&
+        c != '#') {
+      const std::string_view text = source.substr(line, next - line);
+      if (!starts_word(text, "elif") && !starts_word(text, "else"))
+        bounds.push_back(line);
+    }
+    line = next;
+  }
+  bounds.push_back(size);
+  return bounds;
+}
+
+// Lex source[begin, next) and the first line of the span at `next`, with
+// offsets relative to the whole source.
+void lex_span(std::string_view source, std::size_t begin, std::size_t next,
+              std::vector<lexer::Token> &tokens) {
+  std::size_t end = source.find('\n', next);
+  end = end == std::string_view::npos ? source.size() : end + 1;
+  lexer::Lexer lexer(source.substr(begin, end - begin));
+  tokens.clear();
+  do {
+    tokens.push_back(lexer.next());
+    tokens.back().offset += static_cast<lexer::SourceOffset>(begin);
+  } while (tokens.back().type != TokenType::ENDMARKER);
+}
+
+// Index of the first token at or past byte `offset` other than the DEDENTs
+// that close the blocks before it.
+std::size_t first_token_at(const std::vector<lexer::Token> &tokens,
+                           std::size_t offset) {
+  std::size_t i = 0;
+  while (tokens[i].type != TokenType::ENDMARKER &&
+         (tokens[i].offset < offset || tokens[i].type == TokenType::DEDENT))
+    ++i;
+  return i;
+}
+
+// Whether Parser::parse_statement consumes `t` when it starts a statement.
+// A block left open at the end of a span (one with no INDENT) would take
+// such a token into its body. A span whose parse stopped just before one
+// therefore closed all its blocks, and parses the same before any span.
+bool starts_statement(const lexer::Token &t) {
+  switch (t.type) {
+  case TokenType::IDENT:
+  case TokenType::NUMBER:
+  case TokenType::STRING:
+    return true;
+  default:
+    break;
+  }
+  switch (t.kind) {
+  case TokenKind::KW_DEF:
+  case TokenKind::KW_IF:
+  case TokenKind::KW_WHILE:
+  case TokenKind::KW_RETURN:
+  case TokenKind::KW_BREAK:
+  case TokenKind::KW_CONTINUE:
+  case TokenKind::KW_NOT:
+  case TokenKind::KW_TRUE:
+  case TokenKind::KW_FALSE:
+  case TokenKind::OP_LPAREN:
+  case TokenKind::OP_MINUS:
+  case TokenKind::OP_TILDE:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Move a reused subtree by `delta` bytes (modulo 2^32, so it may move back).
+void shift(Expr *e, std::uint32_t delta);
+void shift(Stmt *s, std::uint32_t delta);
+
+void shift(const StmtList &body, std::uint32_t delta) {
+  for (Stmt *s : body)
+    if (s)
+      shift(s, delta);
+}
+
+void shift(Expr *e, std::uint32_t delta) {
+  if (!e)
+    return;
+  e->offset += delta;
+  switch (e->kind) {
+  case NodeKind::CallExpr: {
+    auto call = static_cast<CallExpr *>(e);
+    shift(call->callee, delta);
+    for (Expr *arg : call->args)
+      shift(arg, delta);
+    break;
+  }
+  case NodeKind::BinaryOp:
+    shift(static_cast<BinaryOp *>(e)->left, delta);
+    shift(static_cast<BinaryOp *>(e)->right, delta);
+    break;
+  case NodeKind::LogicalExpr:
+    shift(static_cast<LogicalExpr *>(e)->left, delta);
+    shift(static_cast<LogicalExpr *>(e)->right, delta);
+    break;
+  case NodeKind::UnaryOp:
+    shift(static_cast<UnaryOp *>(e)->operand, delta);
+    break;
+  case NodeKind::CompareChain:
+    for (Expr *operand : static_cast<CompareChain *>(e)->operands)
+      shift(operand, delta);
+    break;
+  default: // leaves
+    break;
+  }
+}
+
+void shift(Stmt *s, std::uint32_t delta) {
+  s->offset += delta;
+  switch (s->kind) {
+  case NodeKind::ExprStmt:
+    shift(static_cast<ExprStmt *>(s)->expr, delta);
+    break;
+  case NodeKind::AssignStmt:
+    shift(static_cast<AssignStmt *>(s)->value, delta);
+    break;
+  case NodeKind::ReturnStmt:
+    shift(static_cast<ReturnStmt *>(s)->value, delta);
+    break;
+  case NodeKind::FuncDef:
+    shift(static_cast<FuncDef *>(s)->body, delta);
+    break;
+  case NodeKind::IfStmt:
+    for (IfBranch &branch : static_cast<IfStmt *>(s)->branches) {
+      shift(branch.condition, delta);
+      shift(branch.body, delta);
+    }
+    break;
+  case NodeKind::WhileStmt:
+    shift(static_cast<WhileStmt *>(s)->condition, delta);
+    shift(static_cast<WhileStmt *>(s)->body, delta);
+    break;
+  default: // break, continue
+    break;
+  }
+}
+
+} // namespace
+
+const Module &IncrementalParser::parse(std::string_view source) {
+  const std::vector<std::size_t> bounds = span_bounds(source);
+  const std::size_t spans = bounds.size() - 1;
+
+  auto arena = std::make_shared<Arena>(); // this parse's new nodes
+  decltype(spans_) kept;
+  kept.reserve(spans);
+  std::vector<Stmt *> body;
+  std::vector<lexer::Token> tokens;
+  std::size_t reparsed = 0;
+
+  for (std::size_t i = 0; i < spans;) {
+    const std::size_t begin = bounds[i];
+    const std::string_view text = source.substr(begin, bounds[i + 1] - begin);
+    const std::uint64_t hash = utils::hash_string(text);
+
+    auto old = spans_.end();
+    for (auto [it, last] = spans_.equal_range(hash); it != last; ++it)
+      if (it->second.size == text.size()) {
+        old = it;
+        break;
+      }
+    if (old != spans_.end()) {
+      // Move the entry itself, so reuse allocates nothing.
+      auto entry = spans_.extract(old);
+      Span &span = entry.mapped();
+      const auto offset = static_cast<lexer::SourceOffset>(begin);
+      if (offset != span.begin)
+        shift(span.stmts, offset - span.begin);
+      span.begin = offset;
+      body.insert(body.end(), span.stmts.begin(), span.stmts.end());
+      kept.insert(std::move(entry));
+      ++i;
+      continue;
+    }
+
+    // Parse the span, through the first token of the next one. If its
+    // statements run into the next span, parse the two as one, and so on.
+    const std::size_t first = body.size();
+    std::size_t j = i + 1;
+    std::size_t end = 0; // index of the next span's first token
+    bool stopped = false;
+    bool clean = false;
+    for (;; ++j) {
+      lex_span(source, begin, bounds[j], tokens);
+      end = first_token_at(tokens, bounds[j]);
+      Parser p(tokens);
+      p.arena_ = arena.get();
+      body.resize(first);
+      stopped = false;
+      while (p.skip_to_module_statement() && p.ts.position() < end) {
+        Stmt *s = p.parse_statement();
+        if (!s) {
+          stopped = true;
+          break;
+        }
+        body.push_back(s);
+      }
+      if (p.ts.position() <= end || j == spans) {
+        clean = !stopped && p.error_count() == 0 && p.ts.position() == end;
+        break;
+      }
+    }
+    reparsed += j - i;
+
+    // Parser::parse_module stops at a statement it cannot parse.
+    if (stopped)
+      break;
+    // Keep the span if its statements end where it does, and nothing in it
+    // (a block with no INDENT, say) would have taken more statements had
+    // the next span started differently. See starts_statement().
+    if (clean && j == i + 1 && starts_statement(tokens[end])) {
+      Span span;
+      span.size = text.size();
+      span.begin = static_cast<lexer::SourceOffset>(begin);
+      const std::size_t n = body.size() - first;
+      span.stmts = StmtList(arena->copy_array(body.data() + first, n), n);
+      span.arena = arena;
+      kept.emplace(hash, std::move(span));
+    }
+    i = j;
+  }
+
+  // Spans not reused are dropped, and with them any arena no span needs.
+  spans_ = std::move(kept);
+  latest_ = std::move(arena);
+  stats_.spans = spans;
+  stats_.reparsed = reparsed;
+
+  module_ = Module();
+  module_.body = StmtList(module_.arena, body);
+  return module_;
+}
@@ -3,34 +3,205 @@
 // See docs/PEG_GRAMMAR_PLAN.md for implementation plan
 #include "frontend/parser/parser.h"
 #include "frontend/lexer/token_utils.h"
+#include <charconv>
 #include <iostream>
+#include <sstream>
+#include <thread>
 
 using namespace cimple;
 using namespace cimple::parser;
+using lexer::TokenKind;
 
-Parser::Parser(const std::vector<lexer::Token> &tokens) : ts(tokens) {}
+NumberLiteral::NumberLiteral(std::string_view v) : Expr(kKind), value(v) {
+  const char *first = value.data();
+  const char *last = first + value.size();
+  std::from_chars_result res;
+  if (value.find('.') != std::string_view::npos) {
+    num_kind = Float;
+    res = std::from_chars(first, last, float_value);
+  } else {
+    res = std::from_chars(first, last, int_value);
+  }
+  in_range = res.ec == std::errc() && res.ptr == last;
+}
+
+Parser::Parser(const std::vector<lexer::Token> &tokens)
+    : ts(tokens), tokens_(&tokens), diag_(&std::cerr) {}
+
+Parser::Parser(lexer::Lexer &lexer) : ts(lexer), diag_(&std::cerr) {}
+
+Parser::Parser(const lexer::Token *first, const lexer::Token *last,
+               std::ostream &diag)
+    : ts(first, last), diag_(&diag) {}
 
 Module Parser::parse_module() {
+  if (tokens_ && ts.position() == 0 &&
+      tokens_->size() >= kParallelParseMinTokens) {
+    const unsigned threads = std::thread::hardware_concurrency();
+    if (threads > 1)
+      return parse_module_parallel(threads);
+  }
+
   Module m;
+  arena_ = &m.arena;
+  const size_t mark = stmt_stack_.size();
+  while (skip_to_module_statement()) {
+    auto s = parse_statement();
+    if (s)
+      stmt_stack_.push_back(s);
+    else
+      break; // genuinely unrecognized token — stop parsing
+  }
+  m.body = pop_list(stmt_stack_, mark);
+  arena_ = nullptr;
+  return m;
+}
+
+bool Parser::skip_to_module_statement() {
   while (!ts.eof()) {
-    auto t = ts.peek();
+    const auto &t = ts.peek();
     // Stop at end of file
     if (t.type == lexer::TokenType::ENDMARKER)
-      break;
+      return false;
     // Skip blank lines, indentation tokens, and comments at module level
-    if (t.type == lexer::TokenType::NEWLINE ||
-        t.type == lexer::TokenType::INDENT ||
-        t.type == lexer::TokenType::DEDENT ||
-        t.type == lexer::TokenType::COMMENT) {
-      ts.next();
-      continue;
+    if (t.type != lexer::TokenType::NEWLINE &&
+        t.type != lexer::TokenType::INDENT &&
+        t.type != lexer::TokenType::DEDENT &&
+        t.type != lexer::TokenType::COMMENT)
+      return true;
+    ts.next();
+  }
+  return false;
+}
+
+// ---------------------------------------------------------------------------
+// Parallel parsing
+//
+// A top-level statement that starts a line at indentation 0 is parsed the
+// same wherever the parse starts, as long as the parser is at module level
+// there. One linear pass over the tokens picks such statements as cut
+// points, about every tokens/threads tokens, and each run between two cuts
+// is parsed on its own thread into its own arena. The runs are stitched
+// back in source order. A cut only has to be checked: if the statement
+// before it ran past it (a header whose block has no INDENT swallows the
+// statements after it), the stitch reparses from where that statement
+// ended, as parse_module would.
+// ---------------------------------------------------------------------------
+
+struct Parser::Chunk {
+  const lexer::Token *first = nullptr; // the chunk's first token
+  const lexer::Token *last = nullptr;  // end of the whole token buffer
+  std::size_t begin = 0;               // token indices [begin, end)
+  std::size_t end = 0;
+  std::size_t reached = 0; // index at which its parse stopped
+  bool stopped = false;    // at a statement it could not parse
+  std::size_t errors = 0;
+  Arena arena;
+  std::vector<Stmt *> stmts;
+  std::ostringstream diag; // errors, reported when the chunk is stitched
+};
+
+void Parser::parse_chunk(Chunk *chunk) {
+  Parser p(chunk->first, chunk->last, chunk->diag);
+  p.arena_ = &chunk->arena;
+  const std::size_t length = chunk->end - chunk->begin;
+  while (p.skip_to_module_statement() && p.ts.position() < length) {
+    Stmt *s = p.parse_statement();
+    if (!s) {
+      chunk->stopped = true;
+      break;
     }
-    auto s = parse_statement();
-    if (s)
-      m.body.push_back(std::move(s));
-    else
-      break; // genuinely unrecognized token — stop parsing
+    chunk->stmts.push_back(s);
+  }
+  chunk->reached = chunk->begin + p.ts.position();
+  chunk->errors = p.errors_;
+}
+
+Module Parser::parse_module_parallel(unsigned threads) {
+  assert(tokens_ && "parse_module_parallel needs a buffered token input");
+  const std::vector<lexer::Token> &tokens = *tokens_;
+  const std::size_t n = tokens.size();
+
+  // Cut points: the first top-level statement past each multiple of n /
+  // threads tokens.
+  std::vector<std::size_t> cuts = {0};
+  const std::size_t target = n / (threads ? threads : 1) + 1;
+  int depth = 0;
+  bool line_start = true;
+  for (std::size_t i = 0; i < n && cuts.size() < threads; ++i) {
+    const lexer::Token &t = tokens[i];
+    if (t.type == lexer::TokenType::ENDMARKER)
+      break;
+    switch (t.type) {
+    case lexer::TokenType::INDENT:
+      ++depth;
+      break;
+    case lexer::TokenType::DEDENT:
+      --depth;
+      break;
+    case lexer::TokenType::NEWLINE:
+      line_start = true;
+      break;
+    case lexer::TokenType::COMMENT:
+      break;
+    default:
+      if (line_start && depth == 0 && i >= cuts.back() + target &&
+          t.kind != TokenKind::KW_ELIF && t.kind != TokenKind::KW_ELSE)
+        cuts.push_back(i);
+      line_start = false;
+    }
+  }
+
+  std::vector<Chunk> chunks(cuts.size());
+  for (std::size_t c = 0; c < chunks.size(); ++c) {
+    chunks[c].first = tokens.data() + cuts[c];
+    chunks[c].last = tokens.data() + n;
+    chunks[c].begin = cuts[c];
+    chunks[c].end = c + 1 < cuts.size() ? cuts[c + 1] : n;
   }
+
+  std::vector<std::thread> workers;
+  for (std::size_t c = 1; c < chunks.size(); ++c)
+    workers.emplace_back(&Parser::parse_chunk, &chunks[c]);
+  parse_chunk(&chunks[0]);
+  for (auto &w : workers)
+    w.join();
+
+  Module m;
+  std::vector<Stmt *> body;
+  std::size_t pos = 0; // where the sequential parse would be
+  for (Chunk &chunk : chunks) {
+    if (pos >= chunk.end)
+      continue; // swallowed by a statement that started before it
+    bool stopped;
+    if (pos == chunk.begin) {
+      body.insert(body.end(), chunk.stmts.begin(), chunk.stmts.end());
+      m.arena.adopt(std::move(chunk.arena));
+      *diag_ << chunk.diag.str();
+      errors_ += chunk.errors;
+      pos = chunk.reached;
+      stopped = chunk.stopped;
+    } else {
+      // The statement before the cut ran past it: parse on from its end.
+      Parser p(tokens.data() + pos, tokens.data() + n, *diag_);
+      p.arena_ = &m.arena;
+      stopped = false;
+      while (p.skip_to_module_statement() &&
+             pos + p.ts.position() < chunk.end) {
+        Stmt *s = p.parse_statement();
+        if (!s) {
+          stopped = true;
+          break;
+        }
+        body.push_back(s);
+      }
+      pos += p.ts.position();
+      errors_ += p.errors_;
+    }
+    if (stopped)
+      break; // as parse_module does
+  }
+  m.body = StmtList(m.arena, body);
   return m;
 }
 
@@ -38,41 +209,42 @@ Module Parser::parse_module() {
 // Statements
 // ---------------------------------------------------------------------------
 
-std::unique_ptr<Stmt> Parser::parse_statement() {
-  auto t = ts.peek();
-  if (t.type == lexer::TokenType::KEYWORD && t.lexeme == "def") {
+// IncrementalParser reuses spans based on which tokens start a statement;
+// a token that begins a new kind of statement here must also be listed in
+// starts_statement() (incremental_parser.cpp).
+Stmt *Parser::parse_statement() {
+  const lexer::SourceOffset pos = ts.peek().offset;
+  switch (ts.peek().kind) {
+  case TokenKind::KW_DEF:
     return parse_funcdef();
-  }
-  if (t.type == lexer::TokenType::KEYWORD && t.lexeme == "if") {
+  case TokenKind::KW_IF:
     return parse_if();
-  }
-  if (t.type == lexer::TokenType::KEYWORD && t.lexeme == "while") {
+  case TokenKind::KW_WHILE:
     return parse_while();
-  }
-  if (t.type == lexer::TokenType::KEYWORD && t.lexeme == "break") {
+  case TokenKind::KW_BREAK:
     ts.next(); // consume 'break'
     if (ts.peek().type == lexer::TokenType::NEWLINE)
       ts.next();
-    return std::make_unique<BreakStmt>();
-  }
-  if (t.type == lexer::TokenType::KEYWORD && t.lexeme == "continue") {
+    return make<BreakStmt>(pos);
+  case TokenKind::KW_CONTINUE:
     ts.next(); // consume 'continue'
     if (ts.peek().type == lexer::TokenType::NEWLINE)
       ts.next();
-    return std::make_unique<ContinueStmt>();
-  }
-  if (t.type == lexer::TokenType::KEYWORD && t.lexeme == "return") {
+    return make<ContinueStmt>(pos);
+  case TokenKind::KW_RETURN: {
     ts.next();
     auto val = parse_expression();
     if (ts.peek().type == lexer::TokenType::NEWLINE)
       ts.next();
-    return std::make_unique<ReturnStmt>(std::move(val));
+    return make<ReturnStmt>(pos, val);
+  }
+  default:
+    return parse_simple_statement();
   }
-  return parse_simple_statement();
 }
 
 // Parse an indented block: NEWLINE INDENT stmt* DEDENT
-std::vector<std::unique_ptr<Stmt>> Parser::parse_block() {
+StmtList Parser::parse_block() {
   // Skip any trailing content on the header line up to NEWLINE
   while (!ts.eof() && ts.peek().type != lexer::TokenType::NEWLINE &&
          ts.peek().type != lexer::TokenType::INDENT)
@@ -82,103 +254,104 @@ std::vector<std::unique_ptr<Stmt>> Parser::parse_block() {
   if (ts.peek().type == lexer::TokenType::INDENT)
     ts.next();
 
-  std::vector<std::unique_ptr<Stmt>> body;
+  const size_t mark = stmt_stack_.size();
   while (!ts.eof() && ts.peek().type != lexer::TokenType::DEDENT) {
     auto stmt = parse_statement();
     if (stmt)
-      body.push_back(std::move(stmt));
+      stmt_stack_.push_back(stmt);
     else
       break;
   }
   if (ts.peek().type == lexer::TokenType::DEDENT)
     ts.next();
-  return body;
+  return pop_list(stmt_stack_, mark);
 }
 
-std::unique_ptr<FuncDef> Parser::parse_funcdef() {
-  ts.next(); // def
-  auto nameTok = ts.next();
+FuncDef *Parser::parse_funcdef() {
+  const lexer::SourceOffset pos = ts.next().offset; // def
+  const auto &nameTok = ts.next();
   if (nameTok.type != lexer::TokenType::IDENT) {
-    std::cerr << "Parser error: expected function name" << std::endl;
+    *diag_ << "Parser error: expected function name" << std::endl;
+    ++errors_;
     return nullptr;
   }
-  std::string name = nameTok.lexeme;
+  // Copy what we need: the token may be recycled while the parameters are
+  // parsed (see TokenStream).
+  const lexer::SymbolId name_id = nameTok.sym;
 
-  if (ts.peek().type == lexer::TokenType::OP && ts.peek().lexeme == "(")
-    ts.next();
-  std::vector<std::string> params;
-  while (!ts.eof() &&
-         !(ts.peek().type == lexer::TokenType::OP && ts.peek().lexeme == ")")) {
-    auto tok = ts.next();
-    if (tok.type == lexer::TokenType::IDENT)
-      params.push_back(tok.lexeme);
-    if (ts.peek().type == lexer::TokenType::OP && ts.peek().lexeme == ",")
-      ts.next();
+  accept(TokenKind::OP_LPAREN);
+  std::vector<std::string_view> params;
+  std::vector<lexer::SymbolId> param_ids;
+  while (!ts.eof() && !at(TokenKind::OP_RPAREN)) {
+    const auto &tok = ts.next();
+    if (tok.type == lexer::TokenType::IDENT) {
+      // The symbol table's copy: the tree must not borrow the source.
+      params.emplace_back(lexer::symbol_name(tok.sym));
+      param_ids.push_back(tok.sym);
+    }
+    accept(TokenKind::OP_COMMA);
   }
-  if (ts.peek().type == lexer::TokenType::OP && ts.peek().lexeme == ")")
-    ts.next();
+  accept(TokenKind::OP_RPAREN);
 
-  auto fn = std::make_unique<FuncDef>();
-  fn->name = name;
-  fn->params = std::move(params);
+  auto fn = make<FuncDef>(pos);
+  fn->name = lexer::symbol_name(name_id);
+  fn->name_id = name_id;
+  fn->params = ArenaSpan<std::string_view>(*arena_, params);
+  fn->param_ids = ArenaSpan<lexer::SymbolId>(*arena_, param_ids);
   fn->body = parse_block();
   return fn;
 }
 
 // if <cond>: BLOCK [elif <cond>: BLOCK]* [else: BLOCK]
-std::unique_ptr<IfStmt> Parser::parse_if() {
-  auto stmt = std::make_unique<IfStmt>();
+IfStmt *Parser::parse_if() {
+  auto stmt = make<IfStmt>(ts.peek().offset);
+  std::vector<IfBranch> branches;
 
   // Parse the 'if' branch
   ts.next(); // consume 'if'
   IfBranch ifBranch;
   ifBranch.condition = parse_expression();
   // consume ':' if present
-  if (ts.peek().type == lexer::TokenType::OP && ts.peek().lexeme == ":")
-    ts.next();
+  accept(TokenKind::OP_COLON);
   ifBranch.body = parse_block();
-  stmt->branches.push_back(std::move(ifBranch));
+  branches.push_back(ifBranch);
 
   // Parse 'elif' branches
-  while (!ts.eof() && ts.peek().type == lexer::TokenType::KEYWORD &&
-         ts.peek().lexeme == "elif") {
+  while (!ts.eof() && ts.peek().kind == TokenKind::KW_ELIF) {
     ts.next(); // consume 'elif'
     IfBranch elifBranch;
     elifBranch.condition = parse_expression();
-    if (ts.peek().type == lexer::TokenType::OP && ts.peek().lexeme == ":")
-      ts.next();
+    accept(TokenKind::OP_COLON);
     elifBranch.body = parse_block();
-    stmt->branches.push_back(std::move(elifBranch));
+    branches.push_back(elifBranch);
   }
 
   // Parse optional 'else' branch
-  if (!ts.eof() && ts.peek().type == lexer::TokenType::KEYWORD &&
-      ts.peek().lexeme == "else") {
+  if (!ts.eof() && ts.peek().kind == TokenKind::KW_ELSE) {
     ts.next(); // consume 'else'
-    if (ts.peek().type == lexer::TokenType::OP && ts.peek().lexeme == ":")
-      ts.next();
+    accept(TokenKind::OP_COLON);
     IfBranch elseBranch;
     elseBranch.condition = nullptr; // else has no condition
     elseBranch.body = parse_block();
-    stmt->branches.push_back(std::move(elseBranch));
+    branches.push_back(elseBranch);
   }
 
+  stmt->branches = ArenaSpan<IfBranch>(*arena_, branches);
   return stmt;
 }
 
 // while <cond>: BLOCK
-std::unique_ptr<WhileStmt> Parser::parse_while() {
-  ts.next(); // consume 'while'
-  auto stmt = std::make_unique<WhileStmt>();
+WhileStmt *Parser::parse_while() {
+  auto stmt = make<WhileStmt>(ts.next().offset); // consume 'while'
+
   stmt->condition = parse_expression();
-  if (ts.peek().type == lexer::TokenType::OP && ts.peek().lexeme == ":")
-    ts.next();
+  accept(TokenKind::OP_COLON);
   stmt->body = parse_block();
   return stmt;
 }
 
-std::unique_ptr<Stmt> Parser::parse_simple_statement() {
-  auto t = ts.peek();
+Stmt *Parser::parse_simple_statement() {
+  const auto &t = ts.peek();
   if (t.type == lexer::TokenType::NEWLINE) {
     ts.next();
     return nullptr;
@@ -198,181 +371,158 @@ std::unique_ptr<Stmt> Parser::parse_simple_statement() {
     return nullptr;
   }
 
+  const lexer::SourceOffset start = t.offset;
   auto expr = parse_expression();
   if (!expr)
     return nullptr;
-  if (ts.peek().type == lexer::TokenType::OP && ts.peek().lexeme == "=") {
-    if (auto var = dynamic_cast<VarRef *>(expr.get())) {
+  if (at(TokenKind::OP_ASSIGN)) {
+    if (auto var = dyn_cast<VarRef>(expr)) {
       ts.next(); // consume '='
       auto val = parse_expression();
       if (ts.peek().type == lexer::TokenType::NEWLINE)
         ts.next();
-      return std::make_unique<AssignStmt>(var->name, std::move(val));
+      return make<AssignStmt>(start, var->id, val);
     }
   }
   if (ts.peek().type == lexer::TokenType::NEWLINE)
     ts.next();
-  return std::make_unique<ExprStmt>(std::move(expr));
+  return make<ExprStmt>(start, expr);
 }
 
 // ---------------------------------------------------------------------------
-// Expression grammar (low → high precedence):
-//   logical_or  → logical_and ('or' logical_and)*
-//   logical_and → comparison  ('and' comparison)*
-//   comparison  → additive    (( == | != | < | > | <= | >= ) additive)*
-//   additive    → term        (( '+' | '-' ) term)*
-//   term        → unary       (( '*' | '/' ) unary)*
-//   unary       → 'not' comparison | '-' unary | factor
-//   factor      → NUMBER | STRING | 'True' | 'False' | IDENT ['(' args ')'] |
-//   '(' expr ')'
+// Expressions: precedence climbing over kBinaryOperators (operators.h).
+//
+//   expression(min) → prefix (binop expression(next))*   for binop prec >= min
+//   prefix          → 'not' expression(comparison) | '-' expression(unary) |
+//                     '~' expression(unary) | factor
+//   factor          → NUMBER | STRING | 'True' | 'False' |
+//                     IDENT ['(' args ')'] | '(' expr ')'
+//
+// A left-associative operator parses its right operand one level tighter,
+// a right-associative one (`**`) at its own level. Comparisons chain:
+// `a < b <= c` collects every operand into one CompareChain, so each level
+// costs one loop iteration rather than a call frame.
 // ---------------------------------------------------------------------------
 
-// Entry point: routes through the full precedence chain.
-std::unique_ptr<Expr> Parser::parse_expression() { return parse_logical_or(); }
-
-// logical_or: lowest precedence among operators.
-// Short-circuit: if left is truthy, right is NOT evaluated.
-std::unique_ptr<Expr> Parser::parse_logical_or() {
-  auto left = parse_logical_and();
-  while (ts.peek().type == lexer::TokenType::KEYWORD &&
-         ts.peek().lexeme == "or") {
-    ts.next(); // consume 'or'
-    auto right = parse_logical_and();
-    left =
-        std::make_unique<LogicalExpr>("or", std::move(left), std::move(right));
-  }
-  return left;
-}
+Expr *Parser::parse_expression(Precedence min_prec) {
+  Expr *left = parse_prefix();
+  for (;;) {
+    const BinaryOperatorInfo *op = find_binary_operator(ts.peek().kind);
+    if (!op || op->precedence < min_prec)
+      return left;
+    const lexer::SourceOffset pos = ts.next().offset;
 
-// logical_and: binds tighter than 'or', looser than comparisons.
-// Short-circuit: if left is falsy, right is NOT evaluated.
-std::unique_ptr<Expr> Parser::parse_logical_and() {
-  auto left = parse_comparison();
-  while (ts.peek().type == lexer::TokenType::KEYWORD &&
-         ts.peek().lexeme == "and") {
-    ts.next(); // consume 'and'
-    auto right = parse_comparison();
-    left =
-        std::make_unique<LogicalExpr>("and", std::move(left), std::move(right));
-  }
-  return left;
-}
+    if (op->precedence == kPrecComparison) {
+      left = parse_comparison_chain(left, op->op, pos);
+      continue;
+    }
 
-std::unique_ptr<Expr> Parser::parse_comparison() {
-  auto left = parse_additive();
-  static const std::vector<std::string> cmp_ops = {"==", "!=", "<",
-                                                   ">",  "<=", ">="};
-  while (ts.peek().type == lexer::TokenType::OP) {
-    const std::string &op = ts.peek().lexeme;
-    bool is_cmp = false;
-    for (auto &c : cmp_ops)
-      if (c == op) {
-        is_cmp = true;
-        break;
-      }
-    if (!is_cmp)
-      break;
-    ts.next();
-    auto right = parse_additive();
-    left = std::make_unique<BinaryOp>(op, std::move(left), std::move(right));
+    const auto next_prec = static_cast<Precedence>(
+        op->assoc == Assoc::Left ? op->precedence + 1 : op->precedence);
+    Expr *right = parse_expression(next_prec);
+    // and/or short-circuit, so they get their own node.
+    if (is_logical(op->op))
+      left = make<LogicalExpr>(pos, op->op, left, right);
+    else
+      left = make<BinaryOp>(pos, op->op, left, right);
   }
-  return left;
 }
 
-std::unique_ptr<Expr> Parser::parse_additive() {
-  auto left = parse_term();
-  while (ts.peek().type == lexer::TokenType::OP &&
-         (ts.peek().lexeme == "+" || ts.peek().lexeme == "-")) {
-    std::string op = ts.next().lexeme;
-    auto right = parse_term();
-    left = std::make_unique<BinaryOp>(op, std::move(left), std::move(right));
-  }
-  return left;
-}
+// `first op operand (op operand)*` with the first operator, at offset `pos`,
+// consumed. A single comparison stays a BinaryOp.
+Expr *Parser::parse_comparison_chain(Expr *first, BinOpKind op,
+                                     lexer::SourceOffset pos) {
+  const auto operand_prec = static_cast<Precedence>(kPrecComparison + 1);
+  Expr *second = parse_expression(operand_prec);
+  const BinaryOperatorInfo *next = binary_operator_at(kPrecComparison);
+  if (!next)
+    return make<BinaryOp>(pos, op, first, second);
 
-std::unique_ptr<Expr> Parser::parse_term() {
-  auto left = parse_unary();
-  while (ts.peek().type == lexer::TokenType::OP &&
-         (ts.peek().lexeme == "*" || ts.peek().lexeme == "/")) {
-    std::string op = ts.next().lexeme;
-    auto right = parse_unary();
-    left = std::make_unique<BinaryOp>(op, std::move(left), std::move(right));
-  }
-  return left;
+  const std::size_t mark = expr_stack_.size();
+  std::vector<BinOpKind> ops{op};
+  expr_stack_.push_back(first);
+  expr_stack_.push_back(second);
+  do {
+    ts.next();
+    ops.push_back(next->op);
+    expr_stack_.push_back(parse_expression(operand_prec));
+  } while ((next = binary_operator_at(kPrecComparison)));
+
+  auto chain = make<CompareChain>(pos);
+  chain->operands = pop_list(expr_stack_, mark);
+  chain->ops = ArenaSpan<BinOpKind>(*arena_, ops);
+  return chain;
 }
 
-std::unique_ptr<Expr> Parser::parse_unary() {
-  auto t = ts.peek();
-  // 'not' has lower precedence than comparisons: not (x < y)
-  if (t.type == lexer::TokenType::KEYWORD && t.lexeme == "not") {
+Expr *Parser::parse_prefix() {
+  const lexer::SourceOffset pos = ts.peek().offset;
+  switch (ts.peek().kind) {
+  case TokenKind::KW_NOT:
+    // 'not' binds looser than comparisons: not (x < y)
     ts.next();
-    auto operand = parse_comparison(); // not binds looser than comparisons
-    return std::make_unique<UnaryOp>("not", std::move(operand));
-  }
-  // unary minus recurses into itself for chaining: --x
-  if (t.type == lexer::TokenType::OP && t.lexeme == "-") {
+    return make<UnaryOp>(pos, UnOpKind::Not, parse_expression(kPrecComparison));
+  case TokenKind::OP_MINUS:
     ts.next();
-    auto operand = parse_unary();
-    return std::make_unique<UnaryOp>("-", std::move(operand));
+    return make<UnaryOp>(pos, UnOpKind::Neg, parse_expression(kPrecUnary));
+  case TokenKind::OP_TILDE:
+    ts.next();
+    return make<UnaryOp>(pos, UnOpKind::BitNot, parse_expression(kPrecUnary));
+  default:
+    return parse_factor();
   }
-  return parse_factor();
 }
 
-std::unique_ptr<Expr> Parser::parse_factor() {
-  auto t = ts.peek();
+Expr *Parser::parse_factor() {
+  const auto &t = ts.peek();
+  const lexer::SourceOffset pos = t.offset;
   if (t.type == lexer::TokenType::NUMBER) {
     ts.next();
-    return std::make_unique<NumberLiteral>(t.lexeme);
+    return make<NumberLiteral>(pos, arena_->copy_string(t.lexeme()));
   }
   if (t.type == lexer::TokenType::STRING) {
     ts.next();
-    return std::make_unique<StringLiteral>(t.lexeme);
+    return make<StringLiteral>(pos, arena_->copy_string(t.lexeme()));
   }
   // Boolean literals
-  if (t.type == lexer::TokenType::KEYWORD && t.lexeme == "True") {
+  if (t.kind == TokenKind::KW_TRUE) {
     ts.next();
-    return std::make_unique<BoolLiteral>(true);
+    return make<BoolLiteral>(pos, true);
   }
-  if (t.type == lexer::TokenType::KEYWORD && t.lexeme == "False") {
+  if (t.kind == TokenKind::KW_FALSE) {
     ts.next();
-    return std::make_unique<BoolLiteral>(false);
+    return make<BoolLiteral>(pos, false);
   }
   if (t.type == lexer::TokenType::IDENT) {
     ts.next();
-    if (ts.peek().type == lexer::TokenType::OP && ts.peek().lexeme == "(") {
+    if (at(TokenKind::OP_LPAREN)) {
       ts.next();
-      auto call = std::make_unique<CallExpr>();
-      call->callee = std::make_unique<VarRef>(t.lexeme);
+      auto call = make<CallExpr>(pos);
+      call->callee = make<VarRef>(pos, t.sym);
       call->args = parse_arglist();
-      if (ts.peek().type == lexer::TokenType::OP && ts.peek().lexeme == ")")
-        ts.next();
+      accept(TokenKind::OP_RPAREN);
       return call;
     }
-    return std::make_unique<VarRef>(t.lexeme);
+    return make<VarRef>(pos, t.sym);
   }
-  if (t.type == lexer::TokenType::OP && t.lexeme == "(") {
+  if (t.kind == TokenKind::OP_LPAREN) {
     ts.next();
     auto e = parse_expression();
-    if (ts.peek().type == lexer::TokenType::OP && ts.peek().lexeme == ")")
-      ts.next();
+    accept(TokenKind::OP_RPAREN);
     return e;
   }
   // Unknown token — do NOT consume it, return nullptr so callers can handle it
   return nullptr;
 }
 
-std::vector<std::unique_ptr<Expr>> Parser::parse_arglist() {
-  std::vector<std::unique_ptr<Expr>> args;
-  while (!ts.eof() &&
-         !(ts.peek().type == lexer::TokenType::OP && ts.peek().lexeme == ")")) {
-    if (ts.peek().type == lexer::TokenType::OP && ts.peek().lexeme == ",") {
-      ts.next();
+ExprList Parser::parse_arglist() {
+  const size_t mark = expr_stack_.size();
+  while (!ts.eof() && !at(TokenKind::OP_RPAREN)) {
+    if (accept(TokenKind::OP_COMMA))
       continue;
-    }
     auto arg = parse_expression();
     if (!arg)
       break; // safety: unknown token in arg list
-    args.push_back(std::move(arg));
+    expr_stack_.push_back(arg);
   }
-  return args;
+  return pop_list(expr_stack_, mark);
 }
@@ -0,0 +1,177 @@
+// resolver.cpp - bind variables to frame slots ahead of execution
+#include "frontend/semantic/resolver.h"
+#include "frontend/ast/ast_visitor.h"
+#include <unordered_set>
+
+using namespace cimple;
+using namespace cimple::semantic;
+
+namespace {
+
+using parser::StmtList;
+
+// Names assigned by statements directly in `body` (not in nested blocks),
+// in order of first assignment.
+std::vector<lexer::SymbolId> direct_assignments(const StmtList &body) {
+  std::vector<lexer::SymbolId> names;
+  std::unordered_set<lexer::SymbolId> seen;
+  for (const auto &stmt : body) {
+    if (auto as = parser::dyn_cast<parser::AssignStmt>(stmt)) {
+      if (seen.insert(as->target_id).second)
+        names.push_back(as->target_id);
+    }
+  }
+  return names;
+}
+
+class FrameResolver : public ast::RecursiveVisitor<FrameResolver> {
+public:
+  FrameResolver(Resolution &out, FrameLayout &layout,
+                const std::unordered_map<lexer::SymbolId, std::uint32_t> *globals)
+      : out_(out), layout_(layout), globals_(globals) {}
+
+  // Function frame: parameters first, then the names its body assigns.
+  void resolve_function(const parser::FuncDef *fn) {
+    std::vector<lexer::SymbolId> names(fn->param_ids.begin(),
+                                       fn->param_ids.end());
+    std::unordered_set<lexer::SymbolId> seen(names.begin(), names.end());
+    for (auto &n : direct_assignments(fn->body))
+      if (seen.insert(n).second)
+        names.push_back(n);
+
+    layout_.num_params = static_cast<std::uint32_t>(fn->params.size());
+    open_scope(names);
+    layout_.scope_slots = next_slot_;
+    if (globals_) {
+      for (const auto &n : names) {
+        auto g = globals_->find(n);
+        if (g != globals_->end())
+          layout_.inherit_globals.emplace_back(scopes_.back()[n], g->second);
+      }
+    }
+    walk(fn->body);
+  }
+
+  // Module frame: its function-scope slots are the globals.
+  void resolve_module(const parser::Module &module,
+                      const std::vector<lexer::SymbolId> &globals) {
+    open_scope(globals);
+    layout_.scope_slots = next_slot_;
+    for (const auto &stmt : module.body) {
+      if (parser::isa<parser::FuncDef>(stmt))
+        continue;
+      walk(stmt);
+    }
+  }
+
+private:
+  using Scope = std::unordered_map<lexer::SymbolId, std::uint32_t>;
+
+  Resolution &out_;
+  FrameLayout &layout_;
+  const std::unordered_map<lexer::SymbolId, std::uint32_t> *globals_;
+  std::vector<Scope> scopes_;
+  std::uint32_t next_slot_ = 0;
+
+  void open_scope(const std::vector<lexer::SymbolId> &names) {
+    Scope scope;
+    for (lexer::SymbolId n : names) {
+      // Sibling blocks reuse slots; the listing keeps the first name.
+      if (layout_.slot_names.size() <= next_slot_)
+        layout_.slot_names.emplace_back(lexer::symbol_name(n));
+      scope[n] = next_slot_++;
+    }
+    if (next_slot_ > layout_.num_slots)
+      layout_.num_slots = next_slot_;
+    scopes_.push_back(std::move(scope));
+  }
+
+  VarBinding lookup(lexer::SymbolId name) const {
+    for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
+      auto found = it->find(name);
+      if (found != it->end())
+        return {VarBinding::Local, found->second};
+    }
+    if (globals_) {
+      auto g = globals_->find(name);
+      if (g != globals_->end())
+        return {VarBinding::Global, g->second};
+    }
+    return {};
+  }
+
+  // Enter a block scope owning the names `body` assigns directly; each new
+  // slot is seeded from the binding its name has just outside the block.
+  void resolve_block(const StmtList &body, const parser::Expr *loop_cond) {
+    std::vector<lexer::SymbolId> names = direct_assignments(body);
+    BlockLayout layout;
+    for (const auto &n : names)
+      layout.init.emplace_back(0, lookup(n));
+
+    const std::uint32_t mark = next_slot_;
+    open_scope(names);
+    for (std::size_t i = 0; i < names.size(); ++i)
+      layout.init[i].first = scopes_.back()[names[i]];
+    out_.blocks[&body] = std::move(layout);
+
+    // A while condition is evaluated inside the loop's scope.
+    walk(loop_cond);
+    walk(body);
+
+    scopes_.pop_back();
+    next_slot_ = mark;
+  }
+
+public:
+  // Visitor hooks; every other node just has its children walked.
+  void visit_var(const parser::VarRef *v) { out_.vars[v] = lookup(v->id); }
+  void visit_call(const parser::CallExpr *c) {
+    // The callee names a function, not a variable.
+    for (const auto &arg : c->args)
+      walk(arg);
+  }
+
+  void visit_assign(const parser::AssignStmt *as) {
+    walk(as->value);
+    out_.vars[as] = lookup(as->target_id);
+  }
+  void visit_if(const parser::IfStmt *is) {
+    for (const auto &branch : is->branches) {
+      walk(branch.condition);
+      resolve_block(branch.body, nullptr);
+    }
+  }
+  void visit_while(const parser::WhileStmt *ws) {
+    resolve_block(ws->body, ws->condition);
+  }
+  // Nested FuncDefs are never executed.
+  void visit_func_def(const parser::FuncDef *) {}
+};
+
+} // namespace
+
+Resolution cimple::semantic::resolve_names(const parser::Module &module) {
+  Resolution res;
+  res.globals = direct_assignments(module.body);
+
+  std::unordered_map<lexer::SymbolId, std::uint32_t> global_index;
+  for (std::uint32_t i = 0; i < res.globals.size(); ++i)
+    global_index[res.globals[i]] = i;
+
+  for (const auto &stmt : module.body) {
+    auto fn = parser::dyn_cast<parser::FuncDef>(stmt);
+    if (!fn)
+      continue;
+    std::unordered_set<lexer::SymbolId> params(fn->param_ids.begin(),
+                                               fn->param_ids.end());
+    if (params.size() != fn->param_ids.size()) {
+      res.unsupported.push_back(fn);
+      continue;
+    }
+    FrameLayout &layout = res.functions[fn];
+    FrameResolver(res, layout, &global_index).resolve_function(fn);
+  }
+
+  FrameResolver(res, res.main, nullptr).resolve_module(module, res.globals);
+  return res;
+}
@@ -16,11 +16,6 @@ static bool is_truthy_compatible(TypeKind t) {
          t == TypeKind::Float || t == TypeKind::String;
 }
 
-static bool is_comparison_op(const std::string &op) {
-  return op == "==" || op == "!=" || op == "<" || op == ">" || op == "<=" ||
-         op == ">=";
-}
-
 static TypeKind merge_assignment_type(TypeKind existing, TypeKind incoming) {
   if (existing == TypeKind::Unknown)
     return incoming;
@@ -65,7 +60,7 @@ std::vector<std::string> TypeChecker::get_errors() {
 
   for (const auto &stmt : module_.body) {
     if (stmt) {
-      check_stmt(stmt.get(), env, false);
+      check_stmt(stmt, env, false);
     }
   }
 
@@ -77,45 +72,42 @@ void TypeChecker::check_stmt(const parser::Stmt *stmt, ScopedTypeEnv &local_env,
   if (!stmt)
     return;
 
-  if (auto assign = dynamic_cast<const parser::AssignStmt *>(stmt)) {
-    check_assignment(assign, local_env);
+  switch (stmt->kind) {
+  case parser::NodeKind::AssignStmt:
+    check_assignment(parser::cast<parser::AssignStmt>(stmt), local_env);
     return;
-  }
 
-  if (auto expr_stmt = dynamic_cast<const parser::ExprStmt *>(stmt)) {
-    check_expr(expr_stmt->expr.get(), local_env);
+  case parser::NodeKind::ExprStmt:
+    check_expr(parser::cast<parser::ExprStmt>(stmt)->expr, local_env);
     return;
-  }
 
-  if (auto ret = dynamic_cast<const parser::ReturnStmt *>(stmt)) {
-    check_expr(ret->value.get(), local_env);
+  case parser::NodeKind::ReturnStmt:
+    check_expr(parser::cast<parser::ReturnStmt>(stmt)->value, local_env);
     return;
-  }
 
-  if (dynamic_cast<const parser::BreakStmt *>(stmt)) {
+  case parser::NodeKind::BreakStmt:
     if (!in_loop) {
       add_error("'break' used outside of loop", get_location(stmt));
     }
     return;
-  }
 
-  if (dynamic_cast<const parser::ContinueStmt *>(stmt)) {
+  case parser::NodeKind::ContinueStmt:
     if (!in_loop) {
       add_error("'continue' used outside of loop", get_location(stmt));
     }
     return;
-  }
 
-  if (auto func_def = dynamic_cast<const parser::FuncDef *>(stmt)) {
+  case parser::NodeKind::FuncDef: {
+    auto func_def = parser::cast<parser::FuncDef>(stmt);
     local_env.push_scope(ScopedTypeEnv::ScopeKind::Function);
 
-    for (const auto &param : func_def->params) {
+    for (lexer::SymbolId param : func_def->param_ids) {
       local_env.set_local(param, TypeKind::Unknown);
     }
 
     for (const auto &body_stmt : func_def->body) {
       if (body_stmt) {
-        check_stmt(body_stmt.get(), local_env, false);
+        check_stmt(body_stmt, local_env, false);
       }
     }
 
@@ -123,20 +115,21 @@ void TypeChecker::check_stmt(const parser::Stmt *stmt, ScopedTypeEnv &local_env,
     return;
   }
 
-  if (auto if_stmt = dynamic_cast<const parser::IfStmt *>(stmt)) {
+  case parser::NodeKind::IfStmt: {
+    auto if_stmt = parser::cast<parser::IfStmt>(stmt);
     for (const auto &branch : if_stmt->branches) {
       if (branch.condition) {
-        TypeKind cond = check_expr(branch.condition.get(), local_env);
+        TypeKind cond = check_expr(branch.condition, local_env);
         if (!is_truthy_compatible(cond)) {
           add_error("if-condition is not truthy-compatible",
-                    get_location(branch.condition.get()));
+                    get_location(branch.condition));
         }
       }
 
       local_env.push_scope(ScopedTypeEnv::ScopeKind::Block);
       for (const auto &body_stmt : branch.body) {
         if (body_stmt) {
-          check_stmt(body_stmt.get(), local_env, in_loop);
+          check_stmt(body_stmt, local_env, in_loop);
         }
       }
       local_env.pop_scope();
@@ -144,22 +137,27 @@ void TypeChecker::check_stmt(const parser::Stmt *stmt, ScopedTypeEnv &local_env,
     return;
   }
 
-  if (auto while_stmt = dynamic_cast<const parser::WhileStmt *>(stmt)) {
-    TypeKind cond = check_expr(while_stmt->condition.get(), local_env);
+  case parser::NodeKind::WhileStmt: {
+    auto while_stmt = parser::cast<parser::WhileStmt>(stmt);
+    TypeKind cond = check_expr(while_stmt->condition, local_env);
     if (!is_truthy_compatible(cond)) {
       add_error("while-condition is not truthy-compatible",
-                get_location(while_stmt->condition.get()));
+                get_location(while_stmt->condition));
     }
 
     local_env.push_scope(ScopedTypeEnv::ScopeKind::Block);
     for (const auto &body_stmt : while_stmt->body) {
       if (body_stmt) {
-        check_stmt(body_stmt.get(), local_env, true);
+        check_stmt(body_stmt, local_env, true);
       }
     }
     local_env.pop_scope();
     return;
   }
+
+  default:
+    break;
+  }
 }
 
 TypeKind TypeChecker::check_expr(const parser::Expr *expr,
@@ -167,30 +165,31 @@ TypeKind TypeChecker::check_expr(const parser::Expr *expr,
   if (!expr)
     return TypeKind::Unknown;
 
-  if (auto num = dynamic_cast<const parser::NumberLiteral *>(expr)) {
-    return (num->value.find('.') != std::string::npos) ? TypeKind::Float
-                                                        : TypeKind::Int;
-  }
+  switch (expr->kind) {
+  case parser::NodeKind::NumberLiteral:
+    return parser::cast<parser::NumberLiteral>(expr)->is_float()
+               ? TypeKind::Float
+               : TypeKind::Int;
 
-  if (dynamic_cast<const parser::StringLiteral *>(expr)) {
+  case parser::NodeKind::StringLiteral:
     return TypeKind::String;
-  }
 
-  if (dynamic_cast<const parser::BoolLiteral *>(expr)) {
+  case parser::NodeKind::BoolLiteral:
     return TypeKind::Bool;
-  }
 
-  if (auto var_ref = dynamic_cast<const parser::VarRef *>(expr)) {
-    if (const auto *found = local_env.lookup(var_ref->name)) {
+  case parser::NodeKind::VarRef: {
+    auto var_ref = parser::cast<parser::VarRef>(expr);
+    if (const auto *found = local_env.lookup(var_ref->id)) {
       return *found;
     }
     return TypeKind::Unknown;
   }
 
-  if (auto unary = dynamic_cast<const parser::UnaryOp *>(expr)) {
-    TypeKind operand = check_expr(unary->operand.get(), local_env);
+  case parser::NodeKind::UnaryOp: {
+    auto unary = parser::cast<parser::UnaryOp>(expr);
+    TypeKind operand = check_expr(unary->operand, local_env);
 
-    if (unary->op == "not") {
+    if (unary->op == parser::UnOpKind::Not) {
       if (!is_truthy_compatible(operand)) {
         add_error("Operand of 'not' must be truthy-compatible",
                   get_location(unary));
@@ -198,19 +197,27 @@ TypeKind TypeChecker::check_expr(const parser::Expr *expr,
       return TypeKind::Bool;
     }
 
-    if (unary->op == "-") {
+    if (unary->op == parser::UnOpKind::Neg) {
       if (!is_numeric(operand) && operand != TypeKind::Unknown) {
         add_error("Unary '-' operand must be numeric", get_location(unary));
       }
       return operand;
     }
 
+    if (unary->op == parser::UnOpKind::BitNot) {
+      if (operand != TypeKind::Int && operand != TypeKind::Unknown) {
+        add_error("Unary '~' operand must be int", get_location(unary));
+      }
+      return TypeKind::Int;
+    }
+
     return TypeKind::Unknown;
   }
 
-  if (auto logical = dynamic_cast<const parser::LogicalExpr *>(expr)) {
-    TypeKind left_type = check_expr(logical->left.get(), local_env);
-    TypeKind right_type = check_expr(logical->right.get(), local_env);
+  case parser::NodeKind::LogicalExpr: {
+    auto logical = parser::cast<parser::LogicalExpr>(expr);
+    TypeKind left_type = check_expr(logical->left, local_env);
+    TypeKind right_type = check_expr(logical->right, local_env);
 
     if (!is_truthy_compatible(left_type)) {
       add_error("Left operand of logical operator must be truthy-compatible",
@@ -224,25 +231,34 @@ TypeKind TypeChecker::check_expr(const parser::Expr *expr,
     return TypeKind::Bool;
   }
 
-  if (auto bin_op = dynamic_cast<const parser::BinaryOp *>(expr)) {
-    TypeKind left_type = check_expr(bin_op->left.get(), local_env);
-    TypeKind right_type = check_expr(bin_op->right.get(), local_env);
+  case parser::NodeKind::BinaryOp: {
+    auto bin_op = parser::cast<parser::BinaryOp>(expr);
+    TypeKind left_type = check_expr(bin_op->left, local_env);
+    TypeKind right_type = check_expr(bin_op->right, local_env);
 
-    check_binary_op(bin_op, left_type, right_type, get_location(bin_op));
+    check_binary_op(bin_op->op, left_type, right_type, get_location(bin_op));
 
-    if (is_comparison_op(bin_op->op)) {
+    if (parser::is_comparison(bin_op->op)) {
       return TypeKind::Bool;
     }
 
-    if (bin_op->op == "+" && left_type == TypeKind::String &&
-        right_type == TypeKind::String) {
+    if (parser::is_bitwise(bin_op->op)) {
+      return TypeKind::Int;
+    }
+
+    if (bin_op->op == parser::BinOpKind::Add &&
+        left_type == TypeKind::String && right_type == TypeKind::String) {
       return TypeKind::String;
     }
 
     if (is_numeric(left_type) && is_numeric(right_type)) {
-      if (bin_op->op == "/") {
+      if (bin_op->op == parser::BinOpKind::Div) {
         return TypeKind::Float;
       }
+      if (bin_op->op == parser::BinOpKind::Pow &&
+          left_type == TypeKind::Int && right_type == TypeKind::Int) {
+        return TypeKind::Unknown; // float for a negative exponent
+      }
       return (left_type == TypeKind::Float || right_type == TypeKind::Float)
                  ? TypeKind::Float
                  : TypeKind::Int;
@@ -251,15 +267,28 @@ TypeKind TypeChecker::check_expr(const parser::Expr *expr,
     return TypeKind::Unknown;
   }
 
-  if (auto call = dynamic_cast<const parser::CallExpr *>(expr)) {
+  case parser::NodeKind::CompareChain: {
+    auto chain = parser::cast<parser::CompareChain>(expr);
+    TypeKind left_type = check_expr(chain->operands[0], local_env);
+    for (std::size_t i = 0; i < chain->ops.size(); ++i) {
+      TypeKind right_type = check_expr(chain->operands[i + 1], local_env);
+      check_binary_op(chain->ops[i], left_type, right_type,
+                      get_location(chain));
+      left_type = right_type;
+    }
+    return TypeKind::Bool;
+  }
+
+  case parser::NodeKind::CallExpr: {
+    auto call = parser::cast<parser::CallExpr>(expr);
     check_call(call, local_env);
 
-    if (auto callee_var = dynamic_cast<const parser::VarRef *>(call->callee.get())) {
-      if (callee_var->name == "print") {
+    if (auto callee_var = parser::dyn_cast<parser::VarRef>(call->callee)) {
+      if (callee_var->id == lexer::sym::print) {
         return TypeKind::Void;
       }
 
-      auto it = type_env_.functions.find(callee_var->name);
+      auto it = type_env_.functions.find(callee_var->id);
       if (it != type_env_.functions.end()) {
         return it->second;
       }
@@ -268,16 +297,17 @@ TypeKind TypeChecker::check_expr(const parser::Expr *expr,
     return TypeKind::Unknown;
   }
 
+  default:
+    break;
+  }
+
   return TypeKind::Unknown;
 }
 
-void TypeChecker::check_binary_op(const parser::BinaryOp *op, TypeKind left_type,
+void TypeChecker::check_binary_op(parser::BinOpKind op, TypeKind left_type,
                                   TypeKind right_type,
                                   lexer::SourceLocation loc) {
-  if (!op)
-    return;
-
-  if (is_comparison_op(op->op)) {
+  if (parser::is_comparison(op)) {
     const bool both_numeric = is_numeric(left_type) && is_numeric(right_type);
     const bool both_string =
         left_type == TypeKind::String && right_type == TypeKind::String;
@@ -288,30 +318,50 @@ void TypeChecker::check_binary_op(const parser::BinaryOp *op, TypeKind left_type
     if (both_numeric || both_string || has_unknown)
       return;
 
-    if (both_bool && (op->op == "==" || op->op == "!="))
+    if (both_bool &&
+        (op == parser::BinOpKind::Eq || op == parser::BinOpKind::Ne))
       return;
 
-    add_error("Invalid operand types for comparison operator '" + op->op + "'",
+    add_error(std::string("Invalid operand types for comparison operator '") +
+                  parser::op_spelling(op) + "'",
               loc);
     return;
   }
 
-  if (op->op == "+" && (left_type == TypeKind::String || right_type == TypeKind::String)) {
+  if (op == parser::BinOpKind::Add &&
+      (left_type == TypeKind::String || right_type == TypeKind::String)) {
     if (!(left_type == TypeKind::String && right_type == TypeKind::String)) {
       add_error("String concatenation requires string + string", loc);
     }
     return;
   }
 
-  if (op->op == "+" || op->op == "-" || op->op == "*" || op->op == "/") {
+  if (parser::is_bitwise(op)) {
+    if (left_type != TypeKind::Int && left_type != TypeKind::Unknown) {
+      add_error(std::string("Left operand of '") + parser::op_spelling(op) +
+                    "' must be int, got " + type_to_string(left_type),
+                loc);
+    }
+
+    if (right_type != TypeKind::Int && right_type != TypeKind::Unknown) {
+      add_error(std::string("Right operand of '") + parser::op_spelling(op) +
+                    "' must be int, got " + type_to_string(right_type),
+                loc);
+    }
+    return;
+  }
+
+  if (parser::is_arithmetic(op)) {
     if (!is_numeric(left_type) && left_type != TypeKind::Unknown) {
-      add_error("Left operand of '" + op->op + "' must be numeric, got " +
+      add_error(std::string("Left operand of '") +
+                    parser::op_spelling(op) + "' must be numeric, got " +
                     type_to_string(left_type),
                 loc);
     }
 
     if (!is_numeric(right_type) && right_type != TypeKind::Unknown) {
-      add_error("Right operand of '" + op->op + "' must be numeric, got " +
+      add_error(std::string("Right operand of '") +
+                    parser::op_spelling(op) + "' must be numeric, got " +
                     type_to_string(right_type),
                 loc);
     }
@@ -324,15 +374,16 @@ void TypeChecker::check_call(const parser::CallExpr *call,
     return;
 
   for (const auto &arg : call->args) {
-    check_expr(arg.get(), local_env);
+    check_expr(arg, local_env);
   }
 
-  if (auto callee_var = dynamic_cast<const parser::VarRef *>(call->callee.get())) {
-    if (callee_var->name == "print")
+  if (auto callee_var = parser::dyn_cast<parser::VarRef>(call->callee)) {
+    if (callee_var->id == lexer::sym::print)
       return;
 
-    if (type_env_.functions.find(callee_var->name) == type_env_.functions.end()) {
-      add_error("Call to unknown function '" + callee_var->name + "'",
+    if (type_env_.functions.find(callee_var->id) == type_env_.functions.end()) {
+      add_error("Call to unknown function '" + std::string(callee_var->name) +
+                    "'",
                 get_location(call));
     }
   }
@@ -343,40 +394,41 @@ void TypeChecker::check_assignment(const parser::AssignStmt *assign,
   if (!assign)
     return;
 
-  TypeKind value_type = check_expr(assign->value.get(), local_env);
+  TypeKind value_type = check_expr(assign->value, local_env);
 
-  if (const auto *existing = local_env.lookup_current(assign->target)) {
+  if (const auto *existing = local_env.lookup_current(assign->target_id)) {
     if (*existing != TypeKind::Unknown && value_type != TypeKind::Unknown) {
       const bool both_numeric = is_numeric(*existing) && is_numeric(value_type);
       if (!both_numeric && *existing != value_type) {
         add_error("Cannot assign " + type_to_string(value_type) +
-                      " to variable '" + assign->target + "' of type " +
+                      " to variable '" + std::string(assign->target) +
+                      "' of type " +
                       type_to_string(*existing),
                   get_location(assign));
         return;
       }
     }
 
-    local_env.set_local(assign->target, merge_assignment_type(*existing, value_type));
+    local_env.set_local(assign->target_id, merge_assignment_type(*existing, value_type));
     return;
   }
 
-  local_env.set_local(assign->target, value_type);
+  local_env.set_local(assign->target_id, value_type);
 }
 
 lexer::SourceLocation TypeChecker::get_location(const parser::Node *node) {
-  (void)node;
-  // For now, return default location.
-  // In a full implementation, AST nodes would store source locations.
-  return {0, 0};
+  if (!node || !lines_)
+    return {0, 0};
+  return lines_->locate(node->offset);
 }
 
 namespace cimple {
 namespace semantic {
 
 bool check_types(const parser::Module &module, const TypeEnv &type_env,
-                 std::vector<std::string> &errors) {
-  TypeChecker checker(module, type_env);
+                 std::vector<std::string> &errors,
+                 const diagnostics::LineTable *lines) {
+  TypeChecker checker(module, type_env, lines);
   errors = checker.get_errors();
   return errors.empty();
 }
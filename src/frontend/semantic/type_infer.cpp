@@ -7,169 +7,138 @@ using namespace cimple::semantic;
 
 namespace {
 
-using TypeScope = cimple::semantic::ScopeStack<cimple::semantic::TypeKind>;
+using TypeScope =
+    cimple::semantic::ScopeStack<cimple::semantic::TypeKind, lexer::SymbolId>;
 
 static bool is_numeric(TypeKind t) {
   return t == TypeKind::Int || t == TypeKind::Float;
 }
 
-static bool is_comparison_op(const std::string &op) {
-  return op == "==" || op == "!=" || op == "<" || op == ">" || op == "<=" ||
-         op == ">=";
-}
-
-static TypeKind unify(TypeKind a, TypeKind b) {
-  if (a == TypeKind::Unknown)
-    return b;
-  if (b == TypeKind::Unknown)
-    return a;
-  if (a == TypeKind::Void)
-    return b;
-  if (b == TypeKind::Void)
-    return a;
-  if (a == b)
-    return a;
-  if ((a == TypeKind::Int && b == TypeKind::Float) ||
-      (a == TypeKind::Float && b == TypeKind::Int)) {
-    return TypeKind::Float;
-  }
-  return TypeKind::Unknown;
-}
-
 static TypeKind infer_expr(
     const parser::Expr *e, TypeScope &vars,
-    const std::unordered_map<std::string, TypeKind> &functions) {
+    const std::unordered_map<lexer::SymbolId, TypeKind> &functions) {
   if (!e)
     return TypeKind::Unknown;
 
-  if (auto n = dynamic_cast<const parser::NumberLiteral *>(e)) {
-    return (n->value.find('.') != std::string::npos) ? TypeKind::Float
-                                                      : TypeKind::Int;
-  }
+  switch (e->kind) {
+  case parser::NodeKind::NumberLiteral:
+    return parser::cast<parser::NumberLiteral>(e)->is_float()
+               ? TypeKind::Float
+               : TypeKind::Int;
 
-  if (dynamic_cast<const parser::StringLiteral *>(e))
+  case parser::NodeKind::StringLiteral:
     return TypeKind::String;
 
-  if (dynamic_cast<const parser::BoolLiteral *>(e))
+  case parser::NodeKind::BoolLiteral:
     return TypeKind::Bool;
 
-  if (auto v = dynamic_cast<const parser::VarRef *>(e)) {
-    if (const auto *found = vars.lookup(v->name))
+  case parser::NodeKind::VarRef: {
+    auto v = parser::cast<parser::VarRef>(e);
+    if (const auto *found = vars.lookup(v->id))
       return *found;
     return TypeKind::Unknown;
   }
 
-  if (auto u = dynamic_cast<const parser::UnaryOp *>(e)) {
-    TypeKind operand = infer_expr(u->operand.get(), vars, functions);
-    if (u->op == "not")
-      return TypeKind::Bool;
-    if (u->op == "-" && is_numeric(operand))
-      return operand;
-    return TypeKind::Unknown;
+  case parser::NodeKind::UnaryOp: {
+    auto u = parser::cast<parser::UnaryOp>(e);
+    return unary_type(u->op, infer_expr(u->operand, vars, functions));
   }
 
-  if (auto lg = dynamic_cast<const parser::LogicalExpr *>(e)) {
-    infer_expr(lg->left.get(), vars, functions);
-    infer_expr(lg->right.get(), vars, functions);
+  case parser::NodeKind::LogicalExpr: {
+    auto lg = parser::cast<parser::LogicalExpr>(e);
+    infer_expr(lg->left, vars, functions);
+    infer_expr(lg->right, vars, functions);
     return TypeKind::Bool;
   }
 
-  if (auto b = dynamic_cast<const parser::BinaryOp *>(e)) {
-    TypeKind left = infer_expr(b->left.get(), vars, functions);
-    TypeKind right = infer_expr(b->right.get(), vars, functions);
-
-    if (is_comparison_op(b->op)) {
-      return TypeKind::Bool;
-    }
-
-    if (b->op == "+" && left == TypeKind::String && right == TypeKind::String) {
-      return TypeKind::String;
-    }
-
-    if (is_numeric(left) && is_numeric(right)) {
-      if (b->op == "/") {
-        return TypeKind::Float;
-      }
-      return unify(left, right);
-    }
+  case parser::NodeKind::BinaryOp: {
+    auto b = parser::cast<parser::BinaryOp>(e);
+    TypeKind left = infer_expr(b->left, vars, functions);
+    TypeKind right = infer_expr(b->right, vars, functions);
+    return binary_type(b->op, left, right);
+  }
 
-    return TypeKind::Unknown;
+  case parser::NodeKind::CompareChain: {
+    auto ch = parser::cast<parser::CompareChain>(e);
+    for (const parser::Expr *operand : ch->operands)
+      infer_expr(operand, vars, functions);
+    return TypeKind::Bool;
   }
 
-  if (auto c = dynamic_cast<const parser::CallExpr *>(e)) {
-    if (auto vr = dynamic_cast<const parser::VarRef *>(c->callee.get())) {
-      if (vr->name == "print") {
+  case parser::NodeKind::CallExpr: {
+    auto c = parser::cast<parser::CallExpr>(e);
+    if (auto vr = parser::dyn_cast<parser::VarRef>(c->callee)) {
+      if (vr->id == lexer::sym::print) {
         for (const auto &arg : c->args) {
-          infer_expr(arg.get(), vars, functions);
+          infer_expr(arg, vars, functions);
         }
         return TypeKind::Void;
       }
-      auto it = functions.find(vr->name);
+      auto it = functions.find(vr->id);
       if (it != functions.end())
         return it->second;
     }
 
     for (const auto &arg : c->args) {
-      infer_expr(arg.get(), vars, functions);
+      infer_expr(arg, vars, functions);
     }
     return TypeKind::Unknown;
   }
 
-  return TypeKind::Unknown;
+  default:
+    return TypeKind::Unknown;
+  }
 }
 
 static TypeKind infer_stmt(
     const parser::Stmt *stmt, TypeScope &vars,
-    std::unordered_map<std::string, TypeKind> &functions);
+    std::unordered_map<lexer::SymbolId, TypeKind> &functions);
 
 static TypeKind infer_block(
-    const std::vector<std::unique_ptr<parser::Stmt>> &body, TypeScope &vars,
-    std::unordered_map<std::string, TypeKind> &functions) {
+    const parser::StmtList &body, TypeScope &vars,
+    std::unordered_map<lexer::SymbolId, TypeKind> &functions) {
   TypeKind ret = TypeKind::Void;
   for (const auto &stmt : body) {
     if (!stmt)
       continue;
-    ret = unify(ret, infer_stmt(stmt.get(), vars, functions));
+    ret = unify(ret, infer_stmt(stmt, vars, functions));
   }
   return ret;
 }
 
 static TypeKind infer_stmt(
     const parser::Stmt *stmt, TypeScope &vars,
-    std::unordered_map<std::string, TypeKind> &functions) {
+    std::unordered_map<lexer::SymbolId, TypeKind> &functions) {
   if (!stmt)
     return TypeKind::Void;
 
-  if (auto a = dynamic_cast<const parser::AssignStmt *>(stmt)) {
-    TypeKind rhs = infer_expr(a->value.get(), vars, functions);
-    if (auto *current = vars.lookup_current_mut(a->target)) {
+  switch (stmt->kind) {
+  case parser::NodeKind::AssignStmt: {
+    auto a = parser::cast<parser::AssignStmt>(stmt);
+    TypeKind rhs = infer_expr(a->value, vars, functions);
+    if (auto *current = vars.lookup_current_mut(a->target_id)) {
       *current = unify(*current, rhs);
     } else {
-      vars.set_local(a->target, rhs);
+      vars.set_local(a->target_id, rhs);
     }
     return TypeKind::Void;
   }
 
-  if (auto es = dynamic_cast<const parser::ExprStmt *>(stmt)) {
-    infer_expr(es->expr.get(), vars, functions);
+  case parser::NodeKind::ExprStmt:
+    infer_expr(parser::cast<parser::ExprStmt>(stmt)->expr, vars, functions);
     return TypeKind::Void;
-  }
-
-  if (auto rs = dynamic_cast<const parser::ReturnStmt *>(stmt)) {
-    return infer_expr(rs->value.get(), vars, functions);
-  }
 
-  if (dynamic_cast<const parser::BreakStmt *>(stmt) ||
-      dynamic_cast<const parser::ContinueStmt *>(stmt)) {
-    return TypeKind::Void;
-  }
+  case parser::NodeKind::ReturnStmt:
+    return infer_expr(parser::cast<parser::ReturnStmt>(stmt)->value, vars,
+                      functions);
 
-  if (auto is = dynamic_cast<const parser::IfStmt *>(stmt)) {
+  case parser::NodeKind::IfStmt: {
+    auto is = parser::cast<parser::IfStmt>(stmt);
     TypeKind branches_ret = TypeKind::Void;
 
     for (const auto &branch : is->branches) {
       if (branch.condition) {
-        infer_expr(branch.condition.get(), vars, functions);
+        infer_expr(branch.condition, vars, functions);
       }
 
       vars.push_scope(TypeScope::ScopeKind::Block);
@@ -182,8 +151,9 @@ static TypeKind infer_stmt(
     return branches_ret;
   }
 
-  if (auto ws = dynamic_cast<const parser::WhileStmt *>(stmt)) {
-    infer_expr(ws->condition.get(), vars, functions);
+  case parser::NodeKind::WhileStmt: {
+    auto ws = parser::cast<parser::WhileStmt>(stmt);
+    infer_expr(ws->condition, vars, functions);
 
     vars.push_scope(TypeScope::ScopeKind::Block);
     TypeKind body_ret = infer_block(ws->body, vars, functions);
@@ -192,24 +162,23 @@ static TypeKind infer_stmt(
     return body_ret;
   }
 
-  // Function definitions are inferred in a dedicated pass.
-  if (dynamic_cast<const parser::FuncDef *>(stmt)) {
+  // break/continue yield nothing; function definitions are inferred in a
+  // dedicated pass.
+  default:
     return TypeKind::Void;
   }
-
-  return TypeKind::Void;
 }
 
 static TypeKind infer_function_return(
-    const parser::FuncDef *fn, const std::unordered_map<std::string, TypeKind> &global_vars,
-    std::unordered_map<std::string, TypeKind> &functions) {
+    const parser::FuncDef *fn, const std::unordered_map<lexer::SymbolId, TypeKind> &global_vars,
+    std::unordered_map<lexer::SymbolId, TypeKind> &functions) {
   TypeScope local;
   for (const auto &kv : global_vars) {
     local.set_global(kv.first, kv.second);
   }
 
   local.push_scope(TypeScope::ScopeKind::Function);
-  for (const auto &param : fn->params) {
+  for (lexer::SymbolId param : fn->param_ids) {
     local.set_local(param, TypeKind::Unknown);
   }
 
@@ -220,18 +189,79 @@ static TypeKind infer_function_return(
 
 static void infer_global_statements(
     const parser::Module &module, TypeScope &globals,
-    std::unordered_map<std::string, TypeKind> &functions) {
+    std::unordered_map<lexer::SymbolId, TypeKind> &functions) {
   for (const auto &stmt : module.body) {
     if (!stmt)
       continue;
-    if (dynamic_cast<const parser::FuncDef *>(stmt.get()))
+    if (parser::isa<parser::FuncDef>(stmt))
       continue;
-    infer_stmt(stmt.get(), globals, functions);
+    infer_stmt(stmt, globals, functions);
   }
 }
 
 } // namespace
 
+TypeKind cimple::semantic::unary_type(parser::UnOpKind op, TypeKind operand) {
+  if (op == parser::UnOpKind::Not)
+    return TypeKind::Bool;
+  if (op == parser::UnOpKind::Neg && is_numeric(operand))
+    return operand;
+  if (op == parser::UnOpKind::BitNot && operand == TypeKind::Int)
+    return TypeKind::Int;
+  return TypeKind::Unknown;
+}
+
+TypeKind cimple::semantic::binary_type(parser::BinOpKind op, TypeKind left,
+                                       TypeKind right) {
+  if (parser::is_comparison(op)) {
+    return TypeKind::Bool;
+  }
+
+  if (op == parser::BinOpKind::Add && left == TypeKind::String &&
+      right == TypeKind::String) {
+    return TypeKind::String;
+  }
+
+  if (parser::is_bitwise(op)) {
+    return left == TypeKind::Int && right == TypeKind::Int ? TypeKind::Int
+                                                           : TypeKind::Unknown;
+  }
+
+  if (is_numeric(left) && is_numeric(right)) {
+    if (op == parser::BinOpKind::Div) {
+      return TypeKind::Float;
+    }
+    // int ** int is a float when the exponent is negative.
+    if (op == parser::BinOpKind::Pow) {
+      return unify(left, right) == TypeKind::Float ? TypeKind::Float
+                                                   : TypeKind::Unknown;
+    }
+    return unify(left, right);
+  }
+
+  return TypeKind::Unknown;
+}
+
+TypeKind cimple::semantic::unify(TypeKind a, TypeKind b) {
+  if (a == TypeKind::Unknown)
+    return b;
+  if (b == TypeKind::Unknown)
+    return a;
+  if (a == TypeKind::Void)
+    return b;
+  if (b == TypeKind::Void)
+    return a;
+  if (a == b)
+    return a;
+  if ((a == TypeKind::Int && b == TypeKind::Float) ||
+      (a == TypeKind::Float && b == TypeKind::Int)) {
+    return TypeKind::Float;
+  }
+  return TypeKind::Unknown;
+}
+
+// Globals first, then function return types to a fixpoint, then the globals
+// again now that calls have types.
 TypeEnv cimple::semantic::infer_types(const parser::Module &module) {
   TypeEnv env;
 
@@ -239,8 +269,8 @@ TypeEnv cimple::semantic::infer_types(const parser::Module &module) {
   for (const auto &stmt : module.body) {
     if (!stmt)
       continue;
-    if (auto fn = dynamic_cast<const parser::FuncDef *>(stmt.get())) {
-      env.functions[fn->name] = TypeKind::Unknown;
+    if (auto fn = parser::dyn_cast<parser::FuncDef>(stmt)) {
+      env.functions[fn->name_id] = TypeKind::Unknown;
       function_defs.push_back(fn);
     }
   }
@@ -258,7 +288,7 @@ TypeEnv cimple::semantic::infer_types(const parser::Module &module) {
 
     for (const parser::FuncDef *fn : function_defs) {
       TypeKind inferred = infer_function_return(fn, env.vars, env.functions);
-      TypeKind &slot = env.functions[fn->name];
+      TypeKind &slot = env.functions[fn->name_id];
       TypeKind merged = unify(slot, inferred);
       if (merged != slot) {
         slot = merged;
@@ -1 +1,190 @@
-// file_loader.cpp - stub
+// file_loader.cpp - memory-mapped source loading
+#include "utils/file_loader.h"
+#include <cerrno>
+#include <cstdio>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace cimple::utils;
+
+namespace {
+
+// A mapping of `size` bytes only has a '\0' after the contents when the
+// file does not end exactly on a page boundary: the kernel zero-fills the
+// rest of the last page. Otherwise the byte past the end is unmapped.
+bool mapping_has_sentinel(std::size_t size, std::size_t page_size) {
+  return size > 0 && size % page_size != 0;
+}
+
+} // namespace
+
+SourceBuffer::SourceBuffer(SourceBuffer &&other) noexcept
+    : size_(other.size_), mapping_(other.mapping_),
+      mapping_size_(other.mapping_size_), owned_(std::move(other.owned_)) {
+  data_ = mapping_ ? other.data_ : owned_.c_str();
+  other.data_ = "";
+  other.size_ = 0;
+  other.mapping_ = nullptr;
+  other.mapping_size_ = 0;
+}
+
+SourceBuffer &SourceBuffer::operator=(SourceBuffer &&other) noexcept {
+  if (this != &other) {
+    release();
+    size_ = other.size_;
+    mapping_ = other.mapping_;
+    mapping_size_ = other.mapping_size_;
+    owned_ = std::move(other.owned_);
+    data_ = mapping_ ? other.data_ : owned_.c_str();
+    other.data_ = "";
+    other.size_ = 0;
+    other.mapping_ = nullptr;
+    other.mapping_size_ = 0;
+  }
+  return *this;
+}
+
+SourceBuffer::~SourceBuffer() { release(); }
+
+// ---------------------------------------------------------------------------
+// Platform mapping
+// ---------------------------------------------------------------------------
+
+#ifdef _WIN32
+
+static bool read_stream(std::FILE *f, std::string &out) {
+  char chunk[1 << 16];
+  std::size_t n;
+  while ((n = std::fread(chunk, 1, sizeof chunk, f)) > 0)
+    out.append(chunk, n);
+  return !std::ferror(f);
+}
+
+void SourceBuffer::release() {
+  if (mapping_)
+    UnmapViewOfFile(mapping_);
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+}
+
+std::optional<SourceBuffer> SourceBuffer::open(const std::string &path) {
+  SourceBuffer buf;
+  if (path == "-") {
+    if (!read_stream(stdin, buf.owned_))
+      return std::nullopt;
+    buf.data_ = buf.owned_.c_str();
+    buf.size_ = buf.owned_.size();
+    return buf;
+  }
+
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return std::nullopt;
+
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  LARGE_INTEGER file_size;
+  if (GetFileType(file) == FILE_TYPE_DISK && GetFileSizeEx(file, &file_size) &&
+      mapping_has_sentinel(static_cast<std::size_t>(file_size.QuadPart),
+                           info.dwPageSize)) {
+    HANDLE section =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (section) {
+      void *view = MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(section); // the view keeps the section alive
+      if (view) {
+        CloseHandle(file);
+        buf.mapping_ = view;
+        buf.mapping_size_ = static_cast<std::size_t>(file_size.QuadPart);
+        buf.data_ = static_cast<const char *>(view);
+        buf.size_ = buf.mapping_size_;
+        return buf;
+      }
+    }
+  }
+  CloseHandle(file);
+
+  // Fallback: read through stdio (binary, so line endings are preserved).
+  std::FILE *f = std::fopen(path.c_str(), "rb");
+  if (!f)
+    return std::nullopt;
+  const bool ok = read_stream(f, buf.owned_);
+  std::fclose(f);
+  if (!ok)
+    return std::nullopt;
+  buf.data_ = buf.owned_.c_str();
+  buf.size_ = buf.owned_.size();
+  return buf;
+}
+
+#else
+
+void SourceBuffer::release() {
+  if (mapping_)
+    munmap(mapping_, mapping_size_);
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+}
+
+std::optional<SourceBuffer> SourceBuffer::open(const std::string &path) {
+  const bool is_stdin = path == "-";
+  const int fd = is_stdin ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return std::nullopt;
+
+  SourceBuffer buf;
+  struct stat st;
+  const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  if (!is_stdin && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+      mapping_has_sentinel(static_cast<std::size_t>(st.st_size), page_size)) {
+    const auto size = static_cast<std::size_t>(st.st_size);
+    void *view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view != MAP_FAILED) {
+      ::close(fd); // the mapping stays valid
+      buf.mapping_ = view;
+      buf.mapping_size_ = size;
+      buf.data_ = static_cast<const char *>(view);
+      buf.size_ = size;
+      return buf;
+    }
+  }
+
+  // Fallback for pipes, stdin and page-aligned or empty files.
+  char chunk[1 << 16];
+  ssize_t n;
+  bool ok = true;
+  while ((n = ::read(fd, chunk, sizeof chunk)) != 0) {
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      ok = false;
+      break;
+    }
+    buf.owned_.append(chunk, static_cast<std::size_t>(n));
+  }
+  if (!is_stdin)
+    ::close(fd);
+  if (!ok)
+    return std::nullopt;
+  buf.data_ = buf.owned_.c_str();
+  buf.size_ = buf.owned_.size();
+  return buf;
+}
+
+#endif
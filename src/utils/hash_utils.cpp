@@ -1 +1,60 @@
-// hash_utils.cpp - stub
+// hash_utils.cpp - 64-bit content hash
+#include "utils/hash_utils.h"
+#include <cstring>
+
+using namespace cimple::utils;
+
+namespace {
+
+constexpr std::uint64_t kMul1 = 0x9E3779B97F4A7C15ull;
+constexpr std::uint64_t kMul2 = 0xC2B2AE3D27D4EB4Full;
+
+inline std::uint64_t rotl(std::uint64_t v, int n) {
+  return (v << n) | (v >> (64 - n));
+}
+
+inline std::uint64_t load64(const unsigned char *p) {
+  std::uint64_t v;
+  std::memcpy(&v, p, sizeof v);
+  return v;
+}
+
+inline std::uint64_t mix(std::uint64_t h, std::uint64_t word) {
+  return rotl(h ^ (word * kMul2), 31) * kMul1;
+}
+
+// Final avalanche (from MurmurHash3's fmix64).
+inline std::uint64_t finalize(std::uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDull;
+  h ^= h >> 33;
+  h *= 0xC4CEB9FE1A85EC53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+} // namespace
+
+std::uint64_t cimple::utils::hash_bytes(const void *data, std::size_t size,
+                                        std::uint64_t seed) {
+  const auto *p = static_cast<const unsigned char *>(data);
+  const unsigned char *const end = p + size;
+
+  // Four independent lanes keep the multiplies pipelined on long inputs.
+  std::uint64_t lanes[4] = {seed ^ kMul1, seed ^ kMul2, seed, seed - kMul1};
+  for (; end - p >= 32; p += 32)
+    for (int i = 0; i < 4; ++i)
+      lanes[i] = mix(lanes[i], load64(p + 8 * i));
+
+  std::uint64_t h = static_cast<std::uint64_t>(size) * kMul1;
+  for (std::uint64_t lane : lanes)
+    h = mix(h, lane);
+  for (; end - p >= 8; p += 8)
+    h = mix(h, load64(p));
+  if (p != end) {
+    unsigned char tail[8] = {};
+    std::memcpy(tail, p, static_cast<std::size_t>(end - p));
+    h = mix(h, load64(tail));
+  }
+  return finalize(h);
+}
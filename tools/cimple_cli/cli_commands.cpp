@@ -1,15 +1,27 @@
 // cli_commands.cpp - CLI commands for single `cimple` tool
+#include "frontend/ast/ast_cache.h"
+#include "frontend/ast/ast_visitor.h"
+#include "frontend/ast/flat_ast.h"
+#include "frontend/eval/bytecode_compiler.h"
 #include "frontend/eval/evaluator.h"
+#include "frontend/eval/vm.h"
 #include "frontend/lexer/lexer.h"
 #include "frontend/lexer/token_utils.h"
+#include "frontend/parser/incremental_parser.h"
 #include "frontend/parser/parser.h"
 #include "frontend/semantic/type_checker.h"
 #include "frontend/semantic/type_infer.h"
-#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
 #include <memory>
-#include <sstream>
+#include <optional>
+#include <random>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -18,40 +30,122 @@
 #endif
 #include "backend/ir/ir.h"
 #include "driver/linker_driver.h"
+#include "utils/file_loader.h"
 
-void handle_build(const std::string &path) {
-  // simple pipeline: lex -> parse -> type inference -> report
-  std::ifstream in(path);
-  if (!in.is_open()) {
+// Source files are memory-mapped where possible; the buffer must outlive the
+// tokens lexed from it.
+static std::optional<cimple::utils::SourceBuffer>
+load_source(const std::string &path) {
+  auto source = cimple::utils::SourceBuffer::open(path);
+  if (!source) {
     std::cerr << "[cimple] Cannot open file: " << path << std::endl;
-    return;
+  } else if (source->size() > cimple::diagnostics::kMaxSourceBytes) {
+    // Token and AST positions are 32-bit offsets.
+    std::cerr << "[cimple] Source file too large (over 4 GiB): " << path
+              << std::endl;
+    return std::nullopt;
   }
-  std::ostringstream buf;
-  buf << in.rdbuf();
-  std::string source = buf.str();
-  auto tokens = cimple::lexer::lex(source);
-  std::cout << "[cimple] Lexed " << tokens.size() << " tokens\n";
+  return source;
+}
 
-  cimple::parser::Parser p(tokens);
-  auto module = p.parse_module();
+// ---------------------------------------------------------------------------
+// Front end with the .cimpc AST cache (see ast/ast_cache.h). A module is
+// loaded from <file>.cimpc when that was saved for the same source, compiler
+// and options; otherwise the source is parsed and, unless the parser
+// reported errors (which a cache hit would silence), the cache (re)written.
+// Callers that need inferred types ask for them, and they are cached too.
+// CIMPLE_NO_CACHE=1 turns the cache off; stdin is never cached.
+// ---------------------------------------------------------------------------
+
+struct FrontEndResult {
+  cimple::parser::Module module;
+  std::optional<cimple::semantic::TypeEnv> types; // if requested
+  std::size_t token_count = 0;                    // 0 when loaded
+  bool from_cache = false;
+};
+
+// Front-end settings that change the AST; part of the cache key.
+static constexpr const char *kFrontEndOptions = "";
+
+static bool cache_enabled(const std::string &path) {
+  const char *off = std::getenv("CIMPLE_NO_CACHE");
+  return path != "-" && !(off && *off && std::string(off) != "0");
+}
+
+static FrontEndResult parse_source(const std::string &path,
+                                   const cimple::utils::SourceBuffer &source,
+                                   bool with_types) {
+  namespace ast = cimple::ast;
+  FrontEndResult result;
+  const bool use_cache = cache_enabled(path);
+  ast::CacheKey key;
+  if (use_cache) {
+    key = ast::make_cache_key(source.text(), kFrontEndOptions);
+    if (auto cached = ast::load_cached_module(ast::cache_path(path), key)) {
+      result.module = std::move(cached->module);
+      result.types = std::move(cached->types);
+      result.from_cache = true;
+      if (!with_types || result.types)
+        return result;
+    }
+  }
+  bool parse_errors = false;
+  if (!result.from_cache &&
+      source.text().size() >= cimple::lexer::kParallelLexMinBytes &&
+      std::thread::hardware_concurrency() > 1) {
+    // Large input on a multicore machine: lex and parse on every core, at
+    // the cost of holding all the tokens at once.
+    const auto tokens = cimple::lexer::lex_from_view(source.text());
+    cimple::parser::Parser p(tokens);
+    result.module = p.parse_module();
+    result.token_count = tokens.size();
+    parse_errors = p.error_count() != 0;
+  } else if (!result.from_cache) {
+    cimple::lexer::Lexer lexer(source.text());
+    cimple::parser::Parser p(lexer);
+    result.module = p.parse_module();
+    result.token_count = lexer.token_count();
+    parse_errors = p.error_count() != 0;
+  }
+  if (with_types)
+    result.types = cimple::semantic::infer_types(result.module);
+  if (use_cache && !parse_errors)
+    ast::save_cached_module(ast::cache_path(path), key, result.module,
+                            result.types ? &*result.types : nullptr);
+  return result;
+}
+
+void handle_build(const std::string &path) {
+  // simple pipeline: lex -> parse -> type inference -> report
+  auto source = load_source(path);
+  if (!source)
+    return;
+  auto front = parse_source(path, *source, /*with_types=*/true);
+  auto &module = front.module;
+  if (front.from_cache)
+    std::cout << "[cimple] Loaded cached AST from "
+              << cimple::ast::cache_path(path) << "\n";
+  else
+    std::cout << "[cimple] Lexed " << front.token_count << " tokens\n";
   std::cout << "[cimple] Parsed module: " << module.body.size()
             << " top-level statements\n";
 
-  auto env = cimple::semantic::infer_types(module);
+  auto &env = *front.types;
   std::cout << "[cimple] Inferred types:\n";
   for (auto &kv : env.vars) {
-    std::cout << "  var " << kv.first << " : "
+    std::cout << "  var " << cimple::lexer::symbol_name(kv.first) << " : "
               << cimple::semantic::type_to_string(kv.second) << "\n";
   }
   for (auto &kv : env.functions) {
-    std::cout << "  func " << kv.first << " -> "
+    std::cout << "  func " << cimple::lexer::symbol_name(kv.first) << " -> "
               << cimple::semantic::type_to_string(kv.second) << "\n";
   }
 
   // Run static type checking
   std::cout << "[cimple] Running type checker...\n";
   std::vector<std::string> type_errors;
-  if (!cimple::semantic::check_types(module, env, type_errors)) {
+  const cimple::diagnostics::LineTable lines(source->text());
+  if (!cimple::semantic::check_types(module, env, type_errors, &lines)) {
     std::cerr << "[cimple] Type checking failed:\n";
     for (const auto &error : type_errors) {
       std::cerr << "  ERROR: " << error << "\n";
@@ -117,36 +211,363 @@ void handle_build(const std::string &path) {
 // Old emit_and_link_with_clang function removed - replaced with LLVM backend
 // codegen
 
-void handle_run(const std::string &path) {
-  std::ifstream in(path);
-  if (!in.is_open()) {
-    std::cerr << "[cimple] Cannot open file: " << path << std::endl;
+// Tree-walking reference evaluator. `run_tests.py` treats its output as the
+// specification that the VM and the native backend must reproduce.
+static void run_tree_walk(cimple::parser::Module &module,
+                          const cimple::semantic::TypeEnv &env) {
+  // Build function table for evaluator
+  cimple::eval::FunctionTable functions;
+  for (auto &stmt : module.body) {
+    if (auto fn = cimple::parser::dyn_cast<cimple::parser::FuncDef>(stmt)) {
+      functions.define(fn);
+    }
+  }
+
+  // Execute top-level statements
+  cimple::eval::ValueEnv venv;
+  for (auto &stmt : module.body) {
+    cimple::eval::evaluate_stmt(stmt, env, venv, functions);
+  }
+}
+
+void handle_run(const std::string &path, bool tree_walk) {
+  auto source = load_source(path);
+  if (!source)
     return;
+  auto front = parse_source(path, *source, /*with_types=*/true);
+  auto &module = front.module;
+
+  if (!tree_walk) {
+    // The inferred types pick the initial quickened opcodes.
+    std::string error;
+    if (auto program =
+            cimple::eval::compile_program(module, &*front.types, &error)) {
+      cimple::eval::VM vm(*program);
+      vm.run();
+      return;
+    }
+    std::cerr << "[cimple] Bytecode compilation unavailable (" << error
+              << "); falling back to the tree-walking evaluator\n";
   }
-  std::ostringstream buf;
-  buf << in.rdbuf();
-  std::string source = buf.str();
+  run_tree_walk(module, *front.types);
+}
 
-  auto tokens = cimple::lexer::lex(source);
+void handle_disasm(const std::string &path) {
+  auto source = load_source(path);
+  if (!source)
+    return;
+  auto front = parse_source(path, *source, /*with_types=*/true);
+  auto &module = front.module;
+
+  std::string error;
+  auto program = cimple::eval::compile_program(module, &*front.types, &error);
+  if (!program) {
+    std::cerr << "[cimple] Bytecode compilation failed: " << error << "\n";
+    return;
+  }
+  std::cout << cimple::eval::disassemble(*program);
+}
+
+// ---------------------------------------------------------------------------
+// astbench: time the passes that exist for both AST forms (pointer tree and
+// ast::FlatAst) on one module. Each pass runs kBenchRuns times and the best
+// time is reported; the flat results are checked against the tree's.
+// ---------------------------------------------------------------------------
+
+namespace {
+
+constexpr int kBenchRuns = 5;
+
+template <typename F> double best_ms(F &&pass) {
+  double best = 0;
+  for (int i = 0; i < kBenchRuns; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    pass();
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (i == 0 || elapsed.count() < best)
+      best = elapsed.count();
+  }
+  return best;
+}
 
-  cimple::parser::Parser p(tokens);
+// Reads per variable: a whole-tree pass that looks at every expression.
+using UseCounts = std::vector<std::uint32_t>;
+
+void count_use(UseCounts &uses, cimple::lexer::SymbolId id) {
+  if (id >= uses.size())
+    uses.resize(id + 1);
+  ++uses[id];
+}
+
+class UseCounter : public cimple::ast::RecursiveVisitor<UseCounter> {
+public:
+  explicit UseCounter(UseCounts &uses) : uses_(uses) {}
+  void visit_var(const cimple::parser::VarRef *v) { count_use(uses_, v->id); }
+
+private:
+  UseCounts &uses_;
+};
+
+void report_pass(const char *name, double tree_ms, double flat_ms,
+                 bool same) {
+  std::printf("  %-12s tree %9.3f ms   flat %9.3f ms   %5.2fx%s\n", name,
+              tree_ms, flat_ms, flat_ms > 0 ? tree_ms / flat_ms : 0.0,
+              same ? "" : "   MISMATCH");
+}
+
+// Same nodes, operators, literals and offsets, compared via the flat forms.
+bool same_module(const cimple::parser::Module &x,
+                 const cimple::parser::Module &y) {
+  const cimple::ast::FlatAst a = cimple::ast::flatten(x);
+  const cimple::ast::FlatAst b = cimple::ast::flatten(y);
+  return a.kind == b.kind && a.op == b.op && a.a == b.a && a.b == b.b &&
+         a.first == b.first && a.offset == b.offset && a.lists == b.lists &&
+         a.ints == b.ints && a.floats == b.floats && a.text == b.text &&
+         a.module_body == b.module_body;
+}
+
+} // namespace
+
+// flat_infer_bench.cpp
+cimple::semantic::TypeEnv infer_types_flat(const cimple::ast::FlatAst &ast);
+
+void handle_astbench(const std::string &path) {
+  using namespace cimple;
+  auto source = load_source(path);
+  if (!source)
+    return;
+  lexer::Lexer lexer(source->text());
+  parser::Parser p(lexer);
   auto module = p.parse_module();
 
-  auto env = cimple::semantic::infer_types(module);
+  ast::FlatAst flat;
+  const double flatten_ms = best_ms([&] { flat = ast::flatten(module); });
+  std::printf("[cimple] %zu nodes: tree arena %zu KB, flat columns %zu KB\n",
+              flat.size(), module.arena.bytes_reserved() / 1024,
+              flat.bytes() / 1024);
+  std::printf("  %-12s %9.3f ms\n", "flatten", flatten_ms);
 
-  // Build function table for evaluator
-  std::unordered_map<std::string, cimple::parser::FuncDef *> functions;
-  for (auto &stmt : module.body) {
-    if (auto fn = dynamic_cast<cimple::parser::FuncDef *>(stmt.get())) {
-      functions[fn->name] = fn;
+  UseCounts tree_uses, flat_uses;
+  const double tree_walk_ms = best_ms([&] {
+    tree_uses.clear();
+    UseCounter counter(tree_uses);
+    counter.walk(module.body);
+  });
+  const double flat_walk_ms = best_ms([&] {
+    flat_uses.clear();
+    for (ast::NodeId n = 0; n < flat.size(); ++n)
+      if (flat.kind[n] == parser::NodeKind::VarRef)
+        count_use(flat_uses, flat.a[n]);
+  });
+  report_pass("var uses", tree_walk_ms, flat_walk_ms, tree_uses == flat_uses);
+
+  semantic::TypeEnv tree_env, flat_env;
+  const double tree_infer_ms =
+      best_ms([&] { tree_env = semantic::infer_types(module); });
+  const double flat_infer_ms =
+      best_ms([&] { flat_env = infer_types_flat(flat); });
+  report_pass("infer_types", tree_infer_ms, flat_infer_ms,
+              tree_env.vars == flat_env.vars &&
+                  tree_env.functions == flat_env.functions);
+}
+
+// ---------------------------------------------------------------------------
+// reparsebench: insert one line in the middle of a file and time reparsing
+// it from scratch against parser::IncrementalParser, which saw the file
+// before the edit. The two modules must be identical.
+// ---------------------------------------------------------------------------
+
+void handle_reparsebench(const std::string &path) {
+  using namespace cimple;
+  auto source = load_source(path);
+  if (!source)
+    return;
+  const std::string original(source->text());
+
+  // The first line past the middle that starts a top-level statement.
+  std::size_t at = original.find('\n', original.size() / 2);
+  while (at != std::string::npos) {
+    const char c = ++at < original.size() ? original[at] : '\n';
+    if (c != ' ' && c != '\t' && c != '\n' && c != '\r' && c != '#' &&
+        original.compare(at, 4, "elif") != 0 &&
+        original.compare(at, 4, "else") != 0)
+      break;
+    at = original.find('\n', at);
+  }
+  std::string edited = original;
+  if (at == std::string::npos) {
+    at = edited.size();
+    if (!edited.empty() && edited.back() != '\n')
+      edited.insert(at++, 1, '\n');
+  }
+  edited.insert(at, "reparse_bench_edit = 1\n");
+
+  parser::Module full;
+  const double full_ms = best_ms([&] {
+    lexer::Lexer lexer(edited);
+    parser::Parser p(lexer);
+    full = p.parse_module();
+  });
+  const double cold_ms = best_ms([&] {
+    parser::IncrementalParser incremental;
+    incremental.parse(edited);
+  });
+
+  double edit_ms = 0;
+  bool same = true;
+  parser::IncrementalParser::Stats stats;
+  for (int i = 0; i < kBenchRuns; ++i) {
+    parser::IncrementalParser incremental;
+    incremental.parse(original);
+    const auto start = std::chrono::steady_clock::now();
+    const parser::Module &module = incremental.parse(edited);
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (i == 0 || elapsed.count() < edit_ms)
+      edit_ms = elapsed.count();
+    stats = incremental.stats();
+    same = same && same_module(module, full);
+  }
+
+  std::printf("[cimple] %zu top-level spans; one line inserted at byte %zu\n",
+              stats.spans, at);
+  std::printf("  %-20s %9.3f ms\n", "full parse", full_ms);
+  std::printf("  %-20s %9.3f ms\n", "incremental, cold", cold_ms);
+  std::printf("  %-20s %9.3f ms   %zu of %zu spans reparsed%s\n",
+              "incremental, edit", edit_ms, stats.reparsed, stats.spans,
+              same ? "" : "   MISMATCH");
+}
+
+// ---------------------------------------------------------------------------
+// parsebench: time Parser::parse_module_parallel on one file at 1, 2, 4, ...
+// threads, up to the machine's core count but at least 8 so that small
+// machines still exercise several cuts. Every module must match the
+// one-thread parse.
+// ---------------------------------------------------------------------------
+
+void handle_parsebench(const std::string &path) {
+  using namespace cimple;
+  auto source = load_source(path);
+  if (!source)
+    return;
+  const std::vector<lexer::Token> tokens = lexer::lex_from_view(source->text());
+
+  parser::Module serial;
+  const double serial_ms = best_ms([&] {
+    parser::Parser p(tokens);
+    serial = p.parse_module_parallel(1);
+  });
+  std::printf("[cimple] %zu tokens, %zu top-level statements\n",
+              tokens.size(), serial.body.size());
+  std::printf("  %2u thread  %9.3f ms\n", 1u, serial_ms);
+
+  const unsigned cores = std::max(8u, std::thread::hardware_concurrency());
+  for (unsigned threads = 2; threads <= cores; threads *= 2) {
+    parser::Module module;
+    const double ms = best_ms([&] {
+      parser::Parser p(tokens);
+      module = p.parse_module_parallel(threads);
+    });
+    std::printf("  %2u threads %9.3f ms   %5.2fx%s\n", threads, ms,
+                ms > 0 ? serial_ms / ms : 0.0,
+                same_module(module, serial) ? "" : "   MISMATCH");
+  }
+}
+
+// ---------------------------------------------------------------------------
+// lexcheck: lex one file with lexer::lex_parallel at each of the given chunk
+// counts (2, 3 and 7 by default) and compare the tokens with the sequential
+// Lexer's, field by field. lex_from_view only takes the parallel path for
+// large sources on multicore machines; this reaches it on any file.
+// ---------------------------------------------------------------------------
+
+namespace {
+
+bool same_token(const cimple::lexer::Token &x, const cimple::lexer::Token &y) {
+  return x.type == y.type && x.kind == y.kind && x.sym == y.sym &&
+         x.offset == y.offset && x.lexeme() == y.lexeme();
+}
+
+} // namespace
+
+void handle_lexcheck(const std::string &path,
+                     const std::vector<unsigned> &chunk_counts) {
+  using namespace cimple;
+  auto source = load_source(path);
+  if (!source)
+    return;
+
+  std::vector<lexer::Token> serial;
+  lexer::Lexer lexer(source->text());
+  do
+    serial.push_back(lexer.next());
+  while (serial.back().type != lexer::TokenType::ENDMARKER);
+  std::printf("[cimple] %zu tokens\n", serial.size());
+
+  for (unsigned chunks : chunk_counts) {
+    const std::vector<lexer::Token> tokens =
+        lexer::lex_parallel(source->text(), chunks);
+    std::size_t i = 0;
+    while (i < tokens.size() && i < serial.size() &&
+           same_token(tokens[i], serial[i]))
+      ++i;
+    if (i == tokens.size() && i == serial.size()) {
+      std::printf("  %2u chunks  ok\n", chunks);
+      continue;
     }
+    std::printf("  %2u chunks  MISMATCH at token %zu", chunks, i);
+    if (i < tokens.size() && i < serial.size())
+      std::printf(": '%.*s' at byte %u, expected '%.*s' at byte %u",
+                  static_cast<int>(tokens[i].length), tokens[i].text,
+                  tokens[i].offset, static_cast<int>(serial[i].length),
+                  serial[i].text, serial[i].offset);
+    else
+      std::printf(": %zu tokens, expected %zu", tokens.size(), serial.size());
+    std::printf("\n");
   }
+}
 
-  // Execute top-level statements
-  cimple::eval::ValueEnv venv;
-  for (auto &stmt : module.body) {
-    cimple::eval::evaluate_stmt(stmt.get(), env, venv, functions);
+// ---------------------------------------------------------------------------
+// cachecheck: parse one file and infer its types, save both to a temporary
+// .cimpc, load it back and compare with what was saved. build, run and
+// disasm go through this load on every cache hit.
+// ---------------------------------------------------------------------------
+
+void handle_cachecheck(const std::string &path) {
+  using namespace cimple;
+  auto source = load_source(path);
+  if (!source)
+    return;
+  lexer::Lexer lexer(source->text());
+  parser::Parser p(lexer);
+  const parser::Module module = p.parse_module();
+  const semantic::TypeEnv types = semantic::infer_types(module);
+
+  const std::string tmp =
+      (std::filesystem::temp_directory_path() /
+       ("cimple-cachecheck-" + std::to_string(std::random_device{}()) +
+        ".cimpc"))
+          .string();
+  const ast::CacheKey key =
+      ast::make_cache_key(source->text(), kFrontEndOptions);
+  if (!ast::save_cached_module(tmp, key, module, &types)) {
+    std::printf("  save     MISMATCH: cannot write %s\n", tmp.c_str());
+    return;
   }
+  auto loaded = ast::load_cached_module(tmp, key);
+  std::remove(tmp.c_str());
+  std::printf("[cimple] %zu top-level statements\n", module.body.size());
+  if (!loaded) {
+    std::printf("  load     MISMATCH: the saved cache was rejected\n");
+    return;
+  }
+  const bool same_types = loaded->types &&
+                          loaded->types->vars == types.vars &&
+                          loaded->types->functions == types.functions;
+  std::printf("  module   %s\n",
+              same_module(loaded->module, module) ? "ok" : "MISMATCH");
+  std::printf("  types    %s\n", same_types ? "ok" : "MISMATCH");
 }
 
 void handle_cli(int argc, char **argv) {
@@ -155,8 +576,22 @@ void handle_cli(int argc, char **argv) {
     std::cout << "Commands:\n";
     std::cout
         << "  build <file>     Compile to native binary (requires LLVM)\n";
-    std::cout << "  run <file>       Run via interpreter (no LLVM needed)\n";
+    std::cout << "  run <file>       Run via bytecode VM (no LLVM needed)\n";
+    std::cout << "      --tree-walk  Use the reference tree-walking evaluator\n";
     std::cout << "  lexparse <file>  Debug: lex and parse only\n";
+    std::cout << "  disasm <file>    Debug: dump compiled bytecode\n";
+    std::cout << "  astbench <file>  Debug: time passes on the pointer vs "
+                 "flat AST\n";
+    std::cout << "  reparsebench <file>  Debug: time an incremental reparse "
+                 "after a one-line edit\n";
+    std::cout << "  parsebench <file>  Debug: time parsing on 1, 2, 4, ... "
+                 "threads\n";
+    std::cout << "  lexcheck <file> [chunks...]  Debug: check the parallel "
+                 "lexer against the sequential one\n";
+    std::cout << "  cachecheck <file>  Debug: check that the AST cache "
+                 "loads back what it saved\n";
+    std::cout << "build, run and disasm cache the parsed AST in "
+                 "<file>.cimpc;\nset CIMPLE_NO_CACHE=1 to disable it.\n";
     return;
   }
 
@@ -168,11 +603,13 @@ void handle_cli(int argc, char **argv) {
     }
     handle_build(argv[2]);
   } else if (cmd == "run") {
-    if (argc < 3) {
-      std::cout << "Usage: cimple run <file.cimp>\n";
+    bool tree_walk = argc >= 3 && std::string(argv[2]) == "--tree-walk";
+    int file_arg = tree_walk ? 3 : 2;
+    if (argc <= file_arg) {
+      std::cout << "Usage: cimple run [--tree-walk] <file.cimp>\n";
       return;
     }
-    handle_run(argv[2]);
+    handle_run(argv[file_arg], tree_walk);
   } else if (cmd == "lexparse" || cmd == "debug-lexparse") {
     if (argc < 3) {
       std::cout << "Usage: cimple lexparse <file.cimp>\n";
@@ -180,6 +617,48 @@ void handle_cli(int argc, char **argv) {
     }
     extern int lex_and_parse_file(const std::string &);
     lex_and_parse_file(argv[2]);
+  } else if (cmd == "disasm") {
+    if (argc < 3) {
+      std::cout << "Usage: cimple disasm <file.cimp>\n";
+      return;
+    }
+    handle_disasm(argv[2]);
+  } else if (cmd == "astbench") {
+    if (argc < 3) {
+      std::cout << "Usage: cimple astbench <file.cimp>\n";
+      return;
+    }
+    handle_astbench(argv[2]);
+  } else if (cmd == "reparsebench") {
+    if (argc < 3) {
+      std::cout << "Usage: cimple reparsebench <file.cimp>\n";
+      return;
+    }
+    handle_reparsebench(argv[2]);
+  } else if (cmd == "parsebench") {
+    if (argc < 3) {
+      std::cout << "Usage: cimple parsebench <file.cimp>\n";
+      return;
+    }
+    handle_parsebench(argv[2]);
+  } else if (cmd == "lexcheck") {
+    if (argc < 3) {
+      std::cout << "Usage: cimple lexcheck <file.cimp> [chunks...]\n";
+      return;
+    }
+    std::vector<unsigned> chunk_counts;
+    for (int i = 3; i < argc; ++i)
+      chunk_counts.push_back(
+          static_cast<unsigned>(std::strtoul(argv[i], nullptr, 10)));
+    if (chunk_counts.empty())
+      chunk_counts = {2, 3, 7};
+    handle_lexcheck(argv[2], chunk_counts);
+  } else if (cmd == "cachecheck") {
+    if (argc < 3) {
+      std::cout << "Usage: cimple cachecheck <file.cimp>\n";
+      return;
+    }
+    handle_cachecheck(argv[2]);
   } else {
     std::cout << "Unknown command: " << cmd << "\n";
   }
@@ -0,0 +1,210 @@
+// flat_infer_bench.cpp - type inference over ast::FlatAst, for astbench
+//
+// The compiler infers types on the pointer tree (semantic::infer_types).
+// This is the same inference over the module's flat form, kept with the
+// benchmark that compares the two: statements are walked in order as there,
+// and an expression is typed by one forward sweep over its post-order row
+// range, each row reading its children's types from a scratch array.
+#include "frontend/ast/flat_ast.h"
+#include "frontend/semantic/scope_stack.h"
+#include "frontend/semantic/type_infer.h"
+#include <unordered_map>
+#include <vector>
+
+using namespace cimple;
+using namespace cimple::semantic;
+
+namespace {
+
+using TypeScope = ScopeStack<TypeKind, lexer::SymbolId>;
+
+class FlatInference {
+public:
+  FlatInference(const ast::FlatAst &ast,
+                std::unordered_map<lexer::SymbolId, TypeKind> &functions)
+      : ast_(ast), functions_(functions) {}
+
+  TypeKind expr(ast::NodeId root, const TypeScope &vars) {
+    if (root == ast::kNoNode)
+      return TypeKind::Unknown;
+    const ast::NodeId first = ast_.first[root];
+    types_.resize(root - first + 1);
+    TypeKind *types = types_.data() - first; // indexed by NodeId
+
+    for (ast::NodeId n = first; n <= root; ++n) {
+      const std::uint32_t a = ast_.a[n];
+      const std::uint32_t b = ast_.b[n];
+      TypeKind t = TypeKind::Unknown;
+      switch (ast_.kind[n]) {
+      case parser::NodeKind::NumberLiteral:
+        t = (ast_.op[n] & 1) == parser::NumberLiteral::Float ? TypeKind::Float
+                                                            : TypeKind::Int;
+        break;
+      case parser::NodeKind::StringLiteral:
+        t = TypeKind::String;
+        break;
+      case parser::NodeKind::BoolLiteral:
+      case parser::NodeKind::LogicalExpr:
+      case parser::NodeKind::CompareChain:
+        t = TypeKind::Bool;
+        break;
+      case parser::NodeKind::VarRef:
+        if (const auto *found = vars.lookup(a))
+          t = *found;
+        break;
+      case parser::NodeKind::UnaryOp:
+        t = unary_type(static_cast<parser::UnOpKind>(ast_.op[n]), types[a]);
+        break;
+      case parser::NodeKind::BinaryOp:
+        t = binary_type(static_cast<parser::BinOpKind>(ast_.op[n]), types[a],
+                        types[b]);
+        break;
+      case parser::NodeKind::CallExpr:
+        if (ast_.kind[a] == parser::NodeKind::VarRef) {
+          const lexer::SymbolId callee = ast_.a[a];
+          if (callee == lexer::sym::print) {
+            t = TypeKind::Void;
+          } else {
+            auto it = functions_.find(callee);
+            if (it != functions_.end())
+              t = it->second;
+          }
+        }
+        break;
+      default:
+        break;
+      }
+      types[n] = t;
+    }
+    return types[root];
+  }
+
+  TypeKind block(ast::ListRef body, TypeScope &vars) {
+    TypeKind ret = TypeKind::Void;
+    for (ast::NodeId s : body)
+      ret = unify(ret, stmt(ast_.node(s), vars));
+    return ret;
+  }
+
+  TypeKind stmt(ast::NodeRef s, TypeScope &vars) {
+    switch (s.kind()) {
+    case parser::NodeKind::AssignStmt: {
+      TypeKind rhs = expr(s.value().id(), vars);
+      if (auto *current = vars.lookup_current_mut(s.symbol())) {
+        *current = unify(*current, rhs);
+      } else {
+        vars.set_local(s.symbol(), rhs);
+      }
+      return TypeKind::Void;
+    }
+
+    case parser::NodeKind::ExprStmt:
+      expr(s.expr().id(), vars);
+      return TypeKind::Void;
+
+    case parser::NodeKind::ReturnStmt:
+      return expr(s.value().id(), vars);
+
+    case parser::NodeKind::IfStmt: {
+      const ast::ListRef conditions = s.conditions();
+      const ast::ListRef bodies = s.bodies();
+      TypeKind branches_ret = TypeKind::Void;
+      for (std::size_t i = 0; i < conditions.size(); ++i) {
+        expr(conditions[i], vars);
+        vars.push_scope(TypeScope::ScopeKind::Block);
+        branches_ret = unify(branches_ret, block(ast_.list(bodies[i]), vars));
+        vars.pop_scope();
+      }
+      return branches_ret;
+    }
+
+    case parser::NodeKind::WhileStmt: {
+      expr(s.condition().id(), vars);
+      vars.push_scope(TypeScope::ScopeKind::Block);
+      TypeKind body_ret = block(s.body(), vars);
+      vars.pop_scope();
+      return body_ret;
+    }
+
+    default:
+      return TypeKind::Void;
+    }
+  }
+
+private:
+  const ast::FlatAst &ast_;
+  std::unordered_map<lexer::SymbolId, TypeKind> &functions_;
+  std::vector<TypeKind> types_; // scratch for expr()
+};
+
+TypeKind function_return(
+    const ast::FlatAst &ast, ast::NodeId fn,
+    const std::unordered_map<lexer::SymbolId, TypeKind> &global_vars,
+    std::unordered_map<lexer::SymbolId, TypeKind> &functions) {
+  TypeScope local;
+  for (const auto &kv : global_vars) {
+    local.set_global(kv.first, kv.second);
+  }
+  local.push_scope(TypeScope::ScopeKind::Function);
+  const ast::NodeRef def = ast.node(fn);
+  for (lexer::SymbolId param : def.params()) {
+    local.set_local(param, TypeKind::Unknown);
+  }
+  FlatInference infer(ast, functions);
+  TypeKind ret = infer.block(def.body(), local);
+  local.pop_scope();
+  return ret;
+}
+
+void global_statements(
+    const ast::FlatAst &ast, TypeScope &globals,
+    std::unordered_map<lexer::SymbolId, TypeKind> &functions) {
+  FlatInference infer(ast, functions);
+  for (ast::NodeId s : ast.body())
+    if (ast.kind[s] != parser::NodeKind::FuncDef)
+      infer.stmt(ast.node(s), globals);
+}
+
+} // namespace
+
+// The TypeEnv semantic::infer_types gives for the module `ast` was flattened
+// from, by the same steps.
+TypeEnv infer_types_flat(const ast::FlatAst &ast) {
+  TypeEnv env;
+
+  std::vector<ast::NodeId> function_defs;
+  for (ast::NodeId s : ast.body()) {
+    if (ast.kind[s] == parser::NodeKind::FuncDef) {
+      env.functions[ast.node(s).symbol()] = TypeKind::Unknown;
+      function_defs.push_back(s);
+    }
+  }
+
+  TypeScope globals;
+  global_statements(ast, globals, env.functions);
+  env.vars = globals.global_values();
+
+  bool changed = true;
+  std::size_t iterations = 0;
+  const std::size_t max_iterations = function_defs.size() + 2;
+  while (changed && iterations < max_iterations) {
+    changed = false;
+    ++iterations;
+
+    for (ast::NodeId fn : function_defs) {
+      TypeKind inferred = function_return(ast, fn, env.vars, env.functions);
+      TypeKind &slot = env.functions[ast.node(fn).symbol()];
+      TypeKind merged = unify(slot, inferred);
+      if (merged != slot) {
+        slot = merged;
+        changed = true;
+      }
+    }
+  }
+
+  globals = TypeScope();
+  global_statements(ast, globals, env.functions);
+  env.vars = globals.global_values();
+
+  return env;
+}
@@ -1,24 +1,21 @@
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include "frontend/lexer/lexer.h"
 #include "frontend/lexer/token_utils.h"
 #include "frontend/parser/parser.h"
+#include "utils/file_loader.h"
 
 int lex_and_parse_file(const std::string& path) {
-    std::ifstream in(path);
-    if (!in.is_open()) {
+    auto src = cimple::utils::SourceBuffer::open(path);
+    if (!src) {
         std::cerr << "Cannot open file: " << path << std::endl;
         return 1;
     }
-    std::ostringstream buf;
-    buf << in.rdbuf();
-    std::string src = buf.str();
 
-    auto tokens = cimple::lexer::lex(src);
+    auto tokens = cimple::lexer::lex_from_view(src->text());
+    const cimple::diagnostics::LineTable lines(src->text());
     std::cout << "Tokens:\n";
     for (auto &t: tokens) {
-        std::cout << cimple::lexer::token_to_string(t) << "\n";
+        std::cout << cimple::lexer::token_to_string(t, lines) << "\n";
     }
 
     cimple::parser::Parser p(tokens);